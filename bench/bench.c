@@ -0,0 +1,666 @@
+/*******************************************************************************
+ *  bench.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Benchmarks for libmuzz.  Each one runs over a synthetic data set and prints
+ *  a line of JSON:  what it was, how many records, and how fast.  There are
+ *  three stages, timed separately:
+ *
+ *      parse.*     Text to numbers
+ *      compute.*   The formulas, one call per record (scalar) and over whole
+ *                  arrays with whichever kernels were picked (see MUZZ_ISA),
+ *                  then with the fast ones (e.g. "compute.mass.avx2-fast")
+ *      format.*    Results to text (and CSV, through a template)
+ *
+ *  Before those, a line per formula and units on how far the fast kernels
+ *  land from the reference, and whether plans may use them, and then the
+ *  same for the fixed-point formulas (muzzfix.h), which are also timed
+ *  ("compute.energy.fixed").
+ *
+ *  A data set is at most POOL_MAX distinct records; bigger runs go over the
+ *  same ones again, so 100M records doesn't need gigabytes of memory.
+ *
+ *  Usage:  muzz-bench [RECORDS ...]
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "muzz.h"
+#include "muzzfix.h"
+#include "format.h"
+
+
+/*  Default number of records per benchmark */
+#define DEFAULT_RECORDS 1000000
+
+/*  Most distinct records in a data set */
+#define POOL_MAX ( 1024 * 1024 )
+
+/*  Shots the fast kernels are checked over */
+#define ACCURACY_SAMPLES 1000000
+
+
+/*  A column of numbers written out as text, the way they'd be in a file */
+typedef struct text_column {
+    char *text;             //  All the numbers, each followed by a '\0'
+    size_t *offsets;        //  Where each one starts
+    size_t *lengths;
+    size_t bytes;           //  Total characters, not counting terminators
+} text_column;
+
+
+/*  A column of numbers */
+/*  Keeps the compiler from throwing away results we never look at */
+static volatile double sink;
+
+
+
+/*==============================================================================
+                                      NOW
+--------------------------------------------------------------------------------
+*   Returns the time in seconds, from some arbitrary point.
+*/
+static double now( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( ts.tv_sec + ts.tv_nsec / 1e9 );
+}
+
+
+
+/*==============================================================================
+                                     REPORT
+--------------------------------------------------------------------------------
+*   Prints the result of one benchmark as a line of JSON.
+*
+*   Params
+*       const char *name    |   What we measured
+*       size_t records      |   How many records it went through
+*       size_t bytes        |   How many bytes of text it read or wrote, or 0
+*       double seconds      |   How long it took
+*/
+static void report( const char *name, size_t records, size_t bytes,
+        double seconds )
+{
+    if( seconds <= 0 )
+        seconds = 1e-9;
+
+    printf( "{\"bench\":\"%s\",\"records\":%zu,\"seconds\":%.6f,"
+            "\"ns_per_record\":%.3f,\"records_per_sec\":%.0f,"
+            "\"bytes_per_sec\":%.0f}\n",
+            name, records, seconds, seconds * 1e9 / records,
+            records / seconds, bytes / seconds );
+    fflush( stdout );
+}
+
+
+
+/*==============================================================================
+                                  MAKE COLUMN
+--------------------------------------------------------------------------------
+*   Makes up n numbers between lo and hi and writes them out as text with the
+*   given number of decimals.  Exits if we're out of memory.
+*/
+static void make_column( text_column *col, size_t n, double lo, double hi,
+        int decimals )
+{
+    size_t i;
+    size_t used = 0;
+    int len;
+
+    col->text = malloc( n * 32 );
+    col->offsets = malloc( n * sizeof( size_t ));
+    col->lengths = malloc( n * sizeof( size_t ));
+    if( col->text == NULL || col->offsets == NULL || col->lengths == NULL )
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        exit( 1 );
+    }
+
+    for( i = 0; i < n; ++i )
+    {
+        double x = lo + ( hi - lo ) * ( rand() / (double)RAND_MAX );
+
+        len = snprintf( col->text + used, 32, "%.*f", decimals, x );
+        col->offsets[i] = used;
+        col->lengths[i] = len;
+        used += len + 1;
+    }
+
+    col->bytes = used - n;
+}
+
+
+
+/*==============================================================================
+                                  MAKE NUMBERS
+--------------------------------------------------------------------------------
+*   Makes up n numbers between lo and hi.  Exits if we're out of memory.
+*/
+static double *make_numbers( size_t n, double lo, double hi )
+{
+    double *nums = malloc( n * sizeof( double ));
+    size_t i;
+
+    if( nums == NULL )
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        exit( 1 );
+    }
+
+    for( i = 0; i < n; ++i )
+        nums[i] = lo + ( hi - lo ) * ( rand() / (double)RAND_MAX );
+
+    return( nums );
+}
+
+
+
+/*==============================================================================
+                                   POOL SIZE
+--------------------------------------------------------------------------------
+*   How many distinct records to make up for a run of n.
+*/
+static size_t pool_size( size_t n )
+{
+    return( n < POOL_MAX ? n : POOL_MAX );
+}
+
+
+
+/*==============================================================================
+                                  FREE COLUMN
+--------------------------------------------------------------------------------
+*/
+static void free_column( text_column *col )
+{
+    free( col->text );
+    free( col->offsets );
+    free( col->lengths );
+}
+
+
+
+/*==============================================================================
+                                  BENCH PARSE
+--------------------------------------------------------------------------------
+*   Number parsing:  muzz_parse_double() against strtod(), over the same text.
+*/
+static void bench_parse( size_t n )
+{
+    size_t pool = pool_size( n );
+    text_column col;
+    double sum;
+    double t;
+    double x;
+    size_t bytes;
+    size_t i;
+    size_t j;
+
+    make_column( &col, pool, 100, 4000, 2 );
+    bytes = col.bytes / pool * n;
+
+    sum = 0;
+    t = now();
+    for( i = j = 0; i < n; ++i, j = ( j + 1 == pool ? 0 : j + 1 ))
+        sum += strtod( col.text + col.offsets[j], NULL );
+    t = now() - t;
+    sink = sum;
+    report( "parse.strtod", n, bytes, t );
+
+    sum = 0;
+    t = now();
+    for( i = j = 0; i < n; ++i, j = ( j + 1 == pool ? 0 : j + 1 ))
+    {
+        muzz_parse_double( col.text + col.offsets[j], col.lengths[j], &x );
+        sum += x;
+    }
+    t = now() - t;
+    sink = sum;
+    report( "parse.muzz", n, bytes, t );
+
+    free_column( &col );
+}
+
+
+
+/*==============================================================================
+                                 BENCH COMPUTE
+--------------------------------------------------------------------------------
+*   The formulas, Imperial:  a call per record, then whole arrays at a time.
+*/
+static void bench_compute( size_t n )
+{
+    size_t pool = pool_size( n );
+    double *mass = make_numbers( pool, 100, 500 );
+    double *velocity = make_numbers( pool, 600, 3500 );
+    double *energy = make_numbers( pool, 100, 3000 );
+    double *diameter = make_numbers( pool, .22, .50 );
+    double *ko = make_numbers( pool, 5, 60 );
+    double *out = make_numbers( pool, 0, 0 );
+    char name[ 64 ];
+    muzz_plan plan;
+    muzz_ctx ctx;
+    double sum;
+    double t;
+    size_t done;
+    size_t len;
+    size_t i;
+    size_t j;
+
+    muzz_ctx_init( &ctx );
+    muzz_ctx_resolve( &ctx );
+
+    /*  One call per record; bytes are the numbers read and written */
+    #define SCALAR( NAME, COLS, CALL ) \
+        sum = 0; \
+        t = now(); \
+        for( i = j = 0; i < n; ++i, j = ( j + 1 == pool ? 0 : j + 1 )) \
+            sum += CALL; \
+        t = now() - t; \
+        sink = sum; \
+        report( "compute." NAME ".scalar", n, n * COLS * sizeof( double ), t )
+
+    SCALAR( "energy", 3, muzz_get_energy( &ctx, mass[j], velocity[j] ));
+    SCALAR( "mass", 3, muzz_get_mass( &ctx, velocity[j], energy[j] ));
+    SCALAR( "velocity", 3, muzz_get_velocity( &ctx, mass[j], energy[j] ));
+    SCALAR( "tkof", 4, muzz_tkof( &ctx, mass[j], velocity[j], diameter[j] ));
+    SCALAR( "tkof-velocity", 4, muzz_tkof_velocity( &ctx, mass[j],
+                diameter[j], ko[j] ));
+    #undef SCALAR
+
+    /*  Whole arrays, a pool at a time */
+    #define ARRAY( NAME, COLS, CALL ) \
+        t = now(); \
+        for( done = 0; done < n; done += len ) \
+        { \
+            len = ( n - done < pool ? n - done : pool ); \
+            CALL; \
+        } \
+        t = now() - t; \
+        sink = out[ 0 ]; \
+        snprintf( name, sizeof( name ), "compute." NAME ".%s", \
+                muzz_kernel_isa() ); \
+        report( name, n, n * COLS * sizeof( double ), t )
+
+    ARRAY( "energy", 3, muzz_get_energy_n( &ctx, mass, velocity, out, len ));
+    ARRAY( "mass", 3, muzz_get_mass_n( &ctx, velocity, energy, out, len ));
+    ARRAY( "velocity", 3, muzz_get_velocity_n( &ctx, mass, energy, out, len ));
+    ARRAY( "tkof", 4, muzz_tkof_n( &ctx, mass, velocity, diameter, out, len ));
+    ARRAY( "tkof-velocity", 4, muzz_tkof_velocity_n( &ctx, mass, diameter, ko,
+                out, len ));
+    #undef ARRAY
+
+    /*  The fast kernels, through a plan, the way batch mode runs them */
+    #define FAST( NAME, SOLVE, COLS, A, B, C ) \
+        ctx.solve = SOLVE; \
+        muzz_plan_init( &plan, &ctx ); \
+        t = now(); \
+        for( done = 0; done < n; done += len ) \
+        { \
+            len = ( n - done < pool ? n - done : pool ); \
+            muzz_plan_run( &plan, A, B, C, out, len ); \
+        } \
+        t = now() - t; \
+        sink = out[ 0 ]; \
+        snprintf( name, sizeof( name ), "compute." NAME ".%s", plan.isa ); \
+        report( name, n, n * COLS * sizeof( double ), t )
+
+    ctx.fast = 1;
+    FAST( "energy", MUZZ_SOLVE_ENERGY, 3, mass, velocity, NULL );
+    FAST( "mass", MUZZ_SOLVE_MASS, 3, velocity, energy, NULL );
+    FAST( "velocity", MUZZ_SOLVE_VELOCITY, 3, mass, energy, NULL );
+    FAST( "tkof", MUZZ_SOLVE_TKOF, 4, mass, velocity, diameter );
+    FAST( "tkof-velocity", MUZZ_SOLVE_TKOF_VELOCITY, 4, mass, diameter, ko );
+    #undef FAST
+
+    free( mass );
+    free( velocity );
+    free( energy );
+    free( diameter );
+    free( ko );
+    free( out );
+}
+
+
+
+/*==============================================================================
+                                 BENCH ACCURACY
+--------------------------------------------------------------------------------
+*   How far the fast kernels are from the reference, for every formula in both
+*   units, over a bigger sample than a plan checks before it uses them.
+*/
+static void bench_accuracy( void )
+{
+    muzz_accuracy acc;
+    muzz_ctx ctx;
+    int solve;
+    int si;
+
+    for( si = 0; si < 2; ++si )
+        for( solve = MUZZ_SOLVE_MASS; solve <= MUZZ_SOLVE_TKOF_VELOCITY;
+                ++solve )
+        {
+            muzz_ctx_init( &ctx );
+            ctx.si = si;
+            ctx.solve = solve;
+            muzz_ctx_resolve( &ctx );
+
+            muzz_fast_check( &ctx, ACCURACY_SAMPLES, &acc );
+            printf( "{\"accuracy\":\"%s\",\"isa\":\"%s\",\"samples\":%zu,"
+                    "\"max_ulp\":%.0f,\"max_rel\":%.3g,\"max_abs\":%.3g,"
+                    "\"allowed\":%s}\n", acc.name, acc.isa, acc.samples,
+                    acc.maxUlp, acc.maxRel, acc.maxAbs,
+                    ( acc.allowed ? "true" : "false" ));
+        }
+    fflush( stdout );
+}
+
+
+
+/*==============================================================================
+                                  FIXED SOLVE
+--------------------------------------------------------------------------------
+*   The fixed-point formula for a solve mode, over its inputs in command line
+*   order.
+*/
+static muzz_fix fixed_solve( const muzz_fix_ctx *f, int solve,
+        const muzz_fix *x )
+{
+    switch( solve )
+    {
+        case MUZZ_SOLVE_MASS:       return( muzz_fix_mass( f, x[0], x[1] ));
+        case MUZZ_SOLVE_VELOCITY:   return( muzz_fix_velocity( f, x[0], x[1] ));
+        case MUZZ_SOLVE_TKOF:
+            return( muzz_fix_tkof( f, x[0], x[1], x[2] ));
+        case MUZZ_SOLVE_TKOF_MASS:
+            return( muzz_fix_tkof_mass( f, x[0], x[1], x[2] ));
+        case MUZZ_SOLVE_TKOF_VELOCITY:
+            return( muzz_fix_tkof_velocity( f, x[0], x[1], x[2] ));
+        default:                    return( muzz_fix_energy( f, x[0], x[1] ));
+    }
+}
+
+
+
+/*==============================================================================
+                              BENCH FIXED ACCURACY
+--------------------------------------------------------------------------------
+*   How far the fixed-point formulas are from the double ones, for every
+*   formula in both units.  Shots are drawn from the same ranges the fast
+*   kernels are checked over, and rounded to thousandths first (energy and
+*   TKOF from the shot's mass and velocity), so both get the same inputs.
+*/
+static void bench_fixed_accuracy( void )
+{
+    static const char *names[] = { "mass", "velocity", "energy", "tkof",
+        "tkof-mass", "tkof-velocity" };
+    double lo[3][2] = { { 1, .065 }, { 100, 30 }, { .1, 2.5 }};
+    double hi[3][2] = { { 1000, 65 }, { 5000, 1500 }, { 1, 25 }};
+    double shot[5];
+    double nums[3];
+    muzz_fix x[3];
+    muzz_fix_ctx f;
+    muzz_shot s;
+    muzz_ctx ctx;
+    double maxAbs;
+    double maxRel;
+    double want;
+    double err;
+    size_t i;
+    int solve;
+    int si;
+    int d;
+
+    for( si = 0; si < 2; ++si )
+        for( solve = MUZZ_SOLVE_MASS; solve <= MUZZ_SOLVE_TKOF_VELOCITY;
+                ++solve )
+        {
+            muzz_ctx_init( &ctx );
+            ctx.si = si;
+            ctx.solve = solve;
+            muzz_ctx_resolve( &ctx );
+            muzz_fix_init( &f );
+            f.si = si;
+            muzz_fix_resolve( &f );
+
+            maxAbs = maxRel = 0;
+            for( i = 0; i < ACCURACY_SAMPLES; ++i )
+            {
+                /*  Mass, velocity, diameter, then energy and TKOF */
+                for( d = 0; d < 3; ++d )
+                    shot[d] = round( ( lo[d][si] + ( hi[d][si] - lo[d][si] )
+                                * ( rand() / (double)RAND_MAX )) * 1000 )
+                        / 1000;
+                shot[3] = round( muzz_get_energy( &ctx, shot[0], shot[1] )
+                        * 1000 ) / 1000;
+                shot[4] = round( muzz_tkof( &ctx, shot[0], shot[1], shot[2] )
+                        * 1000 ) / 1000;
+
+                /*  What this mode takes, in command line order */
+                switch( solve )
+                {
+                    case MUZZ_SOLVE_MASS:
+                        nums[0] = shot[1]; nums[1] = shot[3];           break;
+                    case MUZZ_SOLVE_VELOCITY:
+                        nums[0] = shot[0]; nums[1] = shot[3];           break;
+                    case MUZZ_SOLVE_ENERGY:
+                        nums[0] = shot[0]; nums[1] = shot[1];           break;
+                    case MUZZ_SOLVE_TKOF:
+                        nums[0] = shot[0]; nums[1] = shot[1];
+                        nums[2] = shot[2];                              break;
+                    case MUZZ_SOLVE_TKOF_MASS:
+                        nums[0] = shot[1]; nums[1] = shot[2];
+                        nums[2] = shot[4];                              break;
+                    default:
+                        nums[0] = shot[0]; nums[1] = shot[2];
+                        nums[2] = shot[4];                              break;
+                }
+
+                /*  A TKOF that rounds to 0 has no mass or velocity */
+                if( nums[ muzz_inputs( &ctx ) - 1 ] <= 0 )
+                    continue;
+
+                for( d = 0; d < 3; ++d )
+                    x[d] = (muzz_fix)llround( nums[d] * MUZZ_FIX_ONE );
+
+                muzz_shot_set( &ctx, &s, nums );
+                want = *muzz_shot_wanted( &ctx, &s );
+                err = fabs( fixed_solve( &f, solve, x ) / 1000.0 - want );
+
+                if( err > maxAbs )
+                    maxAbs = err;
+                if( err / want > maxRel )
+                    maxRel = err / want;
+            }
+
+            printf( "{\"accuracy\":\"%s-%s\",\"isa\":\"fixed\","
+                    "\"samples\":%d,\"max_rel\":%.3g,\"max_abs\":%.3g}\n",
+                    names[ solve ], ( si ? "si" : "imperial" ),
+                    ACCURACY_SAMPLES, maxRel, maxAbs );
+        }
+    fflush( stdout );
+}
+
+
+
+/*==============================================================================
+                                  BENCH FIXED
+--------------------------------------------------------------------------------
+*   The fixed-point formulas, Imperial, a call per record.
+*/
+static void bench_fixed( size_t n )
+{
+    size_t pool = pool_size( n );
+    muzz_fix *cols[ 5 ];
+    double lo[5] = { 100, 600, 100, 220, 5000 };
+    double hi[5] = { 500, 3500, 3000, 500, 60000 };
+    muzz_fix_ctx f;
+    uint64_t sum;
+    double t;
+    size_t i;
+    size_t j;
+    int c;
+
+    for( c = 0; c < 5; ++c )
+    {
+        cols[c] = malloc( pool * sizeof( muzz_fix ));
+        if( cols[c] == NULL )
+        {
+            fprintf( stderr, "ERROR:  Out of memory\n" );
+            exit( 1 );
+        }
+
+        for( j = 0; j < pool; ++j )
+            cols[c][j] = ( lo[c] + ( hi[c] - lo[c] )
+                    * ( rand() / (double)RAND_MAX )) * MUZZ_FIX_ONE;
+    }
+
+    muzz_fix_init( &f );
+
+    /*  Mass, velocity, energy, diameter and TKOF, in thousandths */
+    #define FIXED( NAME, COLS, CALL ) \
+        sum = 0; \
+        t = now(); \
+        for( i = j = 0; i < n; ++i, j = ( j + 1 == pool ? 0 : j + 1 )) \
+            sum += CALL; \
+        t = now() - t; \
+        sink = sum; \
+        report( "compute." NAME ".fixed", n, n * COLS * sizeof( muzz_fix ), \
+                t )
+
+    FIXED( "energy", 3, muzz_fix_energy( &f, cols[0][j], cols[1][j] ));
+    FIXED( "mass", 3, muzz_fix_mass( &f, cols[1][j], cols[2][j] ));
+    FIXED( "velocity", 3, muzz_fix_velocity( &f, cols[0][j], cols[2][j] ));
+    FIXED( "tkof", 4, muzz_fix_tkof( &f, cols[0][j], cols[1][j],
+                cols[3][j] / 1000 ));
+    FIXED( "tkof-velocity", 4, muzz_fix_tkof_velocity( &f, cols[0][j],
+                cols[3][j] / 1000, cols[4][j] / 1000 ));
+    #undef FIXED
+
+    for( c = 0; c < 5; ++c )
+        free( cols[c] );
+}
+
+
+
+/*==============================================================================
+                                  BENCH FORMAT
+--------------------------------------------------------------------------------
+*   Formatting results:  muzz_format() against the printf() it replaced, for
+*   the default (rounded, Imperial) line and the terse, precise one.
+*/
+static void bench_format( size_t n )
+{
+    size_t pool = pool_size( n );
+    double *mass = make_numbers( pool, 100, 500 );
+    double *velocity = make_numbers( pool, 600, 3500 );
+    muzz_shot *shots = malloc( pool * sizeof( muzz_shot ));
+    char line[ MUZZ_FORMAT_MAX ];
+    double values[ 3 ];
+    fmt_template csv;
+    muzz_ctx ctx;
+    size_t bytes;
+    double t;
+    size_t i;
+    size_t j;
+
+    if( shots == NULL )
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        exit( 1 );
+    }
+
+    muzz_ctx_init( &ctx );
+    muzz_ctx_resolve( &ctx );
+
+    for( j = 0; j < pool; ++j )
+    {
+        double nums[ 2 ] = { mass[j], velocity[j] };
+        muzz_shot_set( &ctx, &shots[j], nums );
+    }
+
+    #define FORMAT( NAME, CALL ) \
+        bytes = 0; \
+        t = now(); \
+        for( i = j = 0; i < n; ++i, j = ( j + 1 == pool ? 0 : j + 1 )) \
+            bytes += CALL; \
+        t = now() - t; \
+        report( "format." NAME, n, bytes, t )
+
+    FORMAT( "verbose.snprintf", snprintf( line, sizeof( line ),
+                "%.0lf gr @ %.0lf ft/s = %.0lf lbf\n", round( shots[j].mass ),
+                round( shots[j].velocity ), round( shots[j].energy )));
+    FORMAT( "verbose.muzz", muzz_format( &ctx, &shots[j], line,
+                sizeof( line )));
+
+    ctx.verbose = 0;
+    ctx.precise = 1;
+
+    FORMAT( "terse.snprintf", snprintf( line, sizeof( line ), "%.2lf\n",
+                shots[j].energy ));
+    FORMAT( "terse.muzz", muzz_format( &ctx, &shots[j], line,
+                sizeof( line )));
+
+    /*  A line of '--output=csv', laid out the way batch mode does it */
+    fmt_template_init( &csv, NULL );
+    fmt_template_slot( &csv, 0, 2 );
+    fmt_template_text( &csv, "," );
+    fmt_template_slot( &csv, 1, 2 );
+    fmt_template_text( &csv, "," );
+    fmt_template_slot( &csv, 2, 2 );
+    fmt_template_text( &csv, "\n" );
+
+    FORMAT( "csv.snprintf", snprintf( line, sizeof( line ),
+                "%.2lf,%.2lf,%.2lf\n", shots[j].mass, shots[j].velocity,
+                shots[j].energy ));
+    FORMAT( "csv.template", ( values[0] = shots[j].mass,
+                values[1] = shots[j].velocity, values[2] = shots[j].energy,
+                fmt_template_write( &csv, values, line ) - line ));
+    #undef FORMAT
+
+    free( mass );
+    free( velocity );
+    free( shots );
+}
+
+
+
+/*==============================================================================
+                                 MAIN FUNCTION
+--------------------------------------------------------------------------------
+*/
+int main( int argc, char *argv[] )
+{
+    size_t n = DEFAULT_RECORDS;
+    int i = 1;
+
+    bench_accuracy();
+    bench_fixed_accuracy();
+
+    do
+    {
+        if( argc > 1 )
+            n = strtoul( argv[i], NULL, 10 );
+
+        if( n == 0 )
+        {
+            fprintf( stderr, "Usage:  muzz-bench [RECORDS ...]\n" );
+            return( 1 );
+        }
+
+        srand( 1 );
+        bench_parse( n );
+        bench_compute( n );
+        bench_fixed( n );
+        bench_format( n );
+    } while( ++i < argc );
+
+    return( 0 );
+}
@@ -0,0 +1,319 @@
+/*******************************************************************************
+ *  muzzmodule.c    |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                       |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Python bindings for libmuzz's array kernels.  Each function takes whole
+ *  columns, as anything with the buffer protocol that holds contiguous
+ *  doubles (NumPy float64 arrays, a pandas column's .to_numpy(),
+ *  array.array('d'), memoryviews), and writes into an output array the
+ *  caller has already made:
+ *
+ *      import muzz, numpy as np
+ *      out = np.empty_like( mass )
+ *      muzz.energy( mass, velocity, out )
+ *      muzz.velocity( mass, energy, out, si=True, fast=True )
+ *
+ *  Nothing is copied:  the kernels read the caller's buffers where they are
+ *  and write straight into the output.  The GIL is let go while they run,
+ *  so threads working on different arrays go at the same time.  The module
+ *  doesn't need NumPy to build or run.
+ *
+ *  'make python' builds it, using python3-config.
+ *
+ ******************************************************************************/
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <string.h>
+
+#include "muzz.h"
+
+/*  The most columns a formula takes, plus its output */
+#define MODULE_COLS 4
+
+
+/*==============================================================================
+                                  GET COLUMN
+--------------------------------------------------------------------------------
+*   Gets hold of one column's buffer, which has to be contiguous doubles (and
+*   writable, for the output).  Returns 0, or sets an exception and returns
+*   -1.
+*
+*   Params
+*       PyObject *obj       |   What the caller gave
+*       Py_buffer *view     |   Where to put the buffer
+*       int writable        |   It's the output
+*       const char *name    |   The argument, for errors
+*/
+static int get_column( PyObject *obj, Py_buffer *view, int writable,
+        const char *name )
+{
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+
+    if( writable )
+        flags |= PyBUF_WRITABLE;
+
+    if( PyObject_GetBuffer( obj, view, flags ) != 0 )
+        return( -1 );
+
+    /*  Native doubles, however the exporter spells it */
+    if( view->itemsize != sizeof( double ) || view->format == NULL
+            || ( strcmp( view->format, "d" ) != 0
+                && strcmp( view->format, "@d" ) != 0
+                && strcmp( view->format, "=d" ) != 0 ))
+    {
+        PyErr_Format( PyExc_TypeError, "%s must hold float64 (double), "
+                "not '%s'", name, ( view->format ? view->format : "B" ));
+        PyBuffer_Release( view );
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   RUN PLAN
+--------------------------------------------------------------------------------
+*   What every function here does:  reads the columns and options, makes a
+*   plan, and runs it over the lot without the GIL.  Returns the output
+*   array, or NULL with an exception set.
+*
+*   Params
+*       PyObject *args      |   The columns, then the output
+*       PyObject *kwargs    |   si, k, kmode and fast
+*       int solve           |   enum muzz_solve
+*       char **names        |   Keyword names:  the columns, "out", options
+*/
+static PyObject *run_plan( PyObject *args, PyObject *kwargs, int solve,
+        char **names )
+{
+    PyObject *objs[ MODULE_COLS ] = { NULL, NULL, NULL, NULL };
+    Py_buffer views[ MODULE_COLS ];
+    const double *cols[ 3 ] = { NULL, NULL, NULL };
+    PyObject *k = Py_None;
+    const char *kMode = "industry";
+    int si = 0;
+    int fast = 0;
+    int inputs;
+    int held = 0;
+    int failed = 1;
+    size_t n;
+    muzz_plan plan;
+    muzz_ctx ctx;
+    int ok;
+    int i;
+
+    muzz_ctx_init( &ctx );
+    ctx.solve = solve;
+    inputs = muzz_inputs( &ctx );
+
+    /*  The columns, then the output (objs[ inputs ]), then the options */
+    if( inputs == 3 )
+        ok = PyArg_ParseTupleAndKeywords( args, kwargs, "OOOO|$pOsp", names,
+                &objs[0], &objs[1], &objs[2], &objs[3], &si, &k, &kMode,
+                &fast );
+    else
+        ok = PyArg_ParseTupleAndKeywords( args, kwargs, "OOO|$pOsp", names,
+                &objs[0], &objs[1], &objs[2], &si, &k, &kMode, &fast );
+
+    if( ! ok )
+        return( NULL );
+
+    /*  The constant, as '-c', '-C', '-K' or '-k' would have it */
+    if( k != Py_None )
+    {
+        ctx.kMode = MUZZ_K_CUSTOM;
+        ctx.customK = PyFloat_AsDouble( k );
+        if( ctx.customK == -1.0 && PyErr_Occurred())
+            return( NULL );
+    }
+
+    else if( strcmp( kMode, "gac1" ) == 0 )
+        ctx.kMode = MUZZ_K_GAC1;
+    else if( strcmp( kMode, "gac2" ) == 0 )
+        ctx.kMode = MUZZ_K_GAC2;
+    else if( strcmp( kMode, "industry" ) != 0 )
+    {
+        PyErr_Format( PyExc_ValueError, "kmode must be 'industry', 'gac1' "
+                "or 'gac2', not '%s'", kMode );
+        return( NULL );
+    }
+
+    ctx.si = si;
+    ctx.fast = fast;
+    muzz_ctx_resolve( &ctx );
+
+    for( held = 0; held <= inputs; ++held )
+        if( get_column( objs[ held ], &views[ held ], ( held == inputs ),
+                    names[ held ] ))
+            goto out;
+
+    /*  Every column has to be as long as the output */
+    n = views[ inputs ].len / sizeof( double );
+    for( i = 0; i < inputs; ++i )
+    {
+        if( views[i].len != views[ inputs ].len )
+        {
+            PyErr_Format( PyExc_ValueError, "%s has %zd values, but %s has "
+                    "%zd", names[i], views[i].len / (Py_ssize_t)sizeof(
+                        double ), names[ inputs ], (Py_ssize_t)n );
+            goto out;
+        }
+
+        cols[i] = views[i].buf;
+    }
+
+    muzz_plan_init( &plan, &ctx );
+
+    Py_BEGIN_ALLOW_THREADS
+    muzz_plan_run( &plan, cols[0], cols[1], cols[2], views[ inputs ].buf, n );
+    Py_END_ALLOW_THREADS
+    failed = 0;
+
+out:
+    for( i = 0; i < held; ++i )
+        PyBuffer_Release( &views[i] );
+
+    if( failed )
+        return( NULL );
+
+    Py_INCREF( objs[ inputs ] );
+    return( objs[ inputs ] );
+}
+
+
+
+/*==============================================================================
+                                 THE FORMULAS
+--------------------------------------------------------------------------------
+*   One function per formula, taking its columns in command line order.
+*/
+static char *energyNames[] = { "mass", "velocity", "out", "si", "k", "kmode",
+    "fast", NULL };
+static char *massNames[] = { "velocity", "energy", "out", "si", "k", "kmode",
+    "fast", NULL };
+static char *velocityNames[] = { "mass", "energy", "out", "si", "k", "kmode",
+    "fast", NULL };
+static char *tkofNames[] = { "mass", "velocity", "diameter", "out", "si",
+    "k", "kmode", "fast", NULL };
+static char *tkofMassNames[] = { "velocity", "diameter", "tkof", "out", "si",
+    "k", "kmode", "fast", NULL };
+static char *tkofVelocityNames[] = { "mass", "diameter", "tkof", "out", "si",
+    "k", "kmode", "fast", NULL };
+
+
+static PyObject *py_energy( PyObject *self, PyObject *args, PyObject *kwargs )
+{
+    (void)self;
+    return( run_plan( args, kwargs, MUZZ_SOLVE_ENERGY, energyNames ));
+}
+
+
+static PyObject *py_mass( PyObject *self, PyObject *args, PyObject *kwargs )
+{
+    (void)self;
+    return( run_plan( args, kwargs, MUZZ_SOLVE_MASS, massNames ));
+}
+
+
+static PyObject *py_velocity( PyObject *self, PyObject *args,
+        PyObject *kwargs )
+{
+    (void)self;
+    return( run_plan( args, kwargs, MUZZ_SOLVE_VELOCITY, velocityNames ));
+}
+
+
+static PyObject *py_tkof( PyObject *self, PyObject *args, PyObject *kwargs )
+{
+    (void)self;
+    return( run_plan( args, kwargs, MUZZ_SOLVE_TKOF, tkofNames ));
+}
+
+
+static PyObject *py_tkof_mass( PyObject *self, PyObject *args,
+        PyObject *kwargs )
+{
+    (void)self;
+    return( run_plan( args, kwargs, MUZZ_SOLVE_TKOF_MASS, tkofMassNames ));
+}
+
+
+static PyObject *py_tkof_velocity( PyObject *self, PyObject *args,
+        PyObject *kwargs )
+{
+    (void)self;
+    return( run_plan( args, kwargs, MUZZ_SOLVE_TKOF_VELOCITY,
+                tkofVelocityNames ));
+}
+
+
+/*  Which instruction set the kernels use, as muzz_kernel_isa() says */
+static PyObject *py_isa( PyObject *self, PyObject *unused )
+{
+    (void)self;
+    (void)unused;
+    return( PyUnicode_FromString( muzz_kernel_isa()));
+}
+
+
+
+/*==============================================================================
+                                  THE MODULE
+--------------------------------------------------------------------------------
+*   The module's functions and their help.
+*/
+static PyMethodDef methods[] = {
+    { "energy", (PyCFunction)(void (*)( void ))py_energy,
+        METH_VARARGS | METH_KEYWORDS,
+        "energy(mass, velocity, out, *, si=False, k=None, kmode='industry', "
+        "fast=False)\n\nMuzzle energy of every shot into out, which is "
+        "returned." },
+    { "mass", (PyCFunction)(void (*)( void ))py_mass,
+        METH_VARARGS | METH_KEYWORDS,
+        "mass(velocity, energy, out, *, si=False, k=None, kmode='industry', "
+        "fast=False)\n\nMass of every shot into out, which is returned." },
+    { "velocity", (PyCFunction)(void (*)( void ))py_velocity,
+        METH_VARARGS | METH_KEYWORDS,
+        "velocity(mass, energy, out, *, si=False, k=None, kmode='industry', "
+        "fast=False)\n\nVelocity of every shot into out, which is "
+        "returned." },
+    { "tkof", (PyCFunction)(void (*)( void ))py_tkof,
+        METH_VARARGS | METH_KEYWORDS,
+        "tkof(mass, velocity, diameter, out, *, si=False, k=None, "
+        "kmode='industry', fast=False)\n\nTaylor knockout factor of every "
+        "shot into out, which is returned." },
+    { "tkof_mass", (PyCFunction)(void (*)( void ))py_tkof_mass,
+        METH_VARARGS | METH_KEYWORDS,
+        "tkof_mass(velocity, diameter, tkof, out, *, si=False, k=None, "
+        "kmode='industry', fast=False)\n\nMass every shot needs for its "
+        "TKOF into out, which is returned." },
+    { "tkof_velocity", (PyCFunction)(void (*)( void ))py_tkof_velocity,
+        METH_VARARGS | METH_KEYWORDS,
+        "tkof_velocity(mass, diameter, tkof, out, *, si=False, k=None, "
+        "kmode='industry', fast=False)\n\nVelocity every shot needs for its "
+        "TKOF into out, which is returned." },
+    { "isa", py_isa, METH_NOARGS,
+        "isa()\n\nThe instruction set the kernels use ('avx2', say)." },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT,
+    "muzz",
+    "Muzzle energy, mass, velocity and TKOF over whole arrays of doubles, "
+    "with libmuzz's\nSIMD kernels.  Columns are anything with the buffer "
+    "protocol holding\ncontiguous float64s; results go into out, which "
+    "has to be as long.\nk is a custom constant; kmode is 'industry', "
+    "'gac1' or 'gac2' otherwise.",
+    -1,
+    methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_muzz( void )
+{
+    return( PyModule_Create( &module ));
+}
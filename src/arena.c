@@ -0,0 +1,237 @@
+/*******************************************************************************
+ *  arena.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Arenas.  Batch blocks keep their text, results and errors in an arena
+ *  that's reset whenever the block is refilled, and worker threads get their
+ *  scratch columns from one.  Once an arena has seen a block as big as the
+ *  ones coming through, it's a single chunk that never needs to grow, so the
+ *  steady state is no heap traffic at all.  heap_allocs() is how '--stats'
+ *  can show that.
+ *
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "arena.h"
+
+
+/*  Smallest chunk we'll bother getting */
+#define CHUNK_MIN ( 64 * 1024 )
+
+/*  Allocations are rounded up to this */
+#define ALIGN ( sizeof( max_align_t ))
+
+#define round_up( n ) ( ( (n) + ALIGN - 1 ) & ~( ALIGN - 1 ))
+
+
+/*  Trips to the heap */
+static atomic_uint_fast64_t allocs;
+
+
+
+/*==============================================================================
+                                   HEAP ALLOC
+--------------------------------------------------------------------------------
+*/
+void *heap_alloc( size_t size )
+{
+    atomic_fetch_add_explicit( &allocs, 1, memory_order_relaxed );
+    return( malloc( size ));
+}
+
+
+
+/*==============================================================================
+                                  HEAP REALLOC
+--------------------------------------------------------------------------------
+*/
+void *heap_realloc( void *p, size_t size )
+{
+    atomic_fetch_add_explicit( &allocs, 1, memory_order_relaxed );
+    return( realloc( p, size ));
+}
+
+
+
+/*==============================================================================
+                                   HEAP FREE
+--------------------------------------------------------------------------------
+*/
+void heap_free( void *p )
+{
+    free( p );
+}
+
+
+
+/*==============================================================================
+                                  HEAP ALLOCS
+--------------------------------------------------------------------------------
+*/
+uint64_t heap_allocs( void )
+{
+    return( atomic_load_explicit( &allocs, memory_order_relaxed ));
+}
+
+
+
+/*==============================================================================
+                                   ARENA INIT
+--------------------------------------------------------------------------------
+*/
+void arena_init( arena *a )
+{
+    memset( a, 0, sizeof( *a ));
+}
+
+
+
+/*==============================================================================
+                                   NEW CHUNK
+--------------------------------------------------------------------------------
+*   Puts a fresh chunk of at least size bytes at the head of an arena.
+*   Returns 0, or -1 if we're out of memory.
+*/
+static int new_chunk( arena *a, size_t size )
+{
+    arena_chunk *c;
+
+    if( size < CHUNK_MIN )
+        size = CHUNK_MIN;
+
+    c = heap_alloc( sizeof( arena_chunk ) + size );
+    if( c == NULL )
+        return( -1 );
+
+    c->next = a->head;
+    c->size = size;
+    c->used = 0;
+    a->head = c;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  ARENA ALLOC
+--------------------------------------------------------------------------------
+*/
+void *arena_alloc( arena *a, size_t size )
+{
+    arena_chunk *c = a->head;
+    size = round_up( size );
+
+    if( c == NULL || c->size - c->used < size )
+    {
+        /*  Double up each time, so a growing buffer doesn't go chunk by chunk */
+        if( new_chunk( a, ( c != NULL && c->size * 2 > size ?
+                        c->size * 2 : size )))
+            return( NULL );
+        c = a->head;
+    }
+
+    a->last = (char *)c->data + c->used;
+    c->used += size;
+    a->total += size;
+    return( a->last );
+}
+
+
+
+/*==============================================================================
+                                   ARENA GROW
+--------------------------------------------------------------------------------
+*/
+void *arena_grow( arena *a, void *old, size_t oldSize, size_t newSize )
+{
+    arena_chunk *c = a->head;
+    void *p;
+
+    oldSize = round_up( oldSize );
+    newSize = round_up( newSize );
+
+    if( old == NULL )
+        return( arena_alloc( a, newSize ));
+
+    if( newSize <= oldSize )
+        return( old );
+
+    /*  The latest allocation, with room after it */
+    if( old == a->last && c->size - c->used >= newSize - oldSize )
+    {
+        c->used += newSize - oldSize;
+        a->total += newSize - oldSize;
+        return( old );
+    }
+
+    p = arena_alloc( a, newSize );
+    if( p != NULL )
+        memcpy( p, old, oldSize );
+
+    return( p );
+}
+
+
+
+/*==============================================================================
+                                  ARENA RESET
+--------------------------------------------------------------------------------
+*/
+void arena_reset( arena *a )
+{
+    arena_chunk *c = a->head;
+    arena_chunk *next;
+
+    if( a->total > a->peak )
+        a->peak = a->total;
+
+    a->total = 0;
+    a->last = NULL;
+
+    if( c == NULL )
+        return;
+
+    /*  More than one chunk; swap them all for one that'll hold the lot */
+    if( c->next != NULL )
+    {
+        for( c = c->next; c != NULL; c = next )
+        {
+            next = c->next;
+            heap_free( c );
+        }
+
+        a->head->next = NULL;
+        if( a->head->size < a->peak )
+        {
+            heap_free( a->head );
+            a->head = NULL;
+            if( new_chunk( a, a->peak ))
+                return;
+        }
+    }
+
+    a->head->used = 0;
+}
+
+
+
+/*==============================================================================
+                                   ARENA FREE
+--------------------------------------------------------------------------------
+*/
+void arena_free( arena *a )
+{
+    arena_chunk *c;
+    arena_chunk *next;
+
+    for( c = a->head; c != NULL; c = next )
+    {
+        next = c->next;
+        heap_free( c );
+    }
+
+    arena_init( a );
+}
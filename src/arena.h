@@ -0,0 +1,66 @@
+/*******************************************************************************
+ *  arena.h     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Arenas, and a count of every trip to the heap the muzz program makes.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_ARENA_H
+#define MUZZ_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*  One piece of memory an arena hands out from */
+typedef struct arena_chunk {
+    struct arena_chunk *next;   //  Older, fuller chunks
+    size_t size;
+    size_t used;
+    max_align_t data[];
+} arena_chunk;
+
+
+/*  Memory handed out by bumping a pointer, and all given back at once */
+typedef struct arena {
+    arena_chunk *head;          //  Chunk we're handing out from
+    void *last;                 //  Most recent allocation; can grow in place
+    size_t peak;                //  Most we've had out between resets
+    size_t total;               //  What we've handed out since the reset
+} arena;
+
+
+/*  An empty arena; nothing is allocated until it's used */
+void arena_init( arena *a );
+
+/*  size bytes, aligned for anything.  NULL if we're out of memory. */
+void *arena_alloc( arena *a, size_t size );
+
+/*
+ *  Makes an allocation bigger, keeping its contents:  in place if it was the
+ *  latest and there's room, otherwise by copying.  NULL if we're out of
+ *  memory (and old is left as it was).
+ */
+void *arena_grow( arena *a, void *old, size_t oldSize, size_t newSize );
+
+/*
+ *  Gives back everything at once.  If it took more than one chunk since the
+ *  last reset, they're swapped for a single one big enough for all of it,
+ *  so a steady workload stops allocating after the first few rounds.
+ */
+void arena_reset( arena *a );
+
+/*  Frees the lot */
+void arena_free( arena *a );
+
+
+/*  malloc(), realloc() and free(), counted */
+void *heap_alloc( size_t size );
+void *heap_realloc( void *p, size_t size );
+void heap_free( void *p );
+
+/*  How many times we've gone to the heap for memory so far */
+uint64_t heap_allocs( void );
+
+#endif
@@ -0,0 +1,4233 @@
+/*******************************************************************************
+ *  batch.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Batch mode.  The input is read in blocks of whole lines.  Each block is
+ *  parsed into columns, run through the compute plan a chunk at a time and
+ *  formatted into its own output buffer, which is then written out.
+ *
+ *  When the input is a regular file we map the whole thing into memory and
+ *  the blocks are just slices of the mapping, split at newlines, so nothing
+ *  gets copied on the way in.  Pipes and the like are read() a block at a
+ *  time instead.
+ *
+ *  Sweeps work the same way, except that a block is a range of cells of the
+ *  grid rather than text, and the inputs are worked out from the cell number.
+ *  So do Monte Carlo runs ('--mc'), where a block is a range of samples and
+ *  the inputs are drawn from the seed and the sample number (see mc.c).
+ *
+ *  With '--tagged', every number in a record may carry its units ("230gr",
+ *  "270m/s"), which also say what the record is after:  a mass and a
+ *  velocity want the energy, a velocity and an energy the mass, and so on.
+ *  A chunk's records are sorted into a bucket per (units, target) and each
+ *  bucket goes through a plan of its own in one call, then the results are
+ *  put back in input order; so every kernel still sees a column of records
+ *  that are all the same, and nothing branches per record on the units.
+ *
+ *  With '--target', the last input (the energy or TKOF to reach) is left
+ *  out of the records, which are just a catalog of bullets, and a column of
+ *  it is filled in for each chunk before the inverse kernels run over it;
+ *  '--where' then keeps the ones that get there within bounds in the same
+ *  pass.
+ *
+ *  With '--drag', each record also has a BC, and is spread out into one row
+ *  per distance downrange before it's calculated:  the velocity of the row
+ *  is what's left at that distance (see drag.c), and it has a range column
+ *  of its own.  From there on a row is treated just like a record.
+ *
+ *  Input and output can also be binary columns rather than text.  A column
+ *  file is a 16 byte header, then any number of frames:
+ *
+ *      header:     "MUZZCOL1", then a 32 bit mask of which columns there are
+ *                  (1 mass, 2 velocity, 4 energy, 8 diameter, 16 TKOF, 32
+ *                  range) and 32 bits of zero
+ *      frame:      a 64 bit row count n, then n doubles for each column, in
+ *                  that order
+ *
+ *  Everything is little-endian.  A frame of input is a block; a chunk of
+ *  output is a frame.  Numbers come and go exactly, with no rounding.
+ *
+ *  Results can go out as CSV or NDJSON too, with the same columns as a
+ *  column file, each named with its units ("velocity_fps").  The line is
+ *  laid out once for the run, as a template (see format.c), so a record is
+ *  only copies and numbers; a CSV header is written first.
+ *
+ *  With more than one job, that middle part happens on worker threads:  the
+ *  main thread reads blocks into a ring of slots, the workers take whichever
+ *  slot is next, and a writer thread prints the slots strictly in the order
+ *  they were read.  Since every block goes through exactly the same code
+ *  either way, the output is the same byte for byte.
+ *
+ *  The ring has no locks.  Each slot has a stamp saying which block it holds
+ *  and which stage has it, and every stage just waits for the stamp it wants
+ *  and sets the next.  A thread with nothing to do spins briefly, then
+ *  sleeps on a futex until another stage moves.  The ring is a fixed size,
+ *  so if stdout stops taking output the writer stops freeing slots, and the
+ *  reader stops reading, rather than anything piling up in memory.
+ *
+ *  Nothing is allocated per record.  Each block keeps its buffers in its
+ *  own arena, reset whenever the block is refilled, and the ring's slots are
+ *  reused over and over; after the first few blocks the arenas are big
+ *  enough and nothing more comes from the heap.
+ *
+ *  In summary mode ('--summary'), results are added up rather than printed.
+ *  Each block gets its own summary, in its arena, which the writer adds to
+ *  the run's in input order, the same as it would print them; so again the
+ *  answer doesn't depend on how many threads there were.
+ *
+ *  With '--top', each worker keeps the best results it's seen in its own
+ *  heap, and the heaps are merged once everything's been read.  Results are
+ *  ranked by their position in the input when they tie, so that's the same
+ *  either way too.  '--where' conditions are checked on each chunk right
+ *  after it's calculated, whatever happens to it next.
+ *
+ *  With '--shard=I/N', a run only does its share of the work:  the I'th of
+ *  N pieces of the mapped file, split at the first newline after each Nth
+ *  of its bytes, or of the cells of a sweep or samples of '--mc'.  Run
+ *  every shard and their output, printed in order, is the whole run's; only
+ *  shard 0 writes a CSV or column file header.  With a summary or '--top',
+ *  a shard writes a partial instead (see partial.c), and 'muzz merge' adds
+ *  the partials up to print what one run would have.  The position a top-K
+ *  row is ranked by on a tie starts with its shard number, so the K best are
+ *  the same K however the run was split.
+ *
+ *  With '--stats', each thread times its own stages into its own run_stats,
+ *  which are added up once it's done.  Without, the stats pointers are NULL
+ *  and none of the clocks are ever read.
+ *
+ *  Following a file ('--follow') is batch mode that never reaches the end:
+ *  the file is read(), not mapped, a line without its newline is held back
+ *  until it gets one, and once we've caught up we sleep on inotify until
+ *  something's written.  Only the new lines are read, and the summary (or
+ *  top-K) carries on from where it was, printed again after every update.
+ *  A file that shrinks is read again from the top, and one that's been
+ *  replaced (rotated) is finished off and then the new one is followed.
+ *
+ ******************************************************************************/
+#define _GNU_SOURCE     //  memrchr()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "muzz.h"
+#include "batch.h"
+#include "stats.h"
+#include "arena.h"
+#include "summary.h"
+#include "topk.h"
+#include "mc.h"
+#include "zstream.h"
+#include "format.h"
+#include "partial.h"
+
+
+/*  Characters that may separate fields of a record:  " \t,;\r\n" */
+static const unsigned char delims[ 256 ] = {
+    [' '] = 1, ['\t'] = 1, [','] = 1, [';'] = 1, ['\r'] = 1, ['\n'] = 1
+};
+
+#define is_delim( c ) ( delims[ (unsigned char)(c) ] )
+
+/*  Records per chunk; each chunk is one call to the kernels */
+#define BATCH_CHUNK 4096
+
+/*  How much we read at a time for one block */
+#define BLOCK_SIZE ( 1 << 20 )
+
+/*  Grid cells (or Monte Carlo samples) per block in a sweep */
+#define SWEEP_BLOCK ( 64 * 1024 )
+
+/*  Slots in the ring, per worker thread */
+#define SLOTS_PER_JOB 2
+
+/*  Times a thread checks for its next block before going to sleep */
+#define RING_SPINS 100
+
+/*  Longest we sleep between looks at a followed file, in ms, inotify or no */
+#define FOLLOW_WAIT_MS 1000
+
+/*  Room for inotify events; we only need to know there were some */
+#define FOLLOW_EVENTS 4096
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    #define cpu_relax() __builtin_ia32_pause()
+#elif defined( __aarch64__ )
+    #define cpu_relax() __asm__ __volatile__( "yield" )
+#else
+    #define cpu_relax() do { } while( 0 )
+#endif
+
+/*  Column files */
+#define BIN_MAGIC "MUZZCOL1"
+#define BIN_HEADER 16
+#define BIN_COLS BATCH_COLS
+
+/*  Biggest input frame we'll take, in bytes */
+#define BIN_FRAME_MAX ( (uint64_t)1 << 30 )
+
+
+/*  The columns of a column file, in the order they're stored */
+enum BinColumn {
+    BIN_MASS,
+    BIN_VELOCITY,
+    BIN_ENERGY,
+    BIN_DIAMETER,
+    BIN_TKOF,
+    BIN_RANGE               //  '--drag' only
+};
+
+static const char *colNames[ BIN_COLS ] = {
+    "mass", "velocity", "energy", "diameter", "TKOF", "range"
+};
+
+static const char *colUnits[ 2 ][ BIN_COLS ] = {
+    { "gr", "ft/s", "lbf", "in", NULL, "yd" },
+    { "g", "m/s", "J", "mm", NULL, "m" }
+};
+
+/*  CSV and NDJSON:  each column's name, with its units */
+static const char *fieldNames[ 2 ][ BIN_COLS ] = {
+    { "mass_gr", "velocity_fps", "energy_ftlbf", "diameter_in", "tkof",
+        "range_yd" },
+    { "mass_g", "velocity_mps", "energy_J", "diameter_mm", "tkof", "range_m" }
+};
+
+/*  '--tagged':  what each unit a number may carry measures, and in what */
+typedef struct unit_tag {
+    const char *name;
+    int col;                //  enum BinColumn
+    int si;
+} unit_tag;
+
+static const unit_tag unitTags[] = {
+    { "gr", BIN_MASS, 0 },          { "g", BIN_MASS, 1 },
+    { "fps", BIN_VELOCITY, 0 },     { "ft/s", BIN_VELOCITY, 0 },
+    { "m/s", BIN_VELOCITY, 1 },     { "mps", BIN_VELOCITY, 1 },
+    { "lbf", BIN_ENERGY, 0 },       { "ftlb", BIN_ENERGY, 0 },
+    { "ft-lb", BIN_ENERGY, 0 },     { "ftlbf", BIN_ENERGY, 0 },
+    { "ft-lbf", BIN_ENERGY, 0 },    { "J", BIN_ENERGY, 1 },
+    { "in", BIN_DIAMETER, 0 },      { "mm", BIN_DIAMETER, 1 }
+};
+
+#define TOTAL_UNIT_TAGS ( sizeof( unitTags ) / sizeof( unitTags[0] ))
+
+/*  What a tagged record's columns make it:  its target, and its numbers in
+ *  command line order */
+typedef struct tag_target {
+    unsigned int mask;      //  1 << BinColumn for each one there
+    int solve;              //  enum muzz_solve
+    int inputs[ 3 ];
+} tag_target;
+
+static const tag_target tagTargets[] = {
+    { ( 1 << BIN_MASS ) | ( 1 << BIN_VELOCITY ), MUZZ_SOLVE_ENERGY,
+        { BIN_MASS, BIN_VELOCITY, -1 } },
+    { ( 1 << BIN_VELOCITY ) | ( 1 << BIN_ENERGY ), MUZZ_SOLVE_MASS,
+        { BIN_VELOCITY, BIN_ENERGY, -1 } },
+    { ( 1 << BIN_MASS ) | ( 1 << BIN_ENERGY ), MUZZ_SOLVE_VELOCITY,
+        { BIN_MASS, BIN_ENERGY, -1 } },
+    { ( 1 << BIN_MASS ) | ( 1 << BIN_VELOCITY ) | ( 1 << BIN_DIAMETER ),
+        MUZZ_SOLVE_TKOF, { BIN_MASS, BIN_VELOCITY, BIN_DIAMETER } }
+};
+
+#define TOTAL_TAG_TARGETS ( sizeof( tagTargets ) / sizeof( tagTargets[0] ))
+
+/*  A record's bucket:  its units and what it solves for */
+#define TAG_BUCKETS 8
+#define TAG_BUCKET( si, solve ) ( (si) * 4 + (solve) )
+
+/*  parse_tagged():  the units don't make sense */
+#define BAD_TAGS ( -2 )
+
+/*  write_block() and the like:  the output couldn't be written */
+#define WRITE_FAILED ( -2 )
+
+/*
+ *  A row's place in the input, to break ties in a top-K:  its shard, then
+ *  its block, then its row in the block.  The shard has the top 12 bits,
+ *  enough for PARTIAL_SHARDS_MAX, and the row the bottom ORDER_ROW_BITS (a
+ *  block is at most a frame, 2^26 rows).  The block gets what's in between,
+ *  or the shard's bits as well if there are no shards.
+ */
+#define SHARD_SHIFT 52
+#define ORDER_ROW_BITS 28
+
+/*  Room for the "1000 yd:  " a downrange result starts with, in text */
+#define RANGE_PREFIX_MAX 32
+
+/*  Where a column comes from, when it isn't one of the inputs */
+#define FROM_RESULT ( -1 )
+#define FROM_ENERGY ( -2 )      //  Worked out on the side, in TKOF mode
+#define FROM_NONE ( -3 )        //  Nowhere; no such column in this mode
+#define FROM_RANGE ( -4 )       //  How far downrange, with '--drag'
+
+
+/*  Which columns a column file has, and how they line up with a record */
+typedef struct batch_layout {
+    unsigned int mask;          //  1 << BinColumn for each one there
+    int numCols;
+
+    int inputs[ 3 ];            //  Input file:  position of each input
+    int sources[ BIN_COLS ];    //  Output file (or summary):  input each
+                                //  column comes from, in order, or FROM_*
+} batch_layout;
+
+
+/*  A '--where' condition, with the column turned into where it comes from */
+typedef struct batch_test {
+    int source;             //  An input, or FROM_*
+    int op;                 //  enum BatchOp
+    double values[ BATCH_VALUES_MAX ];
+    int numValues;
+} batch_test;
+
+
+/*  A bad record:  where it was (line within the block) and what was wrong */
+typedef struct batch_error {
+    unsigned long line;
+    int count;              //  Fields read, or -1 if one wasn't a number
+} batch_error;
+
+
+/*
+ *  Where block n is in the ring:  its slot's stamp is STAMP( n, ... ).  Each
+ *  stage waits for the stamp it wants and sets the next one, so the stamps
+ *  alone say who owns a slot.
+ */
+enum SlotStamp {
+    STAMP_FREE,             //  Reader may fill it
+    STAMP_FILLED,           //  Waiting for a worker
+    STAMP_DONE              //  Waiting for the writer
+};
+
+#define STAMP( n, stage ) ( (uint32_t)( (n) * 4 + (stage) ))
+
+
+/*  One block of input and everything that comes out of it */
+typedef struct batch_block {
+    const char *data;       //  Whole lines; in text, or in the mapped file
+    size_t len;
+
+    char *text;             //  Our own copy, when the input isn't mapped
+    size_t cap;
+
+    unsigned long lines;    //  Lines in the block
+    unsigned long number;   //  Blocks before this one
+
+    const batch_range *sweep;   //  Or, in a sweep, the ranges...
+    const batch_dist *dists;    //  ...or the distributions, in Monte Carlo...
+    uint64_t seed;
+    uint64_t first;             //  ...and which cells of the grid (samples)
+    uint64_t cells;
+
+    const batch_layout *layout; //  Or, a frame of columns in data
+    uint64_t rows;
+
+    char *out;              //  Formatted results
+    size_t outLen;
+    size_t outCap;
+
+    batch_error *errors;
+    size_t numErrors;
+    size_t errorCap;
+
+    summary_table sum;      //  In summary mode, instead of out
+
+    arena mem;              //  Where text, out, errors and sum live
+
+    atomic_uint_least32_t stamp;    //  See enum SlotStamp
+} batch_block;
+
+
+/*  Scratch space for turning a block into results */
+typedef struct batch_worker {
+    double *cols[ 4 ];      //  Input columns, in command line order
+    double *res;            //  Output column
+    double *energy;         //  Energy, in TKOF modes, if anything wants it
+    double *range;          //  '--drag':  how far downrange each row is
+    summary_group **groups; //  Summary mode:  each record's group
+    uint32_t *index;        //  Where each record that passed was in the chunk
+    uint64_t row;           //  Records of this block before the chunk
+    arena mem;              //  Where the columns live
+
+    int fields;                     //  Numbers in a record
+    const batch_range *distances;   //  '--drag':  where each record's
+    int drag;                       //  rows are, and the drag model
+    double *recs[ 4 ];              //  The records, spread from here...
+    summary_group **recGroups;      //  ...and their groups
+
+    unsigned char *tags;            //  '--tagged':  each record's bucket,
+    int defaultTag;                 //  the bucket of one with no units,
+    const muzz_ctx *tagCtx;         //  and for each bucket, its options
+    const muzz_plan *tagPlans;      //  and plan; NULL without
+
+    const batch_layout *binOut;     //  Binary columns out, or NULL for text
+    const batch_layout *lineCols;   //  CSV or NDJSON columns out, laid out
+    const fmt_template *lineOut;    //  like this; NULL for text
+    const batch_layout *summary;    //  Columns to summarize, or NULL
+    int group;                      //  Records start with a key
+    int needEnergy;                 //  Work out energy as well as the answer
+    int energyFrom[ 2 ];            //  From these sources (mass, velocity)
+    const double *target;           //  '--target', or NULL
+
+    const batch_test *tests;        //  '--where'
+    int numTests;
+
+    topk_heap *top;                 //  '--top':  where the best go, or NULL
+    int topSource;                  //  Column they're ranked by
+    int topLow;                     //  Lowest is best
+
+    uint64_t orderBase;             //  '--shard':  where its rows start
+
+    run_stats *stats;       //  Where to count, or NULL
+    stats_time lap;         //  When the current stage started
+} batch_worker;
+
+
+/*  Where the blocks come from */
+typedef struct batch_reader {
+    const char *map;        //  The whole input, if it's a mapped file
+    size_t mapLen;
+    size_t mapPos;          //  Where the next block starts
+
+    const batch_range *sweep;   //  The ranges, if this is a sweep
+    const batch_dist *dists;    //  Or the distributions, in Monte Carlo
+    uint64_t seed;
+    uint64_t sweepPos;          //  Next cell (or sample)
+    uint64_t sweepCells;        //  Cells in the whole grid (samples to draw)
+
+    const batch_layout *layout; //  The columns, if the input's binary
+    int badFrame;               //  A frame was cut short or too big
+
+    int fd;
+    zstream *z;             //  Compressed input, decompressed on its own
+                            //  thread, or NULL
+    char peek[ ZFORMAT_MAGIC ]; //  What was read to find out it isn't
+    size_t peekLen;
+    size_t peekPos;
+
+    char *carry;            //  Partial line left over from the last block
+    size_t carryLen;
+    size_t carryCap;
+    int eof;
+    int error;              //  A read failed
+    int follow;             //  '--follow':  a line isn't done until its '\n'
+
+    unsigned long blocks;       //  Blocks read so far
+    unsigned long maxBlocks;    //  How many a top-K has room to tell apart
+    int tooBig;                 //  Stopped at maxBlocks
+} batch_reader;
+
+
+/*  Everything about a run that stays the same throughout */
+typedef struct batch_job {
+    const muzz_ctx *ctx;
+    const muzz_plan *plan;
+    const char *name;               //  Of the input, for error messages
+    const batch_layout *binOut;     //  Columns to write, or NULL for text
+    const batch_layout *lineCols;   //  Or, as CSV or NDJSON lines, or NULL
+    fmt_template lineOut;           //  What each of those looks like
+    const batch_layout *sumCols;    //  Or, columns to summarize
+    summary_table *summary;         //  The blocks' summaries add up to this
+    int group;                      //  Records start with a key to group by
+    int needEnergy;                 //  TKOF mode, and energy's wanted
+    int energyFrom[ 2 ];            //  Where its mass and velocity come from
+    int fields;                     //  Numbers in a record
+    const double *target;           //  '--target':  the last input, or NULL
+    const batch_range *distances;   //  '--drag', or NULL
+    int drag;
+
+    int tagged;                     //  '--tagged':  records carry units
+    int defaultTag;                 //  Bucket of a record that doesn't
+    muzz_ctx tagCtx[ TAG_BUCKETS ]; //  Options and plan for each bucket
+    muzz_plan tagPlans[ TAG_BUCKETS ];
+
+    batch_test tests[ BATCH_WHERE_MAX ];
+    int numTests;
+
+    topk_heap *top;                 //  The best, once the threads are done
+    int topSource;
+    int topLow;
+    int jobs;
+    int partial;                    //  '--shard':  write a partial, not the
+    uint64_t orderBase;             //  summary or top; rows start here
+    uint64_t input;                 //  and a fingerprint of the input
+    run_stats *stats;               //  Threads add theirs in here, or NULL
+    zstream *zout;                  //  '--compress':  output goes through
+                                    //  this, or NULL for straight to stdout
+} batch_job;
+
+
+/*  'muzz merge':  a run being put back together from its shards' partials */
+typedef struct merge_run {
+    partial_head head;      //  The first partial's
+    int started;
+    unsigned char *seen;    //  Each shard, once it's been read
+
+    muzz_ctx ctx;
+    batch_opts opts;
+    batch_range range;      //  Stands in for '--drag' distances
+    batch_layout out;
+    summary_table sum;
+    topk_heap top;
+    batch_job job;
+    muzz_plan plan;
+} merge_run;
+
+
+/*  Everything the threads share */
+typedef struct batch_ring {
+    const batch_job *job;
+
+    batch_block *slots;
+    unsigned long numSlots;     //  Block n goes in slots[ n % numSlots ]
+
+    atomic_ulong nextWork;      //  Next block a worker will claim
+    atomic_ulong total;         //  How many blocks, once the reader's done
+    atomic_int failed;          //  Something ran out of memory
+    atomic_int unwritten;       //  The output couldn't be written
+    atomic_int bad;             //  There was a bad record
+
+    atomic_uint epoch;          //  Goes up with every change; slept on
+    atomic_int sleepers;        //  Threads asleep on epoch
+} batch_ring;
+
+
+/*  A thread of a threaded run, and its own stats and top-K */
+typedef struct batch_thread {
+    pthread_t thread;
+    batch_ring *ring;
+    run_stats stats;
+    topk_heap top;
+} batch_thread;
+
+
+
+
+
+
+/*==============================================================================
+                                  PARSE RECORD
+--------------------------------------------------------------------------------
+*   Splits one line of input into numbers.  Fields may be separated by any mix
+*   of whitespace, commas and semicolons; anything past the first max fields is
+*   ignored.  Returns the number of fields read, 0 for a blank or comment ('#')
+*   line, or -1 if a field isn't a number.
+*
+*   Params
+*       char *p         |   Start of the line
+*       char *end       |   End of the line
+*       double *nums    |   Where to store the numbers
+*       int max         |   Size of nums
+*/
+static int parse_record( const char *p, const char *end, double *nums,
+        int max )
+{
+    int count = 0;
+    const char *field;
+
+    while( count < max )
+    {
+        while( p < end && is_delim( *p ))
+            ++p;
+
+        if( p == end )
+            break;
+
+        field = p;
+        while( p < end && ! is_delim( *p ))
+            ++p;
+
+        if( count == 0 && *field == '#' )
+            return( 0 );
+
+        if( muzz_parse_double( field, p - field, &nums[ count ] ))
+            return( -1 );
+
+        ++count;
+    }
+
+    return( count );
+}
+
+
+
+/*==============================================================================
+                                  PARSE TAGGED
+--------------------------------------------------------------------------------
+*   parse_record(), for '--tagged':  any number may end in its units (see
+*   unitTags).  A record with none is read just as it is otherwise and goes
+*   in the default bucket.  One with units has them on every number, all
+*   Imperial or all Si, and the quantities it has decide what it solves for
+*   (see tagTargets); its numbers are put in command line order for that.
+*   Returns the number of fields, 0 for a blank or comment line, -1 if a
+*   field isn't a number, or BAD_TAGS.
+*
+*   Params
+*       char *p         |   Start of the line
+*       char *end       |   End of the line
+*       double *nums    |   Where to store the numbers (at least 3)
+*       unsigned char *tag  |   Where to put the record's bucket
+*       int defaultTag  |   Bucket of a record without units
+*/
+static int parse_tagged( const char *p, const char *end, double *nums,
+        unsigned char *tag, int defaultTag )
+{
+    double vals[ BIN_COLS ];
+    unsigned int mask = 0;
+    const char *field;
+    const char *unit;
+    int count = 0;
+    int tagged = 0;
+    int si = -1;
+    size_t t;
+    int i;
+
+    while( count < 3 )
+    {
+        while( p < end && is_delim( *p ))
+            ++p;
+
+        if( p == end )
+            break;
+
+        field = p;
+        while( p < end && ! is_delim( *p ))
+            ++p;
+
+        if( count == 0 && *field == '#' )
+            return( 0 );
+
+        /*  The number, then its units, if it has any */
+        for( unit = field; unit < p && ( isdigit( (unsigned char)*unit )
+                    || strchr( "+-.eE", *unit ) != NULL ); ++unit )
+            ;
+
+        if( muzz_parse_double( field, unit - field, &nums[ count ] ))
+            return( -1 );
+
+        if( unit == p )
+        {
+            ++count;
+            continue;
+        }
+
+        for( t = 0; t < TOTAL_UNIT_TAGS; ++t )
+            if( strlen( unitTags[t].name ) == (size_t)( p - unit )
+                    && strncasecmp( unitTags[t].name, unit, p - unit ) == 0 )
+                break;
+
+        /*  Unknown, twice over, or Imperial and Si together */
+        if( t == TOTAL_UNIT_TAGS || ( mask & ( 1u << unitTags[t].col ))
+                || ( si >= 0 && si != unitTags[t].si ))
+            return( BAD_TAGS );
+
+        mask |= 1u << unitTags[t].col;
+        vals[ unitTags[t].col ] = nums[ count ];
+        si = unitTags[t].si;
+        ++tagged;
+        ++count;
+    }
+
+    *tag = defaultTag;
+    if( tagged == 0 )
+        return( count );
+
+    if( tagged < count )
+        return( BAD_TAGS );
+
+    for( t = 0; t < TOTAL_TAG_TARGETS; ++t )
+    {
+        if( tagTargets[t].mask != mask )
+            continue;
+
+        for( i = 0; i < count; ++i )
+            nums[i] = vals[ tagTargets[t].inputs[i] ];
+
+        *tag = TAG_BUCKET( si, tagTargets[t].solve );
+        return( count );
+    }
+
+    return( BAD_TAGS );
+}
+
+
+
+/*==============================================================================
+                                    TAKE KEY
+--------------------------------------------------------------------------------
+*   Takes the first field of a line as its key, for '--group'.  Returns where
+*   the rest of the line starts.  The key is left empty for a blank or
+*   comment line.
+*/
+static const char *take_key( const char *p, const char *end,
+        const char **key, size_t *keyLen )
+{
+    *keyLen = 0;
+
+    while( p < end && is_delim( *p ))
+        ++p;
+
+    if( p == end || *p == '#' )
+        return( end );
+
+    *key = p;
+    while( p < end && ! is_delim( *p ))
+        ++p;
+
+    *keyLen = p - *key;
+    return( p );
+}
+
+
+
+/*==============================================================================
+                                      GROW
+--------------------------------------------------------------------------------
+*   Makes sure a buffer has room for at least 'need' items, growing it in an
+*   arena, or on the heap if a is NULL.  Returns 0 if it does, -1 if we ran
+*   out of memory.
+*/
+static int grow( arena *a, void **buf, size_t *cap, size_t need,
+        size_t itemSize )
+{
+    size_t newCap = ( *cap ? *cap : 64 );
+    void *p;
+
+    if( need <= *cap )
+        return( 0 );
+
+    while( newCap < need )
+        newCap *= 2;
+
+    if( a != NULL )
+        p = arena_grow( a, *buf, *cap * itemSize, newCap * itemSize );
+    else
+        p = heap_realloc( *buf, newCap * itemSize );
+
+    if( p == NULL )
+        return( -1 );
+
+    *buf = p;
+    *cap = newCap;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  WORKER INIT
+--------------------------------------------------------------------------------
+*   Sets up a worker for a job and allocates its columns.  Returns 0, or -1
+*   (with w->res NULL) if we're out of memory.
+*/
+static int worker_init( batch_worker *w, const batch_job *job )
+{
+    w->binOut = job->binOut;
+    w->orderBase = job->orderBase;
+    w->lineCols = job->lineCols;
+    w->lineOut = ( job->lineCols != NULL ? &job->lineOut : NULL );
+    w->summary = job->sumCols;
+    w->group = job->group;
+    w->needEnergy = job->needEnergy;
+    w->energyFrom[0] = job->energyFrom[0];
+    w->energyFrom[1] = job->energyFrom[1];
+    w->target = job->target;
+    w->tests = job->tests;
+    w->numTests = job->numTests;
+    w->top = job->top;
+    w->topSource = job->topSource;
+    w->topLow = job->topLow;
+    w->fields = job->fields;
+    w->distances = job->distances;
+    w->drag = job->drag;
+    w->tags = NULL;
+    w->defaultTag = job->defaultTag;
+    w->tagCtx = ( job->tagged ? job->tagCtx : NULL );
+    w->tagPlans = ( job->tagged ? job->tagPlans : NULL );
+    w->stats = NULL;
+
+    arena_init( &w->mem );
+    w->res = arena_alloc( &w->mem, 11 * BATCH_CHUNK * sizeof( double ));
+    w->groups = arena_alloc( &w->mem, 2 * BATCH_CHUNK * sizeof( *w->groups ));
+    w->index = arena_alloc( &w->mem, BATCH_CHUNK * sizeof( *w->index ));
+    if( job->tagged )
+        w->tags = arena_alloc( &w->mem, BATCH_CHUNK );
+
+    if( w->res == NULL || w->groups == NULL || w->index == NULL
+            || ( job->tagged && w->tags == NULL ))
+    {
+        w->res = NULL;
+        return( -1 );
+    }
+
+    w->cols[0] = w->res + BATCH_CHUNK;
+    w->cols[1] = w->cols[0] + BATCH_CHUNK;
+    w->cols[2] = w->cols[1] + BATCH_CHUNK;
+    w->cols[3] = w->cols[2] + BATCH_CHUNK;
+    w->energy = w->cols[3] + BATCH_CHUNK;
+    w->range = w->energy + BATCH_CHUNK;
+    w->recs[0] = w->range + BATCH_CHUNK;
+    w->recs[1] = w->recs[0] + BATCH_CHUNK;
+    w->recs[2] = w->recs[1] + BATCH_CHUNK;
+    w->recs[3] = w->recs[2] + BATCH_CHUNK;
+    w->recGroups = w->groups + BATCH_CHUNK;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  GET COLUMN
+--------------------------------------------------------------------------------
+*   Copies n little-endian doubles out of a (possibly unaligned) column.
+*/
+static void get_column( double *dst, const char *src, size_t n )
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy( dst, src, n * sizeof( double ));
+#else
+    uint64_t bits;
+    size_t i;
+
+    for( i = 0; i < n; ++i )
+    {
+        memcpy( &bits, src + i * 8, 8 );
+        bits = __builtin_bswap64( bits );
+        memcpy( &dst[i], &bits, 8 );
+    }
+#endif
+}
+
+
+
+/*==============================================================================
+                                  PUT COLUMN
+--------------------------------------------------------------------------------
+*   Copies n doubles into a column, little-endian.
+*/
+static void put_column( char *dst, const double *src, size_t n )
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy( dst, src, n * sizeof( double ));
+#else
+    uint64_t bits;
+    size_t i;
+
+    for( i = 0; i < n; ++i )
+    {
+        memcpy( &bits, &src[i], 8 );
+        bits = __builtin_bswap64( bits );
+        memcpy( dst + i * 8, &bits, 8 );
+    }
+#endif
+}
+
+
+
+/*==============================================================================
+                                 SOURCE COLUMN
+--------------------------------------------------------------------------------
+*   The column of the current chunk that something comes from.
+*/
+static const double *source_column( const batch_worker *w, int source )
+{
+    if( source == FROM_RESULT )
+        return( w->res );
+
+    if( source == FROM_ENERGY )
+        return( w->energy );
+
+    if( source == FROM_RANGE )
+        return( w->range );
+
+    return( w->cols[ source ] );
+}
+
+
+
+/*==============================================================================
+                                     TEST
+--------------------------------------------------------------------------------
+*   Whether x meets a condition; == is any of its numbers, != none of them.
+*/
+static int test( const batch_test *t, double x )
+{
+    int i;
+
+    switch( t->op )
+    {
+        case BATCH_LT:  return( x < t->values[0] );
+        case BATCH_LE:  return( x <= t->values[0] );
+        case BATCH_GT:  return( x > t->values[0] );
+        case BATCH_GE:  return( x >= t->values[0] );
+    }
+
+    for( i = 0; i < t->numValues; ++i )
+        if( x == t->values[i] )
+            return( t->op == BATCH_EQ );
+
+    return( t->op != BATCH_EQ );
+}
+
+
+
+/*==============================================================================
+                                  FILTER CHUNK
+--------------------------------------------------------------------------------
+*   Drops the records of a chunk that don't meet every '--where' condition,
+*   moving the rest up, and notes where each one was.  Returns how many are
+*   left.
+*/
+static size_t filter_chunk( batch_worker *w, size_t n )
+{
+    const batch_test *t;
+    size_t kept = 0;
+    size_t i;
+    int d;
+
+    for( i = 0; i < n; ++i )
+    {
+        for( t = w->tests; t < w->tests + w->numTests; ++t )
+            if( ! test( t, source_column( w, t->source )[i] ))
+                break;
+
+        if( t < w->tests + w->numTests )
+            continue;
+
+        for( d = 0; d < 3; ++d )
+            w->cols[d][ kept ] = w->cols[d][i];
+        w->res[ kept ] = w->res[i];
+        w->energy[ kept ] = w->energy[i];
+        w->range[ kept ] = w->range[i];
+        w->groups[ kept ] = w->groups[i];
+        w->index[ kept ] = i;
+        ++kept;
+    }
+
+    return( kept );
+}
+
+
+
+/*==============================================================================
+                                   TOP CHUNK
+--------------------------------------------------------------------------------
+*   Offers a chunk of results to the worker's top-K.  Returns 0, or -1 if
+*   we're out of memory.
+*
+*   Params
+*       batch_worker *w     |   The worker, with the chunk
+*       size_t n            |   Records in the chunk
+*       uint64_t first      |   Where the chunk starts in the input
+*/
+static int top_chunk( batch_worker *w, size_t n, uint64_t first )
+{
+    const double *by = source_column( w, w->topSource );
+    topk_row row;
+    uint64_t order;
+    double key;
+    size_t i;
+
+    for( i = 0; i < n; ++i )
+    {
+        key = ( w->topLow ? -by[i] : by[i] );
+        order = first + ( w->numTests > 0 ? w->index[i] : i );
+
+        /*  Not a number can't be ranked */
+        if( isnan( key ) || ! topk_wants( w->top, key, order ))
+            continue;
+
+        row.key = key;
+        row.order = order;
+        row.vals[0] = w->cols[0][i];
+        row.vals[1] = w->cols[1][i];
+        row.vals[2] = w->cols[2][i];
+        row.vals[3] = w->res[i];
+        row.vals[4] = w->range[i];
+
+        if( topk_offer( w->top, &row ))
+            return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   PUT FRAME
+--------------------------------------------------------------------------------
+*   Writes a chunk of results onto the block's output as a frame of columns.
+*   Returns 0, or -1 if we're out of memory.
+*/
+static int put_frame( batch_worker *w, size_t n, batch_block *b )
+{
+    const batch_layout *l = w->binOut;
+    uint64_t rows = n;
+    char *p;
+    int i;
+
+    if( n == 0 )
+        return( 0 );
+
+    if( grow( &b->mem, (void **)&b->out, &b->outCap,
+                b->outLen + 8 + n * 8 * l->numCols, 1 ))
+        return( -1 );
+
+    p = b->out + b->outLen;
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    rows = __builtin_bswap64( rows );
+#endif
+    memcpy( p, &rows, 8 );
+    p += 8;
+
+    for( i = 0; i < l->numCols; ++i, p += n * 8 )
+        put_column( p, source_column( w, l->sources[i] ), n );
+
+    b->outLen = p - b->out;
+
+    if( w->stats != NULL )
+        stats_lap( w->stats, STAT_FORMAT, &w->lap );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   PUT LINES
+--------------------------------------------------------------------------------
+*   Writes a chunk of results onto the block's output as CSV or NDJSON lines,
+*   through the run's template.  Returns 0, or -1 if we're out of memory.
+*/
+static int put_lines( batch_worker *w, size_t n, batch_block *b )
+{
+    const batch_layout *l = w->lineCols;
+    const double *cols[ BIN_COLS ];
+    double values[ BIN_COLS ];
+    size_t max = fmt_template_max( w->lineOut );
+    size_t i;
+    int c;
+
+    for( c = 0; c < l->numCols; ++c )
+        cols[c] = source_column( w, l->sources[c] );
+
+    for( i = 0; i < n; ++i )
+    {
+        if( grow( &b->mem, (void **)&b->out, &b->outCap, b->outLen + max, 1 ))
+            return( -1 );
+
+        for( c = 0; c < l->numCols; ++c )
+            values[c] = cols[c][i];
+
+        b->outLen = fmt_template_write( w->lineOut, values,
+                b->out + b->outLen ) - b->out;
+    }
+
+    if( w->stats != NULL )
+        stats_lap( w->stats, STAT_FORMAT, &w->lap );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   SUM CHUNK
+--------------------------------------------------------------------------------
+*   Adds a chunk of results to the block's summary.  Unless records have
+*   keys, they all go in the one group.  Returns 0, or -1 if we're out of
+*   memory.
+*/
+static int sum_chunk( batch_worker *w, size_t n, batch_block *b )
+{
+    const batch_layout *l = w->summary;
+    summary_group *all;
+    size_t i;
+    int c;
+
+    if( ! w->group )
+    {
+        all = summary_find( &b->sum, "", 0 );
+        if( all == NULL )
+            return( -1 );
+
+        for( i = 0; i < n; ++i )
+            w->groups[i] = all;
+    }
+
+    for( c = 0; c < l->numCols; ++c )
+        if( summary_add_n( &b->sum, w->groups, c,
+                    source_column( w, l->sources[c] ), n ))
+            return( -1 );
+
+    if( w->stats != NULL )
+        stats_lap( w->stats, STAT_FORMAT, &w->lap );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   EMIT CHUNK
+--------------------------------------------------------------------------------
+*   Formats a chunk of results onto the block's output, as text, a frame or
+*   CSV or NDJSON lines.  Returns 0, or -1 if we're out of memory.
+*/
+static int emit_chunk( const muzz_ctx *ctx, batch_worker *w, size_t n,
+        batch_block *b )
+{
+    double nums[ 3 ];
+    muzz_shot shot;
+    size_t i;
+
+    if( w->binOut != NULL )
+        return( put_frame( w, n, b ));
+
+    if( w->lineOut != NULL )
+        return( put_lines( w, n, b ));
+
+    for( i = 0; i < n; ++i )
+    {
+        /*  '--tagged':  each record is printed in its own units */
+        if( w->tags != NULL )
+            ctx = &w->tagCtx[ w->tags[i] ];
+
+        nums[0] = w->cols[0][i];
+        nums[1] = w->cols[1][i];
+        nums[2] = w->cols[2][i];
+
+        muzz_shot_inputs( ctx, &shot, nums );
+        *muzz_shot_wanted( ctx, &shot ) = w->res[i];
+
+        if( grow( &b->mem, (void **)&b->out, &b->outCap,
+                    b->outLen + RANGE_PREFIX_MAX + MUZZ_FORMAT_MAX, 1 ))
+            return( -1 );
+
+        if( w->distances != NULL && ctx->verbose )
+            b->outLen += snprintf( b->out + b->outLen, RANGE_PREFIX_MAX,
+                    "%g %s:  ", w->range[i],
+                    colUnits[ ctx->si != 0 ][ BIN_RANGE ] );
+
+        b->outLen += muzz_format( ctx, &shot, b->out + b->outLen,
+                MUZZ_FORMAT_MAX );
+    }
+
+    if( w->stats != NULL )
+        stats_lap( w->stats, STAT_FORMAT, &w->lap );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  RUN BUCKETS
+--------------------------------------------------------------------------------
+*   '--tagged':  runs a chunk of records that needn't have the same units or
+*   target.  They're sorted into their buckets (a counting sort, so each
+*   bucket keeps input order), each bucket goes through its own plan in one
+*   call, and the results are put back where the records came from.
+*/
+static void run_buckets( batch_worker *w, size_t n )
+{
+    size_t start[ TAG_BUCKETS + 1 ];
+    size_t at[ TAG_BUCKETS ];
+    size_t i;
+    size_t k;
+    int t;
+    int d;
+
+    memset( start, 0, sizeof( start ));
+    for( i = 0; i < n; ++i )
+        ++start[ w->tags[i] + 1 ];
+
+    for( t = 0; t < TAG_BUCKETS; ++t )
+    {
+        start[ t + 1 ] += start[t];
+        at[t] = start[t];
+    }
+
+    /*  recs[] is free; it's only for '--drag' */
+    for( i = 0; i < n; ++i )
+    {
+        k = at[ w->tags[i] ]++;
+        for( d = 0; d < 3; ++d )
+            w->recs[d][k] = w->cols[d][i];
+        w->index[k] = i;
+    }
+
+    for( t = 0; t < TAG_BUCKETS; ++t )
+        if( start[ t + 1 ] > start[t] )
+            muzz_plan_run( &w->tagPlans[t], w->recs[0] + start[t],
+                    w->recs[1] + start[t], w->recs[2] + start[t],
+                    w->recs[3] + start[t], start[ t + 1 ] - start[t] );
+
+    for( k = 0; k < n; ++k )
+        w->res[ w->index[k] ] = w->recs[3][k];
+}
+
+
+
+/*==============================================================================
+                                   RUN CHUNK
+--------------------------------------------------------------------------------
+*   Runs the plan over a chunk of records, drops any that don't meet the
+*   '--where' conditions, and formats, summarizes or ranks the rest.  With
+*   '--drag', the velocities are the muzzle velocities until they've been
+*   taken downrange here.  Returns 0, or -1 if we're out of memory.
+*/
+static int run_chunk( const muzz_ctx *ctx, const muzz_plan *plan,
+        batch_worker *w, size_t n, batch_block *b )
+{
+    /*  Where the chunk is in the input, to break ties in a top-K */
+    uint64_t first = w->orderBase + ( (uint64_t)b->number << ORDER_ROW_BITS )
+        + w->row;
+
+    /*  Everything since the last chunk was parsing */
+    if( w->stats != NULL )
+        stats_lap( w->stats, STAT_PARSE, &w->lap );
+
+    w->row += n;
+    if( w->distances != NULL )
+        muzz_downrange_n( ctx, w->drag, w->cols[3], w->cols[1], w->range,
+                w->cols[1], n );
+
+    if( w->tags != NULL )
+        run_buckets( w, n );
+    else
+        muzz_plan_run( plan, w->cols[0], w->cols[1], w->cols[2], w->res, n );
+
+    if( w->needEnergy )
+        muzz_get_energy_n( ctx, source_column( w, w->energyFrom[0] ),
+                source_column( w, w->energyFrom[1] ), w->energy, n );
+
+    if( w->stats != NULL )
+    {
+        w->stats->records += n;
+        stats_lap( w->stats, STAT_COMPUTE, &w->lap );
+    }
+
+    if( w->numTests > 0 )
+        n = filter_chunk( w, n );
+
+    if( w->summary != NULL )
+        return( sum_chunk( w, n, b ));
+
+    if( w->top != NULL )
+    {
+        if( top_chunk( w, n, first ))
+            return( -1 );
+
+        if( w->stats != NULL )
+            stats_lap( w->stats, STAT_FORMAT, &w->lap );
+
+        return( 0 );
+    }
+
+    return( emit_chunk( ctx, w, n, b ));
+}
+
+
+
+/*==============================================================================
+                                  FLUSH CHUNK
+--------------------------------------------------------------------------------
+*   Runs a chunk of records.  With '--target', the target goes in as their
+*   last input first.  With '--drag', each record is first spread out into a
+*   row for every distance, its BC in cols[3], and the rows are run a chunk
+*   at a time instead.  Returns 0, or -1 if we're out of memory.
+*/
+static int flush_chunk( const muzz_ctx *ctx, const muzz_plan *plan,
+        batch_worker *w, size_t n, batch_block *b )
+{
+    const batch_range *dist = w->distances;
+    int inputs = w->fields - 1;
+    size_t m = 0;
+    size_t i;
+    uint64_t j;
+    int d;
+
+    if( w->target != NULL )
+        for( i = 0; i < n; ++i )
+            w->cols[ w->fields ][i] = *w->target;
+
+    if( dist == NULL )
+        return( run_chunk( ctx, plan, w, n, b ));
+
+    /*  Out of the way of the rows */
+    for( d = 0; d < w->fields; ++d )
+        memcpy( w->recs[d], w->cols[d], n * sizeof( double ));
+    memcpy( w->recGroups, w->groups, n * sizeof( *w->groups ));
+
+    for( i = 0; i < n; ++i )
+    {
+        for( j = 0; j < dist->count; ++j )
+        {
+            for( d = 0; d < 3; ++d )
+                w->cols[d][m] = ( d < inputs ? w->recs[d][i] : -1 );
+
+            w->cols[3][m] = w->recs[ inputs ][i];
+            w->range[m] = dist->start + j * dist->step;
+            w->groups[m] = w->recGroups[i];
+
+            if( ++m == BATCH_CHUNK )
+            {
+                if( run_chunk( ctx, plan, w, m, b ))
+                    return( -1 );
+                m = 0;
+            }
+        }
+    }
+
+    return( run_chunk( ctx, plan, w, m, b ));
+}
+
+
+
+/*==============================================================================
+                                 PROCESS SWEEP
+--------------------------------------------------------------------------------
+*   Works out, calculates and formats a block of cells of a sweep.  The last
+*   range changes fastest, the first slowest.  Returns 0, or -1 if we're out
+*   of memory.
+*/
+static int process_sweep( const muzz_ctx *ctx, const muzz_plan *plan,
+        batch_worker *w, batch_block *b )
+{
+    const batch_range *r = b->sweep;
+    int dims = w->fields;
+    uint64_t idx[ 4 ] = { 0, 0, 0, 0 };
+    uint64_t cell = b->first;
+    uint64_t left = b->cells;
+    size_t n;
+    int d;
+
+    b->lines = 0;
+    b->outLen = 0;
+    b->numErrors = 0;
+
+    if( w->stats != NULL )
+        stats_start( &w->lap );
+
+    /*  Where the first cell of the block is in each range */
+    for( d = dims - 1; d >= 0; --d )
+    {
+        idx[d] = cell % r[d].count;
+        cell /= r[d].count;
+    }
+
+    while( left > 0 )
+    {
+        for( n = 0; n < BATCH_CHUNK && n < left; ++n )
+        {
+            for( d = 0; d < 4; ++d )
+                w->cols[d][n] = ( d < dims ?
+                        r[d].start + idx[d] * r[d].step : -1 );
+
+            /*  Move on to the next cell, carrying as we go */
+            for( d = dims - 1; d >= 0; --d )
+            {
+                if( ++idx[d] < r[d].count )
+                    break;
+                idx[d] = 0;
+            }
+        }
+
+        if( flush_chunk( ctx, plan, w, n, b ))
+            return( -1 );
+
+        left -= n;
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   PROCESS MC
+--------------------------------------------------------------------------------
+*   Draws and calculates (or summarizes) a block of Monte Carlo samples.
+*   Returns 0, or -1 if we're out of memory.
+*/
+static int process_mc( const muzz_ctx *ctx, const muzz_plan *plan,
+        batch_worker *w, batch_block *b )
+{
+    const batch_dist *dists = b->dists;
+    int dims = w->fields;
+    uint64_t sample;
+    size_t n;
+    size_t i;
+    int d;
+
+    b->lines = 0;
+    b->outLen = 0;
+    b->numErrors = 0;
+
+    if( w->stats != NULL )
+        stats_start( &w->lap );
+
+    for( sample = b->first; sample < b->first + b->cells; sample += n )
+    {
+        n = ( b->first + b->cells - sample < BATCH_CHUNK ?
+                b->first + b->cells - sample : BATCH_CHUNK );
+
+        for( d = 0; d < dims; ++d )
+            mc_normals( w->cols[d], n, b->seed, d, sample, dists[d].mean,
+                    dists[d].sd );
+        for( ; d < 4; ++d )
+            for( i = 0; i < n; ++i )
+                w->cols[d][i] = -1;
+
+        if( flush_chunk( ctx, plan, w, n, b ))
+            return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 PROCESS FRAME
+--------------------------------------------------------------------------------
+*   Calculates and formats a frame of binary columns.  Returns 0, or -1 if
+*   we're out of memory.
+*/
+static int process_frame( const muzz_ctx *ctx, const muzz_plan *plan,
+        batch_worker *w, batch_block *b )
+{
+    const batch_layout *l = b->layout;
+    const char *col;
+    uint64_t row;
+    size_t n;
+    int d;
+
+    b->lines = 0;
+    b->outLen = 0;
+    b->numErrors = 0;
+
+    if( w->stats != NULL )
+        stats_start( &w->lap );
+
+    for( row = 0; row < b->rows; row += n )
+    {
+        n = ( b->rows - row < BATCH_CHUNK ? b->rows - row : BATCH_CHUNK );
+
+        for( d = 0; d < w->fields; ++d )
+        {
+            col = b->data + l->inputs[d] * b->rows * 8;
+            get_column( w->cols[d], col + row * 8, n );
+        }
+
+        if( flush_chunk( ctx, plan, w, n, b ))
+            return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 PROCESS BLOCK
+--------------------------------------------------------------------------------
+*   Parses, calculates and formats (or summarizes) a whole block.  Bad
+*   records are noted in the block for the writer to report.  Returns 0, or
+*   -1 if we're out of memory.
+*
+*   Params
+*       muzz_ctx *ctx       |   Program options
+*       muzz_plan *plan     |   Compute plan made from ctx
+*       batch_worker *w     |   Scratch columns
+*       batch_block *b      |   The block
+*/
+static int process_block( const muzz_ctx *ctx, const muzz_plan *plan,
+        batch_worker *w, batch_block *b )
+{
+    if( w->summary != NULL )
+        summary_init( &b->sum, w->summary->numCols, &b->mem );
+
+    w->row = 0;
+    if( b->sweep != NULL )
+        return( process_sweep( ctx, plan, w, b ));
+
+    if( b->dists != NULL )
+        return( process_mc( ctx, plan, w, b ));
+
+    if( b->layout != NULL )
+        return( process_frame( ctx, plan, w, b ));
+
+    const char *p = b->data;
+    const char *end = b->data + b->len;
+    const char *lineEnd;
+    const char *key = NULL;
+    size_t keyLen = 0;
+    int needed = w->fields;
+    double nums[ 4 ];
+    int count;
+    size_t n = 0;
+
+    b->lines = 0;
+    b->outLen = 0;
+    b->numErrors = 0;
+
+    if( w->stats != NULL )
+        stats_start( &w->lap );
+
+    while( p < end )
+    {
+        lineEnd = memchr( p, '\n', end - p );
+        if( lineEnd == NULL )
+            lineEnd = end;
+
+        ++b->lines;
+        nums[2] = nums[3] = -1;
+        if( w->group )
+            p = take_key( p, lineEnd, &key, &keyLen );
+
+        if( w->tags != NULL )
+        {
+            count = parse_tagged( p, lineEnd, nums, &w->tags[n],
+                    w->defaultTag );
+            needed = ( count > 0 ? muzz_inputs( &w->tagCtx[ w->tags[n] ] )
+                    : w->fields );
+        }
+        else
+            count = parse_record( p, lineEnd, nums, ( needed > 3 ? 4 : 3 ));
+        p = lineEnd + 1;
+
+        /*  Blank line or comment */
+        if( count == 0 && keyLen == 0 )
+            continue;
+
+        if( count < needed )
+        {
+            if( grow( &b->mem, (void **)&b->errors, &b->errorCap,
+                        b->numErrors + 1, sizeof( batch_error )))
+                return( -1 );
+
+            b->errors[ b->numErrors ].line = b->lines;
+            b->errors[ b->numErrors ].count = count;
+            ++b->numErrors;
+            continue;
+        }
+
+        w->cols[0][n] = nums[0];
+        w->cols[1][n] = nums[1];
+        w->cols[2][n] = nums[2];
+        w->cols[3][n] = nums[3];
+
+        if( w->group
+                && ( w->groups[n] = summary_find( &b->sum, key, keyLen ))
+                == NULL )
+            return( -1 );
+
+        if( ++n == BATCH_CHUNK )
+        {
+            if( flush_chunk( ctx, plan, w, n, b ))
+                return( -1 );
+            n = 0;
+        }
+    }
+
+    return( flush_chunk( ctx, plan, w, n, b ));
+}
+
+
+
+/*==============================================================================
+                                  SWEEP BLOCK
+--------------------------------------------------------------------------------
+*   The next block of cells of a sweep, or samples of a Monte Carlo run.
+*   Returns 1 if there's a block, 0 once we've been through the whole grid.
+*/
+static int sweep_block( batch_reader *r, batch_block *b )
+{
+    uint64_t left = r->sweepCells - r->sweepPos;
+
+    if( left == 0 )
+        return( 0 );
+
+    b->sweep = r->sweep;
+    b->dists = r->dists;
+    b->seed = r->seed;
+    b->first = r->sweepPos;
+    b->cells = ( left < SWEEP_BLOCK ? left : SWEEP_BLOCK );
+    r->sweepPos += b->cells;
+    return( 1 );
+}
+
+
+
+/*==============================================================================
+                                   READ INPUT
+--------------------------------------------------------------------------------
+*   read(), on the input:  the bytes we looked at to see if it was compressed,
+*   then the rest, decompressed if it is.
+*/
+static ssize_t read_input( batch_reader *r, char *buf, size_t len )
+{
+    size_t n;
+
+    if( r->peekPos < r->peekLen )
+    {
+        n = r->peekLen - r->peekPos;
+        n = ( len < n ? len : n );
+        memcpy( buf, r->peek + r->peekPos, n );
+        r->peekPos += n;
+        return( n );
+    }
+
+    if( r->z != NULL )
+        return( zstream_read( r->z, buf, len ));
+
+    return( read( r->fd, buf, len ));
+}
+
+
+
+/*==============================================================================
+                                   READ FULL
+--------------------------------------------------------------------------------
+*   Reads exactly len bytes, unless the input ends first.  Returns how many
+*   it got, or -1 if a read fails.
+*/
+static ssize_t read_full( batch_reader *r, char *buf, size_t len )
+{
+    size_t done = 0;
+    ssize_t got;
+
+    while( done < len )
+    {
+        got = read_input( r, buf + done, len - done );
+        if( got < 0 && errno == EINTR )
+            continue;
+
+        if( got < 0 )
+            return( -1 );
+
+        if( got == 0 )
+            break;
+
+        done += got;
+    }
+
+    return( done );
+}
+
+
+
+/*==============================================================================
+                                  FRAME BLOCK
+--------------------------------------------------------------------------------
+*   The next frame of a column file, from the mapping or read into the
+*   block's own buffer.  Returns 1 if there's a frame, 0 at the end of the
+*   input (or at a bad frame, see r->badFrame), or -1 if we're out of memory.
+*/
+static int frame_block( batch_reader *r, batch_block *b )
+{
+    char head[ 8 ];
+    uint64_t rows;
+    uint64_t bytes;
+    ssize_t got;
+
+    if( r->map != NULL )
+    {
+        if( r->mapPos >= r->mapLen )
+            return( 0 );
+
+        if( r->mapLen - r->mapPos < 8 )
+            goto bad;
+
+        memcpy( head, r->map + r->mapPos, 8 );
+    }
+
+    else
+    {
+        got = read_full( r, head, 8 );
+        if( got < 0 )
+            r->error = 1;
+        if( got <= 0 )
+            return( 0 );
+        if( got < 8 )
+            goto bad;
+    }
+
+    memcpy( &rows, head, 8 );
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    rows = __builtin_bswap64( rows );
+#endif
+
+    if( rows > BIN_FRAME_MAX / 8 / r->layout->numCols )
+        goto bad;
+
+    bytes = rows * 8 * r->layout->numCols;
+    b->layout = r->layout;
+    b->rows = rows;
+    b->len = bytes;
+
+    if( r->map != NULL )
+    {
+        if( r->mapLen - r->mapPos - 8 < bytes )
+            goto bad;
+
+        b->data = r->map + r->mapPos + 8;
+        r->mapPos += 8 + bytes;
+        return( 1 );
+    }
+
+    if( grow( &b->mem, (void **)&b->text, &b->cap, bytes, 1 ))
+        return( -1 );
+
+    got = read_full( r, b->text, bytes );
+    if( got < 0 )
+        r->error = 1;
+    if( got < (ssize_t)bytes )
+        goto bad;
+
+    b->data = b->text;
+    return( 1 );
+
+bad:
+    r->badFrame = 1;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  SLICE BLOCK
+--------------------------------------------------------------------------------
+*   The next block of a mapped file:  about BLOCK_SIZE bytes of it, stretched
+*   to the end of the line.  Returns 1 if there's a block, 0 at the end.
+*/
+static int slice_block( batch_reader *r, batch_block *b )
+{
+    size_t end = r->mapPos + BLOCK_SIZE;
+    const char *nl;
+
+    if( r->mapPos >= r->mapLen )
+        return( 0 );
+
+    if( end >= r->mapLen )
+        end = r->mapLen;
+
+    else
+    {
+        nl = memchr( r->map + end, '\n', r->mapLen - end );
+        end = ( nl == NULL ? r->mapLen : (size_t)( nl + 1 - r->map ));
+    }
+
+    b->data = r->map + r->mapPos;
+    b->len = end - r->mapPos;
+    r->mapPos = end;
+    return( 1 );
+}
+
+
+
+/*==============================================================================
+                                   FILL BLOCK
+--------------------------------------------------------------------------------
+*   Reads the next block of whole lines.  We take whatever the input has ready
+*   (up to BLOCK_SIZE) rather than waiting for a full block, so records coming
+*   down a pipe don't sit around.  Whatever's after the last newline is kept
+*   back for the next block, unless it's the end of the input.  Returns 1 if
+*   there's a block, 0 at the end of the input, -1 if we're out of memory.
+*/
+static int fill_block( batch_reader *r, batch_block *b )
+{
+    ssize_t got;
+    char *nl;
+
+    /*  Whatever was in the block before is finished with */
+    arena_reset( &b->mem );
+    b->text = b->out = NULL;
+    b->errors = NULL;
+    b->cap = b->outCap = b->errorCap = 0;
+
+    if( r->sweep != NULL || r->dists != NULL )
+        return( sweep_block( r, b ));
+
+    if( r->layout != NULL )
+        return( frame_block( r, b ));
+
+    if( r->map != NULL )
+        return( slice_block( r, b ));
+
+    b->data = b->text;
+    b->len = 0;
+
+    if( r->carryLen > 0 )
+    {
+        if( grow( &b->mem, (void **)&b->text, &b->cap, r->carryLen, 1 ))
+            return( -1 );
+
+        memcpy( b->text, r->carry, r->carryLen );
+        b->len = r->carryLen;
+        r->carryLen = 0;
+    }
+
+    while( ! r->eof )
+    {
+        if( grow( &b->mem, (void **)&b->text, &b->cap, b->len + BLOCK_SIZE, 1 ))
+            return( -1 );
+
+        got = read_input( r, b->text + b->len, BLOCK_SIZE );
+        if( got < 0 && errno == EINTR )
+            continue;
+
+        if( got <= 0 )
+        {
+            r->error = ( got < 0 );
+            r->eof = 1;
+            break;
+        }
+
+        nl = memrchr( b->text + b->len, '\n', got );
+        b->len += got;
+
+        /*  No newline yet; one very long line, keep reading */
+        if( nl == NULL )
+            continue;
+
+        /*  Save whatever's after the last newline for next time */
+        r->carryLen = b->len - ( nl + 1 - b->text );
+        if( grow( NULL, (void **)&r->carry, &r->carryCap, r->carryLen, 1 ))
+            return( -1 );
+
+        memcpy( r->carry, nl + 1, r->carryLen );
+        b->len -= r->carryLen;
+        break;
+    }
+
+    /*  Following a file, a line without its newline is still being written */
+    if( r->follow && r->eof && b->len > 0 )
+    {
+        nl = memrchr( b->text, '\n', b->len );
+        r->carryLen = b->len - ( nl == NULL ? 0 : nl + 1 - b->text );
+        if( r->carryLen > 0 && grow( NULL, (void **)&r->carry, &r->carryCap,
+                    r->carryLen, 1 ))
+            return( -1 );
+
+        if( r->carryLen > 0 )
+            memcpy( r->carry, b->text + b->len - r->carryLen, r->carryLen );
+        b->len -= r->carryLen;
+    }
+
+    b->data = b->text;
+    return( b->len > 0 );
+}
+
+
+
+/*==============================================================================
+                                   READ BLOCK
+--------------------------------------------------------------------------------
+*   fill_block(), timed if we're keeping stats.
+*/
+static int read_block( batch_reader *r, batch_block *b, run_stats *stats )
+{
+    stats_time t;
+    int more;
+
+    if( stats != NULL )
+        stats_start( &t );
+
+    more = fill_block( r, b );
+    if( more > 0 && r->blocks == r->maxBlocks )
+    {
+        r->tooBig = 1;
+        more = 0;
+    }
+
+    if( more > 0 )
+        b->number = r->blocks++;
+
+    if( stats != NULL )
+    {
+        stats_lap( stats, STAT_READ, &t );
+        if( more > 0 )
+            stats->bytesIn += b->len;
+    }
+
+    return( more );
+}
+
+
+
+/*==============================================================================
+                                   WRITE ALL
+--------------------------------------------------------------------------------
+*   Writes a whole buffer to a file descriptor, however many write()s that
+*   takes.  Returns 0, or -1 if the write fails.
+*/
+static int write_all( int fd, const char *buf, size_t len )
+{
+    ssize_t done;
+
+    while( len > 0 )
+    {
+        done = write( fd, buf, len );
+        if( done < 0 && errno == EINTR )
+            continue;
+
+        if( done <= 0 )
+            return( -1 );
+
+        buf += done;
+        len -= done;
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   PUT OUTPUT
+--------------------------------------------------------------------------------
+*   Sends results on their way:  straight to stdout, or to be compressed
+*   first.  Returns 0, or -1 if the write fails.
+*/
+static int put_output( const batch_job *job, const char *buf, size_t len )
+{
+    if( job->zout != NULL )
+        return( zstream_write( job->zout, buf, len ));
+
+    return( write_all( STDOUT_FILENO, buf, len ));
+}
+
+
+
+/*==============================================================================
+                                  WRITE ERROR
+--------------------------------------------------------------------------------
+*   Says why put_output() failed, from errno, so call it straight after.
+*   Compressed output is left to zstream_close() to report, since that's
+*   where the error ends up.
+*/
+static void write_error( const batch_job *job )
+{
+    if( job->zout == NULL )
+        fprintf( stderr, "muzz: write error: %s\n", strerror( errno ));
+}
+
+
+
+/*==============================================================================
+                                  WRITE BLOCK
+--------------------------------------------------------------------------------
+*   Prints a block's results (or adds its summary to the run's), and reports
+*   its bad records.  Returns 1 if the block had any bad records, 0 if not,
+*   -1 if we ran out of memory or WRITE_FAILED if the output couldn't be
+*   written (which has been reported).
+*
+*   Params
+*       batch_job *job      |   The run
+*       batch_block *b      |   A processed block
+*       unsigned long *line |   Lines before this block; updated
+*       run_stats *stats    |   Where to count, or NULL
+*/
+static int write_block( const batch_job *job, const batch_block *b,
+        unsigned long *line, run_stats *stats )
+{
+    int needed = job->fields;
+    stats_time t;
+    size_t i;
+
+    if( stats != NULL )
+    {
+        stats_start( &t );
+        stats->bytesOut += b->outLen;
+        stats->rejected += b->numErrors;
+    }
+
+    if( put_output( job, b->out, b->outLen ))
+    {
+        write_error( job );
+        return( WRITE_FAILED );
+    }
+
+    if( job->summary != NULL && summary_merge( job->summary, &b->sum ))
+        return( -1 );
+
+    for( i = 0; i < b->numErrors; ++i )
+    {
+        fprintf( stderr, "ERROR:  %s:%lu:  ", job->name,
+                *line + b->errors[i].line );
+        if( b->errors[i].count == BAD_TAGS )
+            fprintf( stderr, "Units don't make a shot (or aren't known)\n" );
+        else if( b->errors[i].count < 0 )
+            fprintf( stderr, "Invalid number\n" );
+        else
+            fprintf( stderr, "Need %d parameters\n", needed );
+    }
+
+    *line += b->lines;
+
+    if( stats != NULL )
+        stats_lap( stats, STAT_WRITE, &t );
+
+    return( b->numErrors > 0 );
+}
+
+
+
+/*==============================================================================
+                                   FREE BLOCK
+--------------------------------------------------------------------------------
+*   Frees a block's buffers.
+*/
+static void free_block( batch_block *b )
+{
+    arena_free( &b->mem );
+}
+
+
+
+/*==============================================================================
+                                  RUN SERIAL
+--------------------------------------------------------------------------------
+*   Batch mode on this thread alone:  read, process and write a block at a
+*   time.
+*/
+static int run_serial( batch_reader *r, const batch_job *job )
+{
+    batch_block b;
+    batch_worker w;
+    unsigned long line = 0;
+    int status = 0;
+    int more;
+    int bad;
+
+    memset( &b, 0, sizeof( b ));
+    if( worker_init( &w, job ))
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        arena_free( &w.mem );
+        return( 1 );
+    }
+    w.stats = job->stats;
+
+    while( ( more = read_block( r, &b, job->stats )) > 0 )
+    {
+        if( process_block( job->ctx, job->plan, &w, &b )
+                || ( bad = write_block( job, &b, &line, job->stats )) == -1 )
+        {
+            more = -1;
+            break;
+        }
+
+        if( bad == WRITE_FAILED )
+        {
+            status = 1;
+            break;
+        }
+
+        status |= bad;
+    }
+
+    if( more < 0 )
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        status = 1;
+    }
+
+    arena_free( &w.mem );
+    free_block( &b );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                   RING KICK
+--------------------------------------------------------------------------------
+*   Lets any thread sleeping in ring_wait() know that something's changed.
+*   Only costs a system call if someone actually is asleep.
+*/
+static void ring_kick( batch_ring *ring )
+{
+    atomic_fetch_add( &ring->epoch, 1 );
+
+    if( atomic_load( &ring->sleepers ) > 0 )
+        syscall( SYS_futex, &ring->epoch, FUTEX_WAKE_PRIVATE, INT_MAX,
+                NULL, NULL, 0 );
+}
+
+
+
+/*==============================================================================
+                                   RING POST
+--------------------------------------------------------------------------------
+*   Hands a block on to the next stage by giving it a new stamp.
+*/
+static void ring_post( batch_ring *ring, batch_block *b, uint32_t stamp )
+{
+    atomic_store_explicit( &b->stamp, stamp, memory_order_release );
+    ring_kick( ring );
+}
+
+
+
+/*==============================================================================
+                                   RING WAIT
+--------------------------------------------------------------------------------
+*   Waits for block n's slot to get the given stamp:  spins for a little
+*   while, then sleeps until something changes.  Returns 1 once it has, or,
+*   if untilEnd is set, 0 if the reader finished without reaching block n.
+*/
+static int ring_wait( batch_ring *ring, unsigned long n, uint32_t stamp,
+        int untilEnd )
+{
+    batch_block *b = &ring->slots[ n % ring->numSlots ];
+    unsigned int epoch;
+    int spins;
+
+    for( spins = 0; ; ++spins )
+    {
+        /*  Read the epoch first, so a change after this can't be missed */
+        epoch = atomic_load( &ring->epoch );
+
+        if( atomic_load_explicit( &b->stamp, memory_order_acquire ) == stamp )
+            return( 1 );
+
+        if( untilEnd && n >= atomic_load( &ring->total ))
+            return( 0 );
+
+        if( spins < RING_SPINS )
+        {
+            cpu_relax();
+            continue;
+        }
+
+        atomic_fetch_add( &ring->sleepers, 1 );
+        if( atomic_load( &ring->epoch ) == epoch )
+            syscall( SYS_futex, &ring->epoch, FUTEX_WAIT_PRIVATE, epoch,
+                    NULL, NULL, 0 );
+        atomic_fetch_sub( &ring->sleepers, 1 );
+    }
+}
+
+
+
+/*==============================================================================
+                                  WORKER MAIN
+--------------------------------------------------------------------------------
+*   Worker thread:  claims the next block number, waits for the reader to
+*   fill it, processes it and hands it to the writer, until the reader's
+*   finished.
+*/
+static void *worker_main( void *arg )
+{
+    batch_thread *self = arg;
+    batch_ring *ring = self->ring;
+    batch_worker w;
+    batch_block *b;
+    unsigned long n;
+    int failed;
+
+    worker_init( &w, ring->job );
+
+    if( ring->job->stats != NULL )
+        w.stats = &self->stats;
+
+    if( ring->job->top != NULL )
+        w.top = &self->top;
+
+    for( ;; )
+    {
+        n = atomic_fetch_add( &ring->nextWork, 1 );
+        if( ! ring_wait( ring, n, STAMP( n, STAMP_FILLED ), 1 ))
+            break;
+
+        b = &ring->slots[ n % ring->numSlots ];
+        failed = ( w.res == NULL || process_block( ring->job->ctx,
+                    ring->job->plan, &w, b ));
+
+        if( failed )
+        {
+            /*  Still pass it along (with nothing in it) to keep order */
+            b->outLen = b->numErrors = 0;
+            b->sum.numGroups = 0;
+            atomic_store( &ring->failed, 1 );
+        }
+
+        ring_post( ring, b, STAMP( n, STAMP_DONE ));
+    }
+
+    arena_free( &w.mem );
+    return( NULL );
+}
+
+
+
+/*==============================================================================
+                                  WRITER MAIN
+--------------------------------------------------------------------------------
+*   Writer thread:  prints blocks in the order they were read, freeing up
+*   their slots for the reader.  A slow reader of our output holds this up,
+*   which in turn holds up the reader once the ring's full.  Once a write
+*   fails, the rest are only freed, and the reader stops.
+*/
+static void *writer_main( void *arg )
+{
+    batch_thread *self = arg;
+    batch_ring *ring = self->ring;
+    batch_block *b;
+    unsigned long line = 0;
+    unsigned long n;
+    int bad;
+
+    for( n = 0; ring_wait( ring, n, STAMP( n, STAMP_DONE ), 1 ); ++n )
+    {
+        b = &ring->slots[ n % ring->numSlots ];
+
+        bad = 0;
+        if( ! atomic_load( &ring->unwritten ))
+            bad = write_block( ring->job, b, &line,
+                    ( ring->job->stats != NULL ? &self->stats : NULL ));
+
+        if( bad == WRITE_FAILED )
+            atomic_store( &ring->unwritten, 1 );
+        else if( bad < 0 )
+            atomic_store( &ring->failed, 1 );
+        else if( bad )
+            atomic_store( &ring->bad, 1 );
+
+        ring_post( ring, b, STAMP( n + ring->numSlots, STAMP_FREE ));
+    }
+
+    return( NULL );
+}
+
+
+
+/*==============================================================================
+                                 RUN THREADED
+--------------------------------------------------------------------------------
+*   Batch mode with 'jobs' worker threads plus a writer, this thread being the
+*   reader.
+*/
+static int run_threaded( batch_reader *r, const batch_job *job )
+{
+    int jobs = job->jobs;
+    batch_ring ring;
+    batch_thread *threads;      //  Workers, then the writer
+    batch_thread reader;
+    batch_block *b;
+    unsigned long n = 0;
+    int started = 0;
+    int status = 0;
+    int more = 0;
+    int i;
+
+    memset( &ring, 0, sizeof( ring ));
+    memset( &reader, 0, sizeof( reader ));
+    ring.job = job;
+    ring.numSlots = (unsigned long)jobs * SLOTS_PER_JOB;
+    ring.slots = heap_alloc( ring.numSlots * sizeof( batch_block ));
+    threads = heap_alloc( ( jobs + 1 ) * sizeof( batch_thread ));
+
+    if( ring.slots != NULL )
+        memset( ring.slots, 0, ring.numSlots * sizeof( batch_block ));
+    if( threads != NULL )
+        memset( threads, 0, ( jobs + 1 ) * sizeof( batch_thread ));
+
+    atomic_init( &ring.nextWork, 0 );
+    atomic_init( &ring.total, ULONG_MAX );
+    atomic_init( &ring.failed, 0 );
+    atomic_init( &ring.unwritten, 0 );
+    atomic_init( &ring.bad, 0 );
+    atomic_init( &ring.epoch, 0 );
+    atomic_init( &ring.sleepers, 0 );
+
+    if( ring.slots == NULL || threads == NULL )
+        goto out;
+
+    for( n = 0; n < ring.numSlots; ++n )
+        atomic_init( &ring.slots[n].stamp, STAMP( n, STAMP_FREE ));
+
+    for( i = 0; i <= jobs; ++i )
+    {
+        threads[i].ring = &ring;
+        topk_init( &threads[i].top, ( job->top != NULL ? job->top->k : 0 ));
+    }
+
+    for( started = 0; started < jobs; ++started )
+        if( pthread_create( &threads[ started ].thread, NULL, worker_main,
+                    &threads[ started ] ))
+            break;
+
+    if( started == 0 || pthread_create( &threads[ jobs ].thread, NULL,
+                writer_main, &threads[ jobs ] ))
+    {
+        /*  Couldn't get any threads going; let whoever did start finish */
+        atomic_store( &ring.total, 0 );
+        ring_kick( &ring );
+
+        for( i = 0; i < started; ++i )
+            pthread_join( threads[i].thread, NULL );
+
+        started = 0;
+        goto out;
+    }
+
+    /*  Read blocks into free slots until we run out of input, or can't
+     *  write the output */
+    for( n = 0; ! atomic_load( &ring.unwritten ); ++n )
+    {
+        ring_wait( &ring, n, STAMP( n, STAMP_FREE ), 0 );
+        b = &ring.slots[ n % ring.numSlots ];
+
+        more = read_block( r, b, ( job->stats != NULL ? &reader.stats : NULL ));
+        if( more <= 0 )
+            break;
+
+        ring_post( &ring, b, STAMP( n, STAMP_FILLED ));
+    }
+
+    if( more < 0 )
+        atomic_store( &ring.failed, 1 );
+
+    atomic_store( &ring.total, n );
+    ring_kick( &ring );
+
+    for( i = 0; i < started; ++i )
+        pthread_join( threads[i].thread, NULL );
+    pthread_join( threads[ jobs ].thread, NULL );
+
+    if( job->stats != NULL )
+    {
+        stats_merge( job->stats, &reader.stats );
+        for( i = 0; i <= jobs; ++i )
+            stats_merge( job->stats, &threads[i].stats );
+    }
+
+    /*  Each worker's best, into the best of the lot */
+    if( job->top != NULL )
+        for( i = 0; i < jobs; ++i )
+            if( topk_merge( job->top, &threads[i].top ))
+                atomic_store( &ring.failed, 1 );
+
+out:
+    status = atomic_load( &ring.bad ) | atomic_load( &ring.unwritten );
+    if( started == 0 || atomic_load( &ring.failed ))
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        status = 1;
+    }
+
+    if( ring.slots != NULL )
+        for( n = 0; n < ring.numSlots; ++n )
+            free_block( &ring.slots[n] );
+
+    if( threads != NULL )
+        for( i = 0; i < jobs; ++i )
+            topk_free( &threads[i].top );
+
+    heap_free( ring.slots );
+    heap_free( threads );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                  ORDER BLOCKS
+--------------------------------------------------------------------------------
+*   How many blocks a run can read before its rows' places in a top-K run
+*   out of bits (see ORDER_ROW_BITS); any number, without a top-K.
+*/
+static unsigned long order_blocks( const batch_job *job )
+{
+    if( job->top == NULL )
+        return( ULONG_MAX );
+
+    if( job->partial )
+        return( 1UL << ( SHARD_SHIFT - ORDER_ROW_BITS ));
+
+    return( 1UL << ( 64 - ORDER_ROW_BITS ));
+}
+
+
+
+/*==============================================================================
+                                   TOO BIG
+--------------------------------------------------------------------------------
+*   Reports a reader stopped by order_blocks().
+*/
+static void too_big( const batch_job *job )
+{
+    fprintf( stderr, "ERROR:  %s:  Too big to rank with '--top'%s\n",
+            job->name, ( job->partial ? "; try more shards" : "" ));
+}
+
+
+
+/*==============================================================================
+                                      RUN
+--------------------------------------------------------------------------------
+*   Runs blocks from a reader through to stdout, on this thread or on 'jobs'
+*   worker threads.
+*/
+static int run( batch_reader *r, const batch_job *job )
+{
+    int status;
+
+    r->maxBlocks = order_blocks( job );
+
+    if( job->jobs > 1 )
+        status = run_threaded( r, job );
+    else
+        status = run_serial( r, job );
+
+    if( r->tooBig )
+    {
+        too_big( job );
+        status = 1;
+    }
+
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                  SHOT COLUMNS
+--------------------------------------------------------------------------------
+*   Which columns a record's inputs are, in command line order, and which
+*   column is the answer.  Returns the answer's column.
+*/
+static int shot_columns( const muzz_ctx *ctx, int *inputs )
+{
+    switch( ctx->solve )
+    {
+        case MUZZ_SOLVE_MASS:
+            inputs[0] = BIN_VELOCITY;
+            inputs[1] = BIN_ENERGY;
+            return( BIN_MASS );
+
+        case MUZZ_SOLVE_VELOCITY:
+            inputs[0] = BIN_MASS;
+            inputs[1] = BIN_ENERGY;
+            return( BIN_VELOCITY );
+
+        case MUZZ_SOLVE_TKOF:
+            inputs[0] = BIN_MASS;
+            inputs[1] = BIN_VELOCITY;
+            inputs[2] = BIN_DIAMETER;
+            return( BIN_TKOF );
+
+        case MUZZ_SOLVE_TKOF_MASS:
+            inputs[0] = BIN_VELOCITY;
+            inputs[1] = BIN_DIAMETER;
+            inputs[2] = BIN_TKOF;
+            return( BIN_MASS );
+
+        case MUZZ_SOLVE_TKOF_VELOCITY:
+            inputs[0] = BIN_MASS;
+            inputs[1] = BIN_DIAMETER;
+            inputs[2] = BIN_TKOF;
+            return( BIN_VELOCITY );
+
+        default:
+            inputs[0] = BIN_MASS;
+            inputs[1] = BIN_VELOCITY;
+            return( BIN_ENERGY );
+    }
+}
+
+
+
+/*==============================================================================
+                                   LAYOUT IN
+--------------------------------------------------------------------------------
+*   Works out where the first few of our inputs are in a column file with
+*   the given columns.  Returns 0, or the first input that isn't there plus
+*   one.
+*/
+static int layout_in( batch_layout *l, unsigned int mask, const muzz_ctx *ctx,
+        int inputs )
+{
+    int cols[ 3 ];
+    int i;
+
+    shot_columns( ctx, cols );
+    l->mask = mask;
+    l->numCols = __builtin_popcount( mask );
+
+    for( i = 0; i < inputs; ++i )
+    {
+        if( ! ( mask & ( 1u << cols[i] )))
+            return( cols[i] + 1 );
+
+        l->inputs[i] = __builtin_popcount( mask & ( ( 1u << cols[i] ) - 1 ));
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 COLUMN SOURCE
+--------------------------------------------------------------------------------
+*   Where a column (enum BinColumn) comes from in this mode:  one of the
+*   inputs, the answer, the energy worked out on the side, the range with
+*   '--drag' (downrange), or FROM_NONE.
+*/
+static int column_source( const muzz_ctx *ctx, int col, int downrange )
+{
+    int cols[ 3 ];
+    int result = shot_columns( ctx, cols );
+    int i;
+
+    if( col == result )
+        return( FROM_RESULT );
+
+    if( col == BIN_RANGE && downrange )
+        return( FROM_RANGE );
+
+    for( i = 0; i < muzz_inputs( ctx ); ++i )
+        if( cols[i] == col )
+            return( i );
+
+    if( col == BIN_ENERGY && muzz_knockout( ctx ))
+        return( FROM_ENERGY );
+
+    return( FROM_NONE );
+}
+
+
+
+/*==============================================================================
+                                   LAYOUT OUT
+--------------------------------------------------------------------------------
+*   The columns we write (or summarize):  the inputs and the answer, in file
+*   order.  A summary of TKOF gets the energy as well, since chronograph
+*   strings are judged on both.  Downrange rows get their range, unless
+*   they're being summarized.
+*
+*   Params
+*       batch_layout *l     |   Where to put the layout
+*       muzz_ctx *ctx       |   Program options
+*       int summary         |   1 if it's for a summary
+*       int downrange       |   1 with '--drag'
+*/
+static void layout_out( batch_layout *l, const muzz_ctx *ctx, int summary,
+        int downrange )
+{
+    int cols[ 3 ];
+    int result = shot_columns( ctx, cols );
+    int c;
+    int i;
+
+    l->mask = 1u << result;
+    for( i = 0; i < muzz_inputs( ctx ); ++i )
+        l->mask |= 1u << cols[i];
+
+    if( summary && muzz_knockout( ctx ))
+        l->mask |= 1u << BIN_ENERGY;
+
+    if( downrange && ! summary )
+        l->mask |= 1u << BIN_RANGE;
+
+    l->numCols = 0;
+    for( c = 0; c < BIN_COLS; ++c )
+        if( l->mask & ( 1u << c ))
+            l->sources[ l->numCols++ ] = column_source( ctx, c, downrange );
+}
+
+
+
+/*==============================================================================
+                                  READ HEADER
+--------------------------------------------------------------------------------
+*   Reads and checks the header of a column file, and works out the layout
+*   of the inputs a record has.  Complains and returns -1 if it's no good.
+*/
+static int read_header( batch_reader *r, batch_layout *l, const char *name,
+        const muzz_ctx *ctx, int inputs )
+{
+    char head[ BIN_HEADER ];
+    uint32_t mask;
+    int missing;
+
+    if( r->map != NULL && r->mapLen >= BIN_HEADER )
+    {
+        memcpy( head, r->map, BIN_HEADER );
+        r->mapPos = BIN_HEADER;
+    }
+
+    else if( r->map != NULL || read_full( r, head, BIN_HEADER )
+            != BIN_HEADER )
+    {
+        fprintf( stderr, "ERROR:  %s:  Not a column file\n", name );
+        return( -1 );
+    }
+
+    mask = (uint32_t)(unsigned char)head[8]
+        | (uint32_t)(unsigned char)head[9] << 8
+        | (uint32_t)(unsigned char)head[10] << 16
+        | (uint32_t)(unsigned char)head[11] << 24;
+
+    if( memcmp( head, BIN_MAGIC, 8 ) != 0 || mask == 0
+            || mask >= ( 1u << BIN_COLS ))
+    {
+        fprintf( stderr, "ERROR:  %s:  Not a column file\n", name );
+        return( -1 );
+    }
+
+    missing = layout_in( l, mask, ctx, inputs );
+    if( missing )
+    {
+        fprintf( stderr, "ERROR:  %s:  No %s column\n", name,
+                colNames[ missing - 1 ] );
+        return( -1 );
+    }
+
+    r->layout = l;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  WRITE HEADER
+--------------------------------------------------------------------------------
+*   Writes the header of a column file to the output.  Returns 0, or -1.
+*/
+static int write_header( const batch_job *job, const batch_layout *l )
+{
+    char head[ BIN_HEADER ];
+
+    memset( head, 0, sizeof( head ));
+    memcpy( head, BIN_MAGIC, 8 );
+    head[8] = (char)( l->mask & 0xff );
+
+    if( put_output( job, head, sizeof( head )))
+    {
+        write_error( job );
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  MAKE LINES
+--------------------------------------------------------------------------------
+*   Lays out the CSV or NDJSON line for a run's columns, and writes the CSV
+*   header if asked.  Numbers get two decimals, or three with '-p' (a
+*   diameter in inches always has three).  Returns 0, or -1 if we can't
+*   write.
+*
+*   Params
+*       batch_job *job      |   The run; its lineOut is set up
+*       batch_layout *l     |   Its output columns
+*       int format          |   BATCH_CSV or BATCH_NDJSON
+*       int header          |   1 to write the header
+*/
+static int make_lines( batch_job *job, const batch_layout *l, int format,
+        int header )
+{
+    fmt_template *t = &job->lineOut;
+    char head[ FMT_TEMPLATE_TEXT ];
+    size_t headLen = 0;
+    const char *name;
+    int si = ( job->ctx->si != 0 );
+    int decimals;
+    int n = 0;
+    int c;
+
+    fmt_template_init( t, ( format == BATCH_NDJSON ? "null" : NULL ));
+    if( format == BATCH_NDJSON )
+        fmt_template_text( t, "{" );
+
+    for( c = 0; c < BIN_COLS; ++c )
+    {
+        if( ! ( l->mask & ( 1u << c )))
+            continue;
+
+        name = fieldNames[ si ][c];
+        decimals = ( job->ctx->precise || ( c == BIN_DIAMETER && ! si )
+                ? 3 : 2 );
+
+        if( format == BATCH_NDJSON )
+        {
+            fmt_template_text( t, ( n > 0 ? ",\"" : "\"" ));
+            fmt_template_text( t, name );
+            fmt_template_text( t, "\":" );
+        }
+        else
+        {
+            if( n > 0 )
+                head[ headLen++ ] = ',';
+            memcpy( head + headLen, name, strlen( name ));
+            headLen += strlen( name );
+
+            if( n > 0 )
+                fmt_template_text( t, "," );
+        }
+
+        fmt_template_slot( t, n++, decimals );
+    }
+
+    fmt_template_text( t, ( format == BATCH_NDJSON ? "}\n" : "\n" ));
+
+    if( format == BATCH_CSV && header )
+    {
+        head[ headLen++ ] = '\n';
+        if( put_output( job, head, headLen ))
+        {
+            write_error( job );
+            return( -1 );
+        }
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  FIND SOURCE
+--------------------------------------------------------------------------------
+*   Where a column a condition or '--top' refers to comes from.  Complains
+*   and returns FROM_NONE if there's no such column in this mode.
+*/
+static int find_source( const muzz_ctx *ctx, int col, int downrange )
+{
+    int source = column_source( ctx, col, downrange );
+
+    if( source == FROM_NONE )
+        fprintf( stderr, "ERROR:  No %s to compare with\n", colNames[ col ] );
+
+    return( source );
+}
+
+
+
+/*==============================================================================
+                                    MAKE JOB
+--------------------------------------------------------------------------------
+*   Sets up what's the same for every block of a run, and writes the header
+*   if the output's binary or CSV (and this is the first shard, if any).
+*   Returns 0, or -1 if a condition doesn't make sense in this mode or we
+*   can't write.
+*
+*   Params
+*       batch_job *job      |   The job to set up
+*       muzz_plan *plan     |   Where to keep its compute plan
+*       batch_layout *out   |   Where to keep its output (or summary) columns
+*       summary_table *sum  |   Where to keep its summary, if it has one
+*       topk_heap *top      |   Where to keep its top-K, if it has one
+*       muzz_ctx *ctx       |   Program options
+*       batch_opts *opts    |   Threads, formats, conditions and stats
+*/
+static int make_job( batch_job *job, muzz_plan *plan, batch_layout *out,
+        summary_table *sum, topk_heap *top, const muzz_ctx *ctx,
+        const batch_opts *opts )
+{
+    int downrange = ( opts->distances != NULL );
+    batch_test *t;
+    int i;
+
+    muzz_plan_init( plan, ctx );
+    if( opts->stats != NULL )
+        opts->stats->kernels = plan->isa;
+
+    memset( job, 0, sizeof( *job ));
+    job->ctx = ctx;
+    job->plan = plan;
+    job->fields = muzz_inputs( ctx ) + downrange - ( opts->target != NULL );
+    job->target = opts->target;
+    job->energyFrom[0] = column_source( ctx, BIN_MASS, downrange );
+    job->energyFrom[1] = column_source( ctx, BIN_VELOCITY, downrange );
+    job->distances = opts->distances;
+    job->drag = opts->drag;
+    job->jobs = opts->jobs;
+    job->partial = ( opts->shards > 0 && ( opts->summary != SUMMARY_OFF
+                || opts->top > 0 ));
+    job->orderBase = (uint64_t)opts->shard << SHARD_SHIFT;
+
+    /*  '--tagged':  a context and plan for every unit and target */
+    job->tagged = opts->tagged;
+    job->defaultTag = TAG_BUCKET( ctx->si != 0, ctx->solve );
+    for( i = 0; job->tagged && i < TAG_BUCKETS; ++i )
+    {
+        job->tagCtx[i] = *ctx;
+        job->tagCtx[i].si = i / 4;
+        job->tagCtx[i].solve = i % 4;
+        muzz_ctx_resolve( &job->tagCtx[i] );
+        muzz_plan_init( &job->tagPlans[i], &job->tagCtx[i] );
+    }
+    job->stats = opts->stats;
+
+    for( i = 0; i < opts->numWhere && i < BATCH_WHERE_MAX; ++i )
+    {
+        t = &job->tests[ job->numTests++ ];
+        t->source = find_source( ctx, opts->where[i].col, downrange );
+        t->op = opts->where[i].op;
+        t->numValues = opts->where[i].numValues;
+        memcpy( t->values, opts->where[i].values, sizeof( t->values ));
+
+        if( t->source == FROM_NONE )
+            return( -1 );
+        if( t->source == FROM_ENERGY )
+            job->needEnergy = 1;
+    }
+
+    if( opts->top > 0 )
+    {
+        job->topSource = ( opts->topCol < 0 ? FROM_RESULT :
+                find_source( ctx, opts->topCol, downrange ));
+        job->topLow = opts->topLow;
+
+        if( job->topSource == FROM_NONE )
+            return( -1 );
+        if( job->topSource == FROM_ENERGY )
+            job->needEnergy = 1;
+
+        topk_init( top, opts->top );
+        job->top = top;
+    }
+
+    if( opts->summary != SUMMARY_OFF )
+    {
+        layout_out( out, ctx, 1, downrange );
+        summary_init( sum, out->numCols, NULL );
+        job->sumCols = out;
+        job->summary = sum;
+        job->group = opts->group;
+
+        for( i = 0; i < out->numCols; ++i )
+            if( out->sources[i] == FROM_ENERGY )
+                job->needEnergy = 1;
+    }
+
+    /*  '--compress':  from here on, output goes through its own thread */
+    if( opts->compress != ZFORMAT_NONE && ( job->zout = zstream_writer(
+                    STDOUT_FILENO, opts->compress )) == NULL )
+        return( -1 );
+
+    if( opts->summary == SUMMARY_OFF && opts->output == BATCH_BINARY )
+    {
+        layout_out( out, ctx, 0, downrange );
+        job->binOut = out;
+        if( opts->shard == 0 && ! job->partial && write_header( job, out ))
+            return( -1 );
+    }
+
+    if( opts->summary == SUMMARY_OFF && ( opts->output == BATCH_CSV
+                || opts->output == BATCH_NDJSON ))
+    {
+        layout_out( out, ctx, 0, downrange );
+        job->lineCols = out;
+        if( make_lines( job, out, opts->output,
+                    ( opts->shard == 0 && ! job->partial )))
+            return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   PRINT TOP
+--------------------------------------------------------------------------------
+*   Prints the rows of a top-K, best first, a chunk at a time just as they'd
+*   have been printed in the first place.  The heap is sorted, so it's no
+*   good for anything after.  Returns 0, -1 if we're out of memory or
+*   WRITE_FAILED if the output couldn't be written.
+*
+*   Params
+*       batch_job *job      |   The run
+*       topk_heap *h        |   Its top-K, or a copy
+*/
+static int print_top( const batch_job *job, topk_heap *h )
+{
+    batch_worker w;
+    batch_block b;
+    size_t done;
+    size_t n;
+    size_t i;
+    int status = 0;
+
+    topk_sort( h );
+    memset( &b, 0, sizeof( b ));
+    arena_init( &b.mem );
+
+    if( worker_init( &w, job ))
+        status = -1;
+
+    for( done = 0; status == 0 && done < h->count; done += n )
+    {
+        n = ( h->count - done < BATCH_CHUNK ? h->count - done : BATCH_CHUNK );
+
+        for( i = 0; i < n; ++i )
+        {
+            w.cols[0][i] = h->rows[ done + i ].vals[0];
+            w.cols[1][i] = h->rows[ done + i ].vals[1];
+            w.cols[2][i] = h->rows[ done + i ].vals[2];
+            w.res[i] = h->rows[ done + i ].vals[3];
+            w.range[i] = h->rows[ done + i ].vals[4];
+        }
+
+        b.outLen = 0;
+        if( emit_chunk( job->ctx, &w, n, &b ))
+            status = -1;
+
+        else if( put_output( job, b.out, b.outLen ))
+        {
+            write_error( job );
+            status = WRITE_FAILED;
+        }
+
+        else if( job->stats != NULL )
+            job->stats->bytesOut += b.outLen;
+    }
+
+    arena_free( &w.mem );
+    free_block( &b );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                 PRINT SUMMARY
+--------------------------------------------------------------------------------
+*   Prints the run's summary so far, with the names and units of its columns.
+*   Returns 0, or WRITE_FAILED if it couldn't be written.
+*
+*   Params
+*       batch_job *job      |   The run
+*       batch_opts *opts    |   Whether it's wanted in JSON
+*/
+static int print_summary( const batch_job *job, const batch_opts *opts )
+{
+    const char *names[ BIN_COLS ];
+    const char *units[ BIN_COLS ];
+    const batch_layout *l = job->sumCols;
+    int n = 0;
+    int c;
+
+    for( c = 0; c < BIN_COLS; ++c )
+    {
+        if( ! ( l->mask & ( 1u << c )))
+            continue;
+
+        names[n] = colNames[c];
+        units[n] = colUnits[ job->ctx->si != 0 ][c];
+        ++n;
+    }
+
+    summary_print( job->summary, stdout, ( opts->summary == SUMMARY_JSON ),
+            names, units );
+
+    if( fflush( stdout ) == EOF || ferror( stdout ))
+    {
+        fprintf( stderr, "muzz: write error: %s\n", strerror( errno ));
+        return( WRITE_FAILED );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   RUN PRINT
+--------------------------------------------------------------------------------
+*   '--shard':  a fingerprint of everything a partial's head doesn't already
+*   say about the run:  its input (job->input), how it's read, and the
+*   '--where' conditions, '--target' and '--drag' distances.  Shards of
+*   different runs have different ones, so 'muzz merge' won't mix them.
+*/
+static uint64_t run_print( const batch_job *job, const batch_opts *opts )
+{
+    uint64_t p = job->input;
+    int i;
+    int v;
+
+    p = partial_print_u64( p, opts->input );
+    p = partial_print_u64( p, ( opts->tagged != 0 ));
+
+    p = partial_print_u64( p, opts->numWhere );
+    for( i = 0; i < opts->numWhere; ++i )
+    {
+        p = partial_print_u64( p, opts->where[i].col );
+        p = partial_print_u64( p, opts->where[i].op );
+        p = partial_print_u64( p, opts->where[i].numValues );
+        for( v = 0; v < opts->where[i].numValues; ++v )
+            p = partial_print_f64( p, opts->where[i].values[v] );
+    }
+
+    p = partial_print_u64( p, ( opts->target != NULL ));
+    if( opts->target != NULL )
+        p = partial_print_f64( p, *opts->target );
+
+    if( opts->distances != NULL )
+    {
+        p = partial_print_f64( p, opts->distances->start );
+        p = partial_print_f64( p, opts->distances->step );
+        p = partial_print_u64( p, opts->distances->count );
+        p = partial_print_u64( p, opts->drag );
+    }
+
+    return( p );
+}
+
+
+
+/*==============================================================================
+                                 WRITE PARTIAL
+--------------------------------------------------------------------------------
+*   '--shard':  writes the shard's summary or top-K to stdout as a partial,
+*   headed with what it takes to print it once it's merged.  Returns 0, or
+*   -1 if it couldn't be written.
+*/
+static int write_partial( const batch_job *job, const batch_opts *opts )
+{
+    const muzz_ctx *ctx = job->ctx;
+    partial_head h;
+    int status;
+
+    memset( &h, 0, sizeof( h ));
+    h.shard = opts->shard;
+    h.shards = opts->shards;
+    h.kind = ( job->top != NULL ? PARTIAL_TOP : PARTIAL_SUMMARY );
+    h.si = ( ctx->si != 0 );
+    h.solve = ctx->solve;
+    h.kMode = ctx->kMode;
+    memcpy( &h.customK, &ctx->customK, sizeof( h.customK ));
+    h.verbose = ( ctx->verbose != 0 );
+    h.precise = ( ctx->precise != 0 );
+    h.fast = ( ctx->fast != 0 );
+    h.summary = opts->summary;
+    h.group = ( opts->group != 0 );
+    h.output = opts->output;
+    h.downrange = ( opts->distances != NULL );
+    h.top = opts->top;
+    h.topCol = (uint64_t)( opts->topCol + 1 );
+    h.topLow = ( opts->topLow != 0 );
+    h.numCols = ( job->sumCols != NULL ? job->sumCols->numCols : 0 );
+    h.run = run_print( job, opts );
+
+    if( job->top != NULL )
+        status = partial_put_head( stdout, &h ) || topk_save( job->top,
+                stdout );
+    else
+        status = partial_put_head( stdout, &h ) || summary_save( job->summary,
+                stdout );
+
+    if( fflush( stdout ) != 0 )
+        status = 1;
+
+    return( status ? -1 : 0 );
+}
+
+
+
+/*==============================================================================
+                                  FINISH JOB
+--------------------------------------------------------------------------------
+*   Prints the run's summary or top-K, if it has one (or, for a shard,
+*   writes its partial), and frees it, then finishes off the compressed
+*   output, if there is any.  Returns 0, or 1 if
+*   we ran out of memory or the output couldn't be written.
+*/
+static int finish_job( batch_job *job, const batch_opts *opts )
+{
+    int status = 0;
+
+    /*  '--shard':  the summary or top-K is saved for 'muzz merge' */
+    if( job->partial && write_partial( job, opts ))
+    {
+        fprintf( stderr, "ERROR:  Could not write the partial result\n" );
+        status = 1;
+    }
+
+    if( job->partial && job->top != NULL )
+        topk_free( job->top );
+
+    else if( job->partial )
+        summary_free( job->summary );
+
+    else if( job->top != NULL )
+    {
+        status = print_top( job, job->top );
+        if( status == -1 )
+            fprintf( stderr, "ERROR:  Out of memory\n" );
+        status = ( status != 0 );
+
+        topk_free( job->top );
+    }
+
+    else if( job->summary != NULL )
+    {
+        status = ( print_summary( job, opts ) != 0 );
+        summary_free( job->summary );
+    }
+
+    if( job->zout != NULL && zstream_close( job->zout ))
+    {
+        fprintf( stderr, "ERROR:  Could not write the %s output\n",
+                zstream_name( opts->compress ));
+        status = 1;
+    }
+
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                  SHARD START
+--------------------------------------------------------------------------------
+*   Where shard i of n starts, of total things:  total * i / n, without
+*   overflowing on the way.
+*/
+static uint64_t shard_start( uint64_t total, uint64_t i, uint64_t n )
+{
+    return( (uint64_t)( (unsigned __int128)total * i / n ));
+}
+
+
+
+/*==============================================================================
+                                  SHARD BOUND
+--------------------------------------------------------------------------------
+*   Where shard i of n of a file starts:  the start of the first line that
+*   starts at or after the i'th n'th of its bytes.  So a line belongs to the
+*   shard its first byte is in, and the shards never overlap or leave gaps.
+*/
+static size_t shard_bound( const char *map, size_t len, int i, int n )
+{
+    size_t pos = shard_start( len, i, n );
+    const char *nl;
+
+    if( pos == 0 || pos == len || map[ pos - 1 ] == '\n' )
+        return( pos );
+
+    nl = memchr( map + pos, '\n', len - pos );
+    return( nl == NULL ? len : (size_t)( nl + 1 - map ));
+}
+
+
+
+/*==============================================================================
+                                   SHARD FILE
+--------------------------------------------------------------------------------
+*   '--shard':  narrows a mapped file down to this shard's lines.  Returns 0,
+*   or complains and returns -1 if the input isn't a file we can split up.
+*/
+static int shard_file( batch_reader *r, const char *name,
+        const batch_opts *opts )
+{
+    size_t start;
+
+    if( r->map == NULL || r->z != NULL )
+    {
+        fprintf( stderr, "ERROR:  %s:  --shard needs an uncompressed file ",
+                name );
+        fprintf( stderr, "to split up\n" );
+        return( -1 );
+    }
+
+    start = shard_bound( r->map, r->mapLen, opts->shard, opts->shards );
+    r->mapLen = shard_bound( r->map, r->mapLen, opts->shard + 1,
+            opts->shards );
+    r->mapPos = start;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   OPEN INPUT
+--------------------------------------------------------------------------------
+*   Looks at the first few bytes of the input to see if it's compressed, and
+*   if it is, starts decompressing it.  If not, a mapped file is read from
+*   the map, and anything else has what was looked at kept for read_input().
+*   Complains and returns -1 if the input can't be read.
+*
+*   Params
+*       batch_reader *r     |   The input
+*       const char *map     |   All of it, if it's a mapped file, or NULL
+*       size_t mapLen       |   How much that is
+*       const char *name    |   Name of the input, for error messages
+*/
+static int open_input( batch_reader *r, const char *map, size_t mapLen,
+        const char *name )
+{
+    int format = ZFORMAT_NONE;
+    ssize_t got;
+
+    if( map != NULL )
+        format = zstream_detect( map, ( mapLen < ZFORMAT_MAGIC ? mapLen
+                    : ZFORMAT_MAGIC ));
+
+    /*  Only as much as it takes to tell, so a pipe isn't kept waiting */
+    while( map == NULL && r->peekLen < ZFORMAT_MAGIC )
+    {
+        got = read( r->fd, r->peek + r->peekLen, ZFORMAT_MAGIC - r->peekLen );
+        if( got < 0 && errno == EINTR )
+            continue;
+
+        if( got < 0 )
+        {
+            fprintf( stderr, "ERROR:  Could not read from %s\n", name );
+            return( -1 );
+        }
+
+        if( got == 0 )
+            break;
+
+        r->peekLen += got;
+        if(( format = zstream_detect( r->peek, r->peekLen )) >= 0 )
+            break;
+    }
+
+    /*  Too short to be anything but text */
+    if( format < 0 )
+        format = ZFORMAT_NONE;
+
+    if( format == ZFORMAT_NONE )
+    {
+        r->map = map;
+        r->mapLen = mapLen;
+        return( 0 );
+    }
+
+    if( ! zstream_supported( format ))
+    {
+        fprintf( stderr, "ERROR:  %s:  muzz was built without %s\n", name,
+                zstream_name( format ));
+        return( -1 );
+    }
+
+    r->z = ( map != NULL ? zstream_map_reader( map, mapLen, format )
+            : zstream_reader( r->fd, format, r->peek, r->peekLen ));
+    r->peekLen = 0;
+
+    if( r->z == NULL )
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   BATCH RUN
+--------------------------------------------------------------------------------
+*   Reads records from a stream, one per line (or as binary columns), and
+*   prints one result for each of them just as if they'd been given on the
+*   command line.  Bad records are reported on stderr and skipped.  gzip
+*   (or zstd) input is decompressed on the way in.  Returns 0 if every
+*   record was good, 1 otherwise.
+*
+*   Params
+*       FILE *fp            |   Stream to read the records from
+*       const char *name    |   Name of the stream, for error messages
+*       muzz_ctx *ctx       |   Program options
+*       batch_opts *opts    |   Threads, formats and stats
+*/
+int batch_run( FILE *fp, const char *name, const muzz_ctx *ctx,
+        const batch_opts *opts )
+{
+    batch_reader r;
+    batch_layout in;
+    batch_layout out;
+    summary_table sum;
+    topk_heap top;
+    batch_job job;
+    muzz_plan plan;
+    struct stat st;
+    const char *map = NULL;
+    const char *base;
+    size_t mapLen = 0;
+    int status = 1;
+
+    memset( &r, 0, sizeof( r ));
+    r.fd = fileno( fp );
+
+    /*  A regular file; map it if we can */
+    if( fstat( r.fd, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_size > 0 )
+    {
+        void *m = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, r.fd, 0 );
+        if( m != MAP_FAILED )
+        {
+            madvise( m, st.st_size, MADV_SEQUENTIAL );
+            map = m;
+            mapLen = st.st_size;
+        }
+    }
+
+    if( open_input( &r, map, mapLen, name ))
+        goto out;
+
+    if( opts->input == BATCH_BINARY && read_header( &r, &in, name, ctx,
+                muzz_inputs( ctx ) - ( opts->target != NULL )))
+        goto out;
+
+    if( opts->shards > 0 && shard_file( &r, name, opts ))
+        goto out;
+
+    if( make_job( &job, &plan, &out, &sum, &top, ctx, opts ))
+        goto out;
+
+    /*  A shard's file is its name (wherever it's kept), size and age; any
+     *  copy of it has to keep its modification time */
+    job.name = name;
+    if( opts->shards > 0 )
+    {
+        base = strrchr( name, '/' );
+        job.input = partial_print_str( 0, ( base != NULL ? base + 1 : name ));
+        job.input = partial_print_u64( job.input, st.st_size );
+        job.input = partial_print_u64( job.input, st.st_mtime );
+    }
+
+    status = run( &r, &job );
+    status |= finish_job( &job, opts );
+
+    if( r.error && r.z != NULL )
+    {
+        fprintf( stderr, "ERROR:  %s:  Bad or truncated compressed data\n",
+                name );
+        status = 1;
+    }
+
+    else if( r.error )
+    {
+        fprintf( stderr, "ERROR:  Could not read from %s\n", name );
+        status = 1;
+    }
+
+    else if( r.badFrame )
+    {
+        fprintf( stderr, "ERROR:  %s:  Bad or truncated frame\n", name );
+        status = 1;
+    }
+
+out:
+    if( r.z != NULL )
+        zstream_close( r.z );
+
+    if( map != NULL )
+        munmap( (void *)map, mapLen );
+
+    heap_free( r.carry );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                    ON STOP
+--------------------------------------------------------------------------------
+*   SIGINT and SIGTERM, while following a file.
+*/
+static volatile sig_atomic_t stopFollowing;
+
+static void on_stop( int sig )
+{
+    (void)sig;
+    stopFollowing = 1;
+}
+
+
+
+/*==============================================================================
+                                  FOLLOW OPEN
+--------------------------------------------------------------------------------
+*   Opens the file we're following and moves the inotify watch onto it (the
+*   watch is on the file itself, not its name).  Returns the descriptor, or -1.
+*
+*   Params
+*       const char *path    |   The file
+*       int inotifyFd       |   inotify instance, or -1 for none
+*       int *wd             |   The file's watch; updated
+*/
+static int follow_open( const char *path, int inotifyFd, int *wd )
+{
+    int fd = open( path, O_RDONLY | O_CLOEXEC );
+
+    if( fd >= 0 && inotifyFd >= 0 )
+    {
+        if( *wd >= 0 )
+            inotify_rm_watch( inotifyFd, *wd );
+
+        *wd = inotify_add_watch( inotifyFd, path,
+                IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF );
+    }
+
+    return( fd );
+}
+
+
+
+/*==============================================================================
+                                  FOLLOW WAIT
+--------------------------------------------------------------------------------
+*   Sleeps until inotify says something happened to the file (or the folder
+*   it's in), we get a signal, or FOLLOW_WAIT_MS is up, whichever's first.
+*   The timeout covers filesystems inotify can't see changes on, and not
+*   having inotify at all.
+*/
+static void follow_wait( int inotifyFd )
+{
+    char events[ FOLLOW_EVENTS ]
+        __attribute__(( aligned( __alignof__( struct inotify_event ))));
+    struct pollfd pfd;
+
+    pfd.fd = inotifyFd;
+    pfd.events = POLLIN;
+
+    if( poll( &pfd, ( inotifyFd >= 0 ), FOLLOW_WAIT_MS ) > 0 )
+        while( read( inotifyFd, events, sizeof( events )) > 0 )
+            ;
+}
+
+
+
+/*==============================================================================
+                                  FOLLOW DRAIN
+--------------------------------------------------------------------------------
+*   Reads, processes and writes everything that's been added to the file
+*   since last time.  Returns 1 if there were new lines, 0 if not, -1 if
+*   we ran out of memory or WRITE_FAILED if the output couldn't be written.
+*
+*   Params
+*       batch_reader *r     |   The file, where we left off
+*       batch_job *job      |   The run
+*       batch_worker *w     |   Scratch space
+*       batch_block *b      |   Block to read into
+*       unsigned long *line |   Lines before this; updated
+*       int *status         |   Set to 1 if any record was bad
+*/
+static int follow_drain( batch_reader *r, const batch_job *job,
+        batch_worker *w, batch_block *b, unsigned long *line, int *status )
+{
+    int got = 0;
+    int more;
+    int bad;
+
+    r->eof = 0;
+    while( ( more = read_block( r, b, job->stats )) > 0 )
+    {
+        if( process_block( job->ctx, job->plan, w, b ))
+            return( -1 );
+
+        if( ( bad = write_block( job, b, line, job->stats )) < 0 )
+            return( bad );
+
+        *status |= bad;
+        got = 1;
+    }
+
+    return( more < 0 ? -1 : got );
+}
+
+
+
+/*==============================================================================
+                                 FOLLOW UPDATE
+--------------------------------------------------------------------------------
+*   After new lines:  prints the summary or top-K so far, if the run has one
+*   (results are printed as they're worked out).  The top-K is printed from a
+*   copy, since printing it sorts it.  Returns 0, -1 if we're out of
+*   memory or WRITE_FAILED if the output couldn't be written.
+*/
+static int follow_update( const batch_job *job, const batch_opts *opts,
+        int *updates )
+{
+    topk_heap copy;
+    int status = 0;
+
+    if( job->summary == NULL && job->top == NULL )
+        return( 0 );
+
+    /*  A blank line between tables, for whoever's reading them */
+    if( *updates > 0 && opts->summary != SUMMARY_JSON
+            && write_all( STDOUT_FILENO, "\n", 1 ))
+    {
+        fprintf( stderr, "muzz: write error: %s\n", strerror( errno ));
+        return( WRITE_FAILED );
+    }
+    ++*updates;
+
+    if( job->summary != NULL )
+        return( print_summary( job, opts ));
+
+    topk_init( &copy, job->top->k );
+    if( topk_merge( &copy, job->top ))
+        status = -1;
+    else
+        status = print_top( job, &copy );
+
+    topk_free( &copy );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                 FOLLOW CHANGE
+--------------------------------------------------------------------------------
+*   Whether the file has shrunk since we last read it (so it's been truncated
+*   and started again), or its name now belongs to another file (so it's
+*   been rotated).
+*/
+enum FollowChange {
+    FOLLOW_SAME,
+    FOLLOW_TRUNCATED,
+    FOLLOW_REPLACED
+};
+
+static int follow_change( const batch_reader *r, const char *path )
+{
+    struct stat cur;
+    struct stat now;
+
+    if( fstat( r->fd, &cur ) != 0 )
+        return( FOLLOW_SAME );
+
+    if( S_ISREG( cur.st_mode ) && cur.st_size < lseek( r->fd, 0, SEEK_CUR ))
+        return( FOLLOW_TRUNCATED );
+
+    /*  Gone, and not back yet:  carry on with what we've got */
+    if( stat( path, &now ) != 0 )
+        return( FOLLOW_SAME );
+
+    if( now.st_dev != cur.st_dev || now.st_ino != cur.st_ino )
+        return( FOLLOW_REPLACED );
+
+    return( FOLLOW_SAME );
+}
+
+
+
+/*==============================================================================
+                                  BATCH FOLLOW
+--------------------------------------------------------------------------------
+*   Batch mode over a file that's still being written, like 'tail -F':  the
+*   records already in it, then each new one as it's added, until we get
+*   SIGINT or SIGTERM.  Returns 0 if every record was good, 1 otherwise.
+*
+*   Params
+*       const char *path    |   The file
+*       muzz_ctx *ctx       |   Program options
+*       batch_opts *opts    |   Formats, conditions and stats (not threads)
+*/
+int batch_follow( const char *path, const muzz_ctx *ctx,
+        const batch_opts *opts )
+{
+    char dir[ PATH_MAX ];
+    const char *slash = strrchr( path, '/' );
+    batch_reader r;
+    batch_layout out;
+    summary_table sum;
+    topk_heap top;
+    batch_job job;
+    muzz_plan plan;
+    batch_worker w;
+    batch_block b;
+    struct sigaction sa;
+    unsigned long line = 0;
+    int inotifyFd;
+    int updates = 0;
+    int failed;
+    int wd = -1;
+    int status = 0;
+    int got = 0;
+    int fd;
+
+    memset( &r, 0, sizeof( r ));
+    memset( &b, 0, sizeof( b ));
+    memset( &w, 0, sizeof( w ));
+    memset( &job, 0, sizeof( job ));
+    r.follow = 1;
+
+    /*  Without inotify we just look every FOLLOW_WAIT_MS */
+    inotifyFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+
+    r.fd = follow_open( path, inotifyFd, &wd );
+    if( r.fd < 0 )
+    {
+        fprintf( stderr, "ERROR:  Could not open %s\n", path );
+        status = 1;
+        goto out;
+    }
+
+    /*  The folder, to hear about a new file taking the old one's name */
+    snprintf( dir, sizeof( dir ), "%.*s", ( slash == NULL ? 1 :
+                slash == path ? 1 : (int)( slash - path )),
+            ( slash == NULL ? "." : path ));
+    if( inotifyFd >= 0 )
+        inotify_add_watch( inotifyFd, dir, IN_CREATE | IN_MOVED_TO );
+
+    if( make_job( &job, &plan, &out, &sum, &top, ctx, opts )
+            || worker_init( &w, &job ))
+    {
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+        status = 1;
+        goto out;
+    }
+
+    job.name = path;
+    w.stats = job.stats;
+    r.maxBlocks = order_blocks( &job );
+
+    memset( &sa, 0, sizeof( sa ));
+    sa.sa_handler = on_stop;
+    sigemptyset( &sa.sa_mask );
+    sigaction( SIGINT, &sa, NULL );
+    sigaction( SIGTERM, &sa, NULL );
+
+    while( ! stopFollowing )
+    {
+        got = follow_drain( &r, &job, &w, &b, &line, &status );
+        if( got > 0 && ( failed = follow_update( &job, opts, &updates )) < 0 )
+            got = failed;
+
+        if( got < 0 || r.error || r.tooBig )
+            break;
+
+        switch( follow_change( &r, path ))
+        {
+            case FOLLOW_TRUNCATED:
+                fprintf( stderr, "muzz: %s: file truncated\n", path );
+                lseek( r.fd, 0, SEEK_SET );
+                r.carryLen = 0;
+                line = 0;
+                break;
+
+            case FOLLOW_REPLACED:
+                /*  The old file's last line, if it never got its newline */
+                r.follow = 0;
+                got = follow_drain( &r, &job, &w, &b, &line, &status );
+                if( got > 0 && ( failed = follow_update( &job, opts,
+                                &updates )) < 0 )
+                    got = failed;
+                r.follow = 1;
+
+                fd = ( got < 0 ? -1 : follow_open( path, inotifyFd, &wd ));
+                if( fd >= 0 )
+                {
+                    fprintf( stderr, "muzz: %s: file replaced; following "
+                            "the new one\n", path );
+                    close( r.fd );
+                    r.fd = fd;
+                    r.carryLen = 0;
+                    line = 0;
+                }
+
+                /*  Can't open the new one (yet); keep at the old */
+                else if( got >= 0 )
+                    follow_wait( inotifyFd );
+                break;
+
+            default:
+                follow_wait( inotifyFd );
+                break;
+        }
+
+        if( got < 0 )
+            break;
+    }
+
+    if( got == -1 )
+        fprintf( stderr, "ERROR:  Out of memory\n" );
+    if( got < 0 )
+        status = 1;
+
+    if( r.tooBig )
+    {
+        too_big( &job );
+        status = 1;
+    }
+
+    if( r.error )
+    {
+        fprintf( stderr, "ERROR:  Could not read from %s\n", path );
+        status = 1;
+    }
+
+out:
+    if( job.summary != NULL )
+        summary_free( job.summary );
+    if( job.top != NULL )
+        topk_free( job.top );
+
+    if( r.fd >= 0 )
+        close( r.fd );
+    if( inotifyFd >= 0 )
+        close( inotifyFd );
+
+    arena_free( &w.mem );
+    free_block( &b );
+    heap_free( r.carry );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                  PARSE RANGE
+--------------------------------------------------------------------------------
+*   Reads a sweep range, START:STOP[:STEP] (STEP defaults to 1).  A plain
+*   number is a range of one.  STOP is included if the steps land on it.
+*   Returns 0, or -1 if it isn't a range.
+*
+*   Params
+*       const char *str     |   The range
+*       batch_range *range  |   Where to put it
+*/
+int batch_parse_range( const char *str, batch_range *range )
+{
+    const char *end = str + strlen( str );
+    const char *colon1 = memchr( str, ':', end - str );
+    const char *colon2 = NULL;
+    double stop;
+    double steps;
+
+    range->step = 1;
+    range->count = 1;
+
+    if( colon1 == NULL )
+        return( muzz_parse_double( str, end - str, &range->start ));
+
+    colon2 = memchr( colon1 + 1, ':', end - colon1 - 1 );
+
+    if( muzz_parse_double( str, colon1 - str, &range->start ))
+        return( -1 );
+
+    if( colon2 == NULL )
+    {
+        if( muzz_parse_double( colon1 + 1, end - colon1 - 1, &stop ))
+            return( -1 );
+    }
+
+    else if( muzz_parse_double( colon1 + 1, colon2 - colon1 - 1, &stop )
+            || muzz_parse_double( colon2 + 1, end - colon2 - 1, &range->step ))
+        return( -1 );
+
+    /*  Has to go somewhere, and in the right direction */
+    steps = ( stop - range->start ) / range->step;
+    if( range->step == 0 || ! ( steps >= 0 ) || steps >= 1e15 )
+        return( -1 );
+
+    /*  Allow for a last step that's a hair short from rounding */
+    range->count = (uint64_t)( steps + 1e-9 ) + 1;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  PARSE COLUMN
+--------------------------------------------------------------------------------
+*   Which column (enum BinColumn) a name is, ignoring case, or -1.
+*/
+static int parse_column( const char *str, size_t len )
+{
+    int c;
+
+    for( c = 0; c < BIN_COLS; ++c )
+        if( strlen( colNames[c] ) == len
+                && strncasecmp( str, colNames[c], len ) == 0 )
+            return( c );
+
+    return( -1 );
+}
+
+
+
+/*==============================================================================
+                                  PARSE WHERE
+--------------------------------------------------------------------------------
+*   Reads a condition, COLUMN OP NUMBER, where OP is one of < <= > >= == (or
+*   =) and !=.  == and != may be given a list, NUMBER,NUMBER,... (a set of
+*   calibers, say).  Returns 0, or -1 if it isn't a condition.
+*
+*   Params
+*       const char *str     |   The condition, e.g. "velocity<=1100"
+*       batch_where *where  |   Where to put it
+*/
+int batch_parse_where( const char *str, batch_where *where )
+{
+    static const struct {
+        const char *text;
+        int op;
+    } ops[] = {
+        { "<=", BATCH_LE }, { ">=", BATCH_GE }, { "!=", BATCH_NE },
+        { "==", BATCH_EQ }, { "<", BATCH_LT }, { ">", BATCH_GT },
+        { "=", BATCH_EQ }
+    };
+    const char *end = str + strlen( str );
+    size_t len = strcspn( str, "<>=!" );
+    const char *p = str + len;
+    size_t i;
+
+    /*  Spaces around the column name and number don't matter */
+    while( len > 0 && isspace( (unsigned char)str[ len - 1 ] ))
+        --len;
+    while( len > 0 && isspace( (unsigned char)*str ))
+        ++str, --len;
+
+    where->col = parse_column( str, len );
+    if( where->col < 0 )
+        return( -1 );
+
+    for( i = 0; i < sizeof( ops ) / sizeof( ops[0] ); ++i )
+        if( strncmp( p, ops[i].text, strlen( ops[i].text )) == 0 )
+            break;
+
+    if( i == sizeof( ops ) / sizeof( ops[0] ))
+        return( -1 );
+
+    where->op = ops[i].op;
+    p += strlen( ops[i].text );
+
+    /*  The numbers, with spaces around them allowed */
+    for( where->numValues = 0; where->numValues < BATCH_VALUES_MAX;
+            ++where->numValues )
+    {
+        const char *next = memchr( p, ',', end - p );
+        const char *stop = ( next != NULL ? next : end );
+
+        while( p < stop && isspace( (unsigned char)*p ))
+            ++p;
+        while( stop > p && isspace( (unsigned char)stop[-1] ))
+            --stop;
+
+        if( muzz_parse_double( p, stop - p,
+                    &where->values[ where->numValues ] ))
+            return( -1 );
+
+        if( next == NULL )
+            break;
+        p = next + 1;
+    }
+
+    /*  Too many, or a list where only one number makes sense */
+    if( where->numValues == BATCH_VALUES_MAX || ( where->numValues > 0
+                && where->op != BATCH_EQ && where->op != BATCH_NE ))
+        return( -1 );
+
+    ++where->numValues;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   PARSE TOP
+--------------------------------------------------------------------------------
+*   Reads K[:[-]COLUMN]:  keep the K highest of COLUMN (or the answer), or
+*   the K lowest with a '-'.  Returns 0, or -1 if it isn't one of those.
+*
+*   Params
+*       const char *str     |   What was given to '--top'
+*       batch_opts *opts    |   Where to put it
+*/
+int batch_parse_top( const char *str, batch_opts *opts )
+{
+    const char *colon = strchr( str, ':' );
+    char *end;
+
+    if( ! isdigit( (unsigned char)*str ))
+        return( -1 );
+
+    errno = 0;
+    opts->top = strtoull( str, &end, 10 );
+    opts->topCol = -1;
+    opts->topLow = 0;
+
+    if( errno || opts->top == 0
+            || end != ( colon != NULL ? colon : str + strlen( str )))
+        return( -1 );
+
+    if( colon == NULL )
+        return( 0 );
+
+    str = colon + 1;
+    if( *str == '-' )
+    {
+        opts->topLow = 1;
+        ++str;
+    }
+
+    if( *str == '\0' )
+        return( 0 );
+
+    opts->topCol = parse_column( str, strlen( str ));
+    return( opts->topCol < 0 ? -1 : 0 );
+}
+
+
+
+/*==============================================================================
+                                  BATCH SWEEP
+--------------------------------------------------------------------------------
+*   Calculates and prints every combination of the given ranges, one result
+*   per line, in order:  the last range changes fastest.  Returns 0, or 1 if
+*   something went wrong.
+*
+*   Params
+*       batch_range *ranges |   One range per input, muzz_inputs() of them
+*                           |   (less the target's), then the BC's with
+*                           |   '--drag'
+*       muzz_ctx *ctx       |   Program options
+*       batch_opts *opts    |   Threads, output format and stats
+*/
+int batch_sweep( const batch_range *ranges, const muzz_ctx *ctx,
+        const batch_opts *opts )
+{
+    batch_reader r;
+    batch_layout out;
+    summary_table sum;
+    topk_heap top;
+    batch_job job;
+    muzz_plan plan;
+    int fields = muzz_inputs( ctx ) + ( opts->distances != NULL )
+        - ( opts->target != NULL );
+    int status;
+    int i;
+
+    memset( &r, 0, sizeof( r ));
+    r.sweep = ranges;
+    r.sweepCells = 1;
+
+    for( i = 0; i < fields; ++i )
+    {
+        if( ranges[i].count > UINT64_MAX / r.sweepCells )
+        {
+            fprintf( stderr, "ERROR:  Sweep is too big\n" );
+            return( 1 );
+        }
+        r.sweepCells *= ranges[i].count;
+    }
+
+    /*  '--shard':  only our share of the cells */
+    if( opts->shards > 0 )
+    {
+        r.sweepPos = shard_start( r.sweepCells, opts->shard, opts->shards );
+        r.sweepCells = shard_start( r.sweepCells, opts->shard + 1,
+                opts->shards );
+    }
+
+    if( make_job( &job, &plan, &out, &sum, &top, ctx, opts ))
+        return( 1 );
+
+    job.name = "sweep";
+    for( i = 0; i < fields; ++i )
+    {
+        job.input = partial_print_f64( job.input, ranges[i].start );
+        job.input = partial_print_f64( job.input, ranges[i].step );
+        job.input = partial_print_u64( job.input, ranges[i].count );
+    }
+
+    status = run( &r, &job );
+    status |= finish_job( &job, opts );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                   PARSE DIST
+--------------------------------------------------------------------------------
+*   Reads a distribution, MEAN+-SD.  A plain number has an SD of 0.  Returns
+*   0, or -1 if it isn't one, or the SD is negative.
+*
+*   Params
+*       const char *str     |   The distribution
+*       batch_dist *dist    |   Where to put it
+*/
+int batch_parse_dist( const char *str, batch_dist *dist )
+{
+    const char *end = str + strlen( str );
+    const char *pm = strstr( str, "+-" );
+
+    dist->sd = 0;
+
+    if( pm == NULL )
+        return( muzz_parse_double( str, end - str, &dist->mean ));
+
+    if( muzz_parse_double( str, pm - str, &dist->mean )
+            || muzz_parse_double( pm + 2, end - pm - 2, &dist->sd )
+            || ! ( dist->sd >= 0 ))
+        return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                    BATCH MC
+--------------------------------------------------------------------------------
+*   Runs a number of samples of normally distributed inputs through the
+*   formulas, the same way as a sweep.  Returns 0, or 1 if something went
+*   wrong.
+*
+*   Params
+*       batch_dist *dists   |   One distribution per input, muzz_inputs()
+*                           |   (less the target's), then the BC's with
+*                           |   '--drag'
+*       uint64_t samples    |   How many sets of inputs to draw
+*       uint64_t seed       |   Where the random numbers start from
+*       muzz_ctx *ctx       |   Program options
+*       batch_opts *opts    |   Threads, output format and stats
+*/
+int batch_mc( const batch_dist *dists, uint64_t samples, uint64_t seed,
+        const muzz_ctx *ctx, const batch_opts *opts )
+{
+    batch_reader r;
+    batch_layout out;
+    summary_table sum;
+    topk_heap top;
+    batch_job job;
+    muzz_plan plan;
+    int status;
+    int i;
+
+    memset( &r, 0, sizeof( r ));
+    r.dists = dists;
+    r.seed = seed;
+    r.sweepCells = samples;
+
+    /*  '--shard':  only our share of the samples, drawn as ever */
+    if( opts->shards > 0 )
+    {
+        r.sweepPos = shard_start( samples, opts->shard, opts->shards );
+        r.sweepCells = shard_start( samples, opts->shard + 1, opts->shards );
+    }
+
+    if( make_job( &job, &plan, &out, &sum, &top, ctx, opts ))
+        return( 1 );
+
+    job.name = "mc";
+    job.input = partial_print_u64( partial_print_u64( 0, samples ), seed );
+    for( i = 0; i < job.fields; ++i )
+    {
+        job.input = partial_print_f64( job.input, dists[i].mean );
+        job.input = partial_print_f64( job.input, dists[i].sd );
+    }
+
+    status = run( &r, &job );
+    status |= finish_job( &job, opts );
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                  MERGE FILE
+--------------------------------------------------------------------------------
+*   Reads every partial in a file into the run, the first one setting it
+*   up.  Returns 0, or complains and returns -1.
+*
+*   Params
+*       FILE *fp            |   The file
+*       const char *name    |   Its name, for error messages
+*       merge_run *m        |   The run so far
+*/
+static int merge_file( FILE *fp, const char *name, merge_run *m )
+{
+    partial_head h;
+    int c;
+
+    while(( c = getc( fp )) != EOF )
+    {
+        ungetc( c, fp );
+
+        if( partial_get_head( fp, &h ))
+        {
+            fprintf( stderr, "ERROR:  %s:  Not a partial, or cut short\n",
+                    name );
+            return( -1 );
+        }
+
+        /*  The first one says what the run was */
+        if( ! m->started )
+        {
+            m->head = h;
+            m->started = 1;
+            m->seen = heap_alloc( h.shards );
+            if( m->seen == NULL )
+            {
+                fprintf( stderr, "ERROR:  Out of memory\n" );
+                return( -1 );
+            }
+            memset( m->seen, 0, h.shards );
+
+            muzz_ctx_init( &m->ctx );
+            m->ctx.si = (int)h.si;
+            m->ctx.solve = (int)h.solve;
+            m->ctx.kMode = (int)h.kMode;
+            memcpy( &m->ctx.customK, &h.customK, sizeof( h.customK ));
+            m->ctx.verbose = (int)h.verbose;
+            m->ctx.precise = (int)h.precise;
+            m->ctx.fast = (int)h.fast;
+            muzz_ctx_resolve( &m->ctx );
+
+            memset( &m->opts, 0, sizeof( m->opts ));
+            m->opts.jobs = 1;
+            m->opts.summary = (int)h.summary;
+            m->opts.group = (int)h.group;
+            m->opts.output = (int)h.output;
+            m->opts.distances = ( h.downrange ? &m->range : NULL );
+            m->opts.top = ( h.kind == PARTIAL_TOP ? h.top : 0 );
+            m->opts.topCol = (int)h.topCol - 1;
+            m->opts.topLow = (int)h.topLow;
+
+            if( make_job( &m->job, &m->plan, &m->out, &m->sum, &m->top,
+                        &m->ctx, &m->opts ))
+                return( -1 );
+            m->job.name = "merge";
+
+            if( m->job.sumCols != NULL
+                    && (uint64_t)m->job.sumCols->numCols != h.numCols )
+            {
+                fprintf( stderr, "ERROR:  %s:  Not a partial, or cut ",
+                        name );
+                fprintf( stderr, "short\n" );
+                return( -1 );
+            }
+        }
+
+        if( ! partial_same_run( &h, &m->head ))
+        {
+            fprintf( stderr, "ERROR:  %s:  A partial from another run\n",
+                    name );
+            return( -1 );
+        }
+
+        if( m->seen[ h.shard ] )
+        {
+            fprintf( stderr, "ERROR:  %s:  Shard %lu of %lu is already in\n",
+                    name, (unsigned long)h.shard, (unsigned long)h.shards );
+            return( -1 );
+        }
+        m->seen[ h.shard ] = 1;
+
+        if( ( h.kind == PARTIAL_TOP ? topk_load( m->job.top, fp )
+                    : summary_load( m->job.summary, fp )))
+        {
+            fprintf( stderr, "ERROR:  %s:  Bad or truncated partial\n",
+                    name );
+            return( -1 );
+        }
+    }
+
+    if( ferror( fp ))
+    {
+        fprintf( stderr, "ERROR:  Could not read from %s\n", name );
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  BATCH MERGE
+--------------------------------------------------------------------------------
+*   'muzz merge':  adds up the partials a sharded run wrote, and prints the
+*   run's summary or top-K from them just as one run would have.  Returns 0,
+*   or 1 if something went wrong.
+*
+*   Params
+*       char *const *paths  |   The partial files; "-" is stdin
+*       int numPaths        |   How many
+*/
+int batch_merge( char *const *paths, int numPaths )
+{
+    merge_run m;
+    uint64_t i;
+    FILE *fp;
+    int status = 0;
+    int p;
+
+    memset( &m, 0, sizeof( m ));
+
+    for( p = 0; status == 0 && p < numPaths; ++p )
+    {
+        fp = ( strcmp( paths[p], "-" ) == 0 ? stdin : fopen( paths[p], "rb" ));
+        if( fp == NULL )
+        {
+            fprintf( stderr, "ERROR:  Could not open %s\n", paths[p] );
+            status = 1;
+            break;
+        }
+
+        if( merge_file( fp, ( fp == stdin ? "stdin" : paths[p] ), &m ))
+            status = 1;
+
+        if( fp != stdin )
+            fclose( fp );
+    }
+
+    if( status == 0 && ! m.started )
+    {
+        fprintf( stderr, "ERROR:  No partials to merge\n" );
+        status = 1;
+    }
+
+    for( i = 0; status == 0 && i < m.head.shards; ++i )
+        if( ! m.seen[i] )
+        {
+            fprintf( stderr, "ERROR:  Shard %lu of %lu is missing\n",
+                    (unsigned long)i, (unsigned long)m.head.shards );
+            status = 1;
+        }
+
+    if( m.started )
+    {
+        /*  Everything's in; print it, or just let it go */
+        if( status == 0 )
+            status = finish_job( &m.job, &m.opts );
+        else if( m.job.top != NULL )
+            topk_free( m.job.top );
+        else if( m.job.summary != NULL )
+            summary_free( m.job.summary );
+    }
+
+    heap_free( m.seen );
+    return( status );
+}
@@ -0,0 +1,175 @@
+/*******************************************************************************
+ *  batch.h     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Batch mode for the muzz program:  records in, one result per record out.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_BATCH_H
+#define MUZZ_BATCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "muzz.h"
+#include "stats.h"
+#include "summary.h"
+
+
+/*  What the records come in as, or the results go out as */
+enum BatchFormat {
+    BATCH_TEXT,             //  One record or result per line
+    BATCH_BINARY,           //  Little-endian double columns; see batch.c
+    BATCH_CSV,              //  Results only:  comma-separated, with a header
+    BATCH_NDJSON            //  Results only:  a JSON object per line
+};
+
+
+/*  Ways to compare a column with a number */
+enum BatchOp {
+    BATCH_LT,
+    BATCH_LE,
+    BATCH_GT,
+    BATCH_GE,
+    BATCH_EQ,
+    BATCH_NE
+};
+
+
+/*  Most numbers an == or != condition can list */
+#define BATCH_VALUES_MAX 16
+
+/*  A condition a result has to meet, e.g. "velocity<=1100", or
+ *  "diameter==.308,.338" for any of a list */
+typedef struct batch_where {
+    int col;                //  0 mass, 1 velocity, 2 energy, 3 diameter,
+                            //  4 TKOF, 5 range
+    int op;                 //  enum BatchOp
+    double values[ BATCH_VALUES_MAX ];
+    int numValues;          //  Only == and != may have more than one
+} batch_where;
+
+/*  Columns a result has, numbered as above */
+#define BATCH_COLS 6
+
+/*  Most conditions a run can have */
+#define BATCH_WHERE_MAX 16
+
+
+/*  One input's range in a sweep:  start, start + step, ... (count of them) */
+typedef struct batch_range {
+    double start;
+    double step;
+    uint64_t count;
+} batch_range;
+
+
+/*  How to run a batch or sweep */
+typedef struct batch_opts {
+    int jobs;               //  Worker threads, 1 for none
+    int input;              //  enum BatchFormat
+    int output;
+    int summary;            //  enum SummaryMode:  add up the results instead
+    int group;              //  Summaries:  first field of a record is a key
+
+    const batch_where *where;   //  Only results meeting all of these count
+    int numWhere;
+
+    uint64_t top;           //  Only print the best this many, or 0 for all
+    int topCol;             //  Best by this column (as above), -1 the answer
+    int topLow;             //  Lowest is best, rather than highest
+
+    const batch_range *distances;   //  '--drag':  records end with a BC, and
+    int drag;                       //  each gives a result at all of these
+                                    //  distances, under this enum muzz_drag
+
+    int tagged;             //  '--tagged':  numbers may end in their units,
+                            //  which also say what each record solves for
+
+    int compress;           //  '--compress':  enum ZFormat the output is in
+
+    const double *target;   //  '--target':  the energy (or TKOF) every record
+                            //  solves from, left out of them, or NULL
+
+    int shard;              //  '--shard':  this run is shard number shard
+    int shards;             //  (from 0) of shards, or shards is 0; with a
+                            //  summary or top, it writes a partial instead
+
+    run_stats *stats;       //  Counts and timings go here, or NULL
+} batch_opts;
+
+
+/*  One input of a Monte Carlo run:  normally distributed, MEAN[+-SD] */
+typedef struct batch_dist {
+    double mean;
+    double sd;              //  0 for the same every time
+} batch_dist;
+
+
+/*
+ *  Reads records from fp, one per line (or in binary columns), and prints
+ *  one result per record to stdout, in order.  With opts->jobs > 1 the
+ *  records are split into blocks that are parsed, calculated and formatted
+ *  by that many threads.  With opts->summary, a summary of the results is
+ *  printed at the end instead; with opts->top, only the best results are,
+ *  best first.  name is used in error messages.  Returns 0 if every record
+ *  was good, 1 otherwise.
+ */
+int batch_run( FILE *fp, const char *name, const muzz_ctx *ctx,
+        const batch_opts *opts );
+
+/*
+ *  The same, over a file that's still being written (like 'tail -F'):  what
+ *  it has now, then each line as it's added, until SIGINT or SIGTERM.  With
+ *  opts->summary (or top), the summary so far is printed again after every
+ *  update.  A truncated file is read again from the top, and a rotated one
+ *  finished off before its replacement is followed.  Always one thread.
+ */
+int batch_follow( const char *path, const muzz_ctx *ctx,
+        const batch_opts *opts );
+
+/*  Reads START:STOP[:STEP] (or a plain number).  Returns 0, or -1. */
+int batch_parse_range( const char *str, batch_range *range );
+
+/*
+ *  Reads a condition, COLUMN OP NUMBER (e.g. "velocity<=1100"), where == and
+ *  != may have a list of numbers (e.g. "diameter==.308,.338").  0, or -1.
+ */
+int batch_parse_where( const char *str, batch_where *where );
+
+/*  Reads K[:[-]COLUMN] into opts' top, topCol and topLow.  0, or -1. */
+int batch_parse_top( const char *str, batch_opts *opts );
+
+/*
+ *  Prints a result for every combination of the ranges (muzz_inputs() of
+ *  them, less the one opts->target takes the place of, and one for the BC
+ *  with opts->distances), the last one changing fastest, run the same way as
+ *  above.
+ */
+int batch_sweep( const batch_range *ranges, const muzz_ctx *ctx,
+        const batch_opts *opts );
+
+/*
+ *  'muzz merge':  reads the partials the shards of a run wrote (each path
+ *  may hold any number of them, one after another, and "-" is stdin), adds
+ *  them up and prints the summary or top-K that the whole run would have.
+ *  Every shard has to be there exactly once.  Returns 0, or 1 if a partial
+ *  is bad, missing, or from some other run.
+ */
+int batch_merge( char *const *paths, int numPaths );
+
+/*  Reads MEAN[+-SD] (e.g. "900+-12").  Returns 0, or -1. */
+int batch_parse_dist( const char *str, batch_dist *dist );
+
+/*
+ *  Draws samples sets of inputs from the distributions (muzz_inputs() of
+ *  them, and the BC's with opts->distances) and runs them the same way as
+ *  above; usually with opts->summary, for the spread of the answer.  The
+ *  same seed gives the same samples, however many threads there are.
+ *  Returns 0, or 1 if something went wrong.
+ */
+int batch_mc( const batch_dist *dists, uint64_t samples, uint64_t seed,
+        const muzz_ctx *ctx, const batch_opts *opts );
+
+#endif
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ *  builtin.c   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  muzz as a bash loadable builtin.  A script that runs 'muzz -q' in a loop
+ *  spends nearly all its time starting processes; once it's loaded with
+ *
+ *      enable -f ./muzz.so muzz
+ *
+ *  'muzz' runs inside the shell instead, and puts its answer in a variable
+ *  (REPLY, or the one given with '-r') rather than printing it, so there's
+ *  no $( ... ) to fork for either:
+ *
+ *      muzz -q 230 900;  echo "$REPLY"
+ *      muzz -r fps -qv 230 414
+ *
+ *  The options are the ones that say how a shot is worked out, the same as
+ *  the program's (and server mode's); there's no batch, sweep or server
+ *  mode here.  Everything is worked out with libmuzz and a muzz_ctx of this
+ *  call's own, and bash's getopt is reset every time, so nothing is left
+ *  over from one call to the next.
+ *
+ *  Built with 'make builtin', which needs bash's headers for loadables
+ *  (BASHINC in the Makefile).
+ *
+ ******************************************************************************/
+#include <string.h>
+
+#include "loadables.h"
+
+#include "muzz.h"
+
+/*  Where the answer goes, unless '-r' says otherwise */
+#define BUILTIN_VAR "REPLY"
+
+
+/*==============================================================================
+                                 MUZZ BUILTIN
+--------------------------------------------------------------------------------
+*   The builtin itself:  reads the options and numbers just as the program
+*   does, and sets the variable to what the program would have printed
+*   (without its newline).  Returns EXECUTION_SUCCESS, EXECUTION_FAILURE
+*   if a number isn't one or the variable can't be set, or EX_USAGE.
+*
+*   Params
+*       WORD_LIST *list |   The arguments, after 'muzz'
+*/
+int muzz_builtin( WORD_LIST *list )
+{
+    char line[ MUZZ_FORMAT_MAX ];
+    const char *var = BUILTIN_VAR;
+    int valueWanted = MUZZ_SOLVE_ENERGY;
+    int useTkof = 0;
+    double nums[ 3 ];
+    muzz_shot shot;
+    muzz_ctx ctx;
+    SHELL_VAR *v;
+    int len;
+    int opt;
+    int i;
+
+    muzz_ctx_init( &ctx );
+
+    reset_internal_getopt();
+    while(( opt = internal_getopt( list, "r:SqsimvecCKk:pt" )) != -1 )
+    {
+        switch( opt )
+        {
+            case 'r':   var = list_optarg;                      break;
+            case 'S':
+            case 'q':   ctx.verbose = 0;                        break;
+            case 's':   ctx.si = 1;                             break;
+            case 'i':   ctx.si = 0;                             break;
+            case 'm':   valueWanted = MUZZ_SOLVE_MASS;          break;
+            case 'v':   valueWanted = MUZZ_SOLVE_VELOCITY;      break;
+            case 'e':   valueWanted = MUZZ_SOLVE_ENERGY;        break;
+            case 'c':   ctx.kMode = MUZZ_K_GAC1;                break;
+            case 'C':   ctx.kMode = MUZZ_K_GAC2;                break;
+            case 'K':   ctx.kMode = MUZZ_K_INDUSTRY;            break;
+            case 'p':   ctx.precise = 1;                        break;
+            case 't':   useTkof = 1;                            break;
+
+            case 'k':   //  A custom constant
+                ctx.kMode = MUZZ_K_CUSTOM;
+                if( muzz_parse_double( list_optarg, strlen( list_optarg ),
+                            &ctx.customK ))
+                {
+                    builtin_error( "%s: not a number", list_optarg );
+                    return( EX_USAGE );
+                }
+                break;
+
+            CASE_HELPOPT;
+            default:
+                builtin_usage();
+                return( EX_USAGE );
+        }
+    }
+    list = loptend;
+
+    if( legal_identifier( var ) == 0 )
+    {
+        sh_invalidid( (char *)var );
+        return( EX_USAGE );
+    }
+
+    /*  Now that we know everything, settle on the constant once; with -t, -m
+     *  and -v work the knockout formula backwards */
+    if( useTkof && valueWanted == MUZZ_SOLVE_MASS )
+        ctx.solve = MUZZ_SOLVE_TKOF_MASS;
+    else if( useTkof && valueWanted == MUZZ_SOLVE_VELOCITY )
+        ctx.solve = MUZZ_SOLVE_TKOF_VELOCITY;
+    else
+        ctx.solve = ( useTkof ? MUZZ_SOLVE_TKOF : valueWanted );
+    muzz_ctx_resolve( &ctx );
+
+    /*  As many numbers as that takes; any more are ignored */
+    for( i = 0; i < muzz_inputs( &ctx ); ++i, list = list->next )
+    {
+        if( list == NULL )
+        {
+            builtin_error( "need %d parameters", muzz_inputs( &ctx ));
+            builtin_usage();
+            return( EX_USAGE );
+        }
+
+        if( muzz_parse_double( list->word->word, strlen( list->word->word ),
+                    &nums[ i ] ))
+        {
+            builtin_error( "%s: not a number", list->word->word );
+            return( EXECUTION_FAILURE );
+        }
+    }
+
+    muzz_shot_set( &ctx, &shot, nums );
+    len = muzz_format( &ctx, &shot, line, sizeof( line ));
+    if( len > 0 && line[ len - 1 ] == '\n' )
+        line[ len - 1 ] = '\0';
+
+    v = bind_variable( var, line, 0 );
+    if( v == NULL || readonly_p( v ) || noassign_p( v ))
+        return( EXECUTION_FAILURE );
+
+    return( EXECUTION_SUCCESS );
+}
+
+
+
+/*==============================================================================
+                                  THE STRUCT
+--------------------------------------------------------------------------------
+*   What bash needs to know about the builtin:  its name, how to call it,
+*   and its help.
+*/
+char *muzz_doc[] = {
+    "Calculate muzzle energy, mass, velocity or TKOF, in the shell.",
+    "",
+    "Works out what 'muzz' would print for MASS VELOCITY (or, with -m or",
+    "-v, the other two; with -t, MASS VELOCITY DIAMETER, and with -t and",
+    "-m or -v, the mass or velocity for a TKOF) and puts it in",
+    "REPLY, or in NAME with -r.  The options are the program's:  -q for",
+    "just the number, -p for more digits, -s for Si units, -m, -v, -e or",
+    "-t for what to work out, and -c, -C, -K or -k NUM for the constant.",
+    "",
+    "Exit Status:",
+    "Returns success unless an option or number is bad or the variable",
+    "can't be set.",
+    (char *)NULL
+};
+
+struct builtin muzz_struct = {
+    "muzz",
+    muzz_builtin,
+    BUILTIN_ENABLED,
+    muzz_doc,
+    "muzz [-r name] [-qpsimvetcCK] [-k num] MASS VELOCITY [DIAMETER]",
+    0
+};
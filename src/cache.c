@@ -0,0 +1,211 @@
+/*******************************************************************************
+ *  cache.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The result cache for '--cache'.  Real traffic asks about the same few
+ *  hundred factory loads over and over, so the answer to a shot, already
+ *  formatted, is kept by its inputs and handed straight back next time.
+ *
+ *  The table is open addressing, set-associative:  a key hashes to one set
+ *  of CACHE_WAYS entries, sitting next to each other, and is only ever
+ *  looked for there, so a lookup reads a few cache lines and never wanders.
+ *  When a set is full, CLOCK picks what goes:  each entry has a bit that's
+ *  set whenever it's used, and the set's hand goes round clearing them
+ *  until it finds one clear.  So entries that keep being asked for stay,
+ *  and nothing has to be moved on a hit, the way it would be for LRU.
+ *
+ *  The cache is the server's, and the server is one thread, so there's
+ *  nothing to lock, and the table is its whole memory:  nothing is
+ *  allocated after it's set up.
+ *
+ ******************************************************************************/
+#include <string.h>
+
+#include "cache.h"
+
+
+/*==============================================================================
+                                     MIX64
+--------------------------------------------------------------------------------
+*   The SplitMix64 finalizer:  every bit of x affects every bit of the result.
+*/
+static inline uint64_t mix64( uint64_t x )
+{
+    x = ( x ^ ( x >> 30 )) * 0xbf58476d1ce4e5b9ull;
+    x = ( x ^ ( x >> 27 )) * 0x94d049bb133111ebull;
+    return( x ^ ( x >> 31 ));
+}
+
+
+
+/*==============================================================================
+                                    KEY HASH
+--------------------------------------------------------------------------------
+*   Hashes a key on its bits, so -0 and 0 (which print differently) are
+*   different keys.  Each number gets a multiplier of its own and they're
+*   mixed together once, which doesn't have to wait on one number to start
+*   the next.  The low bits pick the set, and the high bits are the tag.
+*/
+static uint64_t key_hash( const cache_key *key )
+{
+    uint64_t bits[ 4 ];
+
+    memcpy( bits, key->in, sizeof( key->in ));
+    memcpy( &bits[3], &key->k, sizeof( key->k ));
+
+    return( mix64( bits[0] * 0x9e3779b97f4a7c15ull
+                ^ bits[1] * 0xc2b2ae3d27d4eb4full
+                ^ bits[2] * 0x165667b19e3779f9ull
+                ^ bits[3] * 0xd6e8feb86659fd93ull ^ key->flags ));
+}
+
+
+
+/*==============================================================================
+                                   KEY EQUAL
+--------------------------------------------------------------------------------
+*/
+static int key_equal( const cache_key *a, const cache_key *b )
+{
+    return( memcmp( a->in, b->in, sizeof( a->in )) == 0
+            && memcmp( &a->k, &b->k, sizeof( a->k )) == 0
+            && a->flags == b->flags );
+}
+
+
+
+/*==============================================================================
+                                   CACHE INIT
+--------------------------------------------------------------------------------
+*   Params
+*       result_cache *c |   The cache
+*       size_t entries  |   About how many results to keep
+*       arena *mem      |   Where the table goes
+*/
+int cache_init( result_cache *c, size_t entries, arena *mem )
+{
+    c->sets = 1;
+    while( c->sets * CACHE_WAYS < entries )
+        c->sets *= 2;
+
+    c->entries = arena_alloc( mem,
+            c->sets * CACHE_WAYS * sizeof( cache_entry ));
+    c->tags = arena_alloc( mem, c->sets * CACHE_WAYS * sizeof( uint32_t ));
+    c->hands = arena_alloc( mem, c->sets );
+    if( c->entries == NULL || c->tags == NULL || c->hands == NULL )
+        return( -1 );
+
+    memset( c->tags, 0, c->sets * CACHE_WAYS * sizeof( uint32_t ));
+    memset( c->hands, 0, c->sets );
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 CACHE KEY SET
+--------------------------------------------------------------------------------
+*   Params
+*       cache_key *key      |   Where to put it
+*       muzz_ctx *ctx       |   Resolved options the shot was worked out with
+*       const double *nums  |   Its inputs
+*/
+void cache_key_set( cache_key *key, const muzz_ctx *ctx, const double *nums )
+{
+    int inputs = muzz_inputs( ctx );
+    int i;
+
+    for( i = 0; i < 3; ++i )
+        key->in[i] = ( i < inputs ? nums[i] : 0 );
+
+    key->k = ctx->k;
+    key->flags = (uint32_t)ctx->solve | ( ctx->si != 0 ) << 8
+        | ( ctx->verbose != 0 ) << 9 | ( ctx->precise != 0 ) << 10;
+}
+
+
+
+/*==============================================================================
+                                   CACHE FIND
+--------------------------------------------------------------------------------
+*   Only the set's tags are looked at (half a cache line), and only an entry
+*   whose tag matches is compared, so a miss usually reads no entries at all.
+*/
+cache_entry *cache_find( result_cache *c, const cache_key *key )
+{
+    uint64_t h = key_hash( key );
+    size_t set = ( h & ( c->sets - 1 )) * CACHE_WAYS;
+    const uint32_t *tags = c->tags + set;
+    uint32_t tag = (uint32_t)( h >> 32 ) | 1;
+    cache_entry *e;
+    int i;
+
+    for( i = 0; i < CACHE_WAYS; ++i )
+    {
+        if( tags[i] != tag )
+            continue;
+
+        e = &c->entries[ set + i ];
+        if( key_equal( &e->key, key ))
+        {
+            e->ref = 1;
+            return( e );
+        }
+    }
+
+    return( NULL );
+}
+
+
+
+/*==============================================================================
+                                   CACHE PUT
+--------------------------------------------------------------------------------
+*   Params
+*       result_cache *c     |   The cache
+*       cache_key *key      |   The shot
+*       double value        |   What it solved to
+*       const char *text    |   Its line, as printed
+*       size_t len          |   Length of the line
+*/
+void cache_put( result_cache *c, const cache_key *key, double value,
+        const char *text, size_t len )
+{
+    uint64_t h = key_hash( key );
+    size_t set = ( h & ( c->sets - 1 )) * CACHE_WAYS;
+    uint32_t *tags = c->tags + set;
+    uint32_t tag = (uint32_t)( h >> 32 ) | 1;
+    cache_entry *ways = c->entries + set;
+    uint8_t *hand = &c->hands[ set / CACHE_WAYS ];
+    int i;
+
+    if( len == 0 || len > CACHE_TEXT )
+        return;
+
+    /*  Already there (with another value, say), or an empty entry */
+    for( i = 0; i < CACHE_WAYS; ++i )
+        if( tags[i] == 0 || ( tags[i] == tag
+                    && key_equal( &ways[i].key, key )))
+            break;
+
+    /*  Full:  round the clock to the first entry not used since last time */
+    if( i == CACHE_WAYS )
+    {
+        while( ways[ *hand ].ref )
+        {
+            ways[ *hand ].ref = 0;
+            *hand = ( *hand + 1 ) % CACHE_WAYS;
+        }
+
+        i = *hand;
+        *hand = ( *hand + 1 ) % CACHE_WAYS;
+    }
+
+    tags[i] = tag;
+    ways[i].key = *key;
+    ways[i].value = value;
+    ways[i].len = len;
+    ways[i].ref = 1;
+    memcpy( ways[i].text, text, len );
+}
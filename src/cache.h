@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *  cache.h     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  A bounded cache of formatted results for the server's '--cache', keyed
+ *  by a shot's inputs and everything in its context that changes the answer
+ *  or how it's printed.  The server is one thread, so nothing in it is
+ *  locked.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_CACHE_H
+#define MUZZ_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "muzz.h"
+#include "arena.h"
+
+
+/*  Entries a set holds; a key can only ever be in its own set */
+#define CACHE_WAYS 8
+
+/*  Longest line an entry keeps; longer ones just aren't cached */
+#define CACHE_TEXT 72
+
+/*  Entries, if '--cache' doesn't say */
+#define CACHE_DEFAULT 16384
+
+
+/*  What a result depends on */
+typedef struct cache_key {
+    double in[ 3 ];         //  The inputs, in command line order (0 if unused)
+    double k;               //  The resolved constant
+    uint32_t flags;         //  solve, si, verbose and precise
+} cache_key;
+
+
+/*  One result, two cache lines' worth */
+typedef struct cache_entry {
+    cache_key key;
+    double value;           //  What was solved for
+    uint16_t len;           //  Of text
+    uint8_t ref;            //  Used since the clock hand last went by
+    char text[ CACHE_TEXT ];
+} cache_entry;
+
+
+typedef struct result_cache {
+    cache_entry *entries;   //  Sets of CACHE_WAYS, one after the other
+    uint32_t *tags;         //  Each entry's hash, for a quick look; 0 if empty
+    uint8_t *hands;         //  Each set's clock hand
+    size_t sets;            //  A power of two
+} result_cache;
+
+
+/*
+ *  A cache of about entries results (rounded up to whole sets, a power of
+ *  two of them), its table in mem.  Returns 0, or -1 if we're out of memory.
+ */
+int cache_init( result_cache *c, size_t entries, arena *mem );
+
+/*  The key for a shot's inputs (muzz_inputs() of them) under ctx */
+void cache_key_set( cache_key *key, const muzz_ctx *ctx, const double *nums );
+
+/*  The entry for a key, marked as used, or NULL */
+cache_entry *cache_find( result_cache *c, const cache_key *key );
+
+/*
+ *  Keeps a result and its line.  If the key's set is full, the clock picks
+ *  an entry that hasn't been used lately to make room.
+ */
+void cache_put( result_cache *c, const cache_key *key, double value,
+        const char *text, size_t len );
+
+#endif
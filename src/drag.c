@@ -0,0 +1,304 @@
+/*******************************************************************************
+ *  drag.c      |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Downrange velocity from a G1 or G7 drag model and a ballistic coefficient.
+ *
+ *  Flat fire, a bullet slows by dv/dx = -(rho * pi / 8) * Cd(v) * v / BC,
+ *  where Cd is the standard projectile's drag coefficient at v's Mach number
+ *  and BC is in kg/m^2.  Divide through by the BC and what's left doesn't
+ *  depend on the bullet at all, so it only has to be integrated once per
+ *  model:  space[i] is how far (times the BC) the model takes to slow from
+ *  DRAG_MAX down to the i'th speed of a 1 m/s grid.  That's Siacci's space
+ *  function.  A bullet's velocity at x is then a lookup of where its muzzle
+ *  velocity is on the table, plus x / BC, and a search for the speed that's
+ *  there:  no integrating per bullet, and the two tables (about 27 KiB) stay
+ *  in cache however many bullets and ranges there are.  Outside the grid,
+ *  Cd is taken as constant, which makes the decay exactly exponential.
+ *
+ *  The tables are filled in when the library loads.  The atmosphere is the
+ *  ICAO standard at sea level.
+ *
+ ******************************************************************************/
+#include <math.h>
+
+#include "muzz.h"
+
+
+/*  ICAO standard atmosphere at sea level:  density (kg/m^3), speed of sound */
+#define AIR_DENSITY 1.2250
+#define SOUND_SPEED 340.294
+
+/*  rho * pi / 8 */
+#define DRAG_K ( AIR_DENSITY * 3.14159265358979323846 / 8 )
+
+/*  The speeds the space function is tabled for (m/s) */
+#define DRAG_MIN 10.0
+#define DRAG_MAX 1700.0
+#define DRAG_STEP 1.0
+#define DRAG_POINTS 1691        //  ( DRAG_MAX - DRAG_MIN ) / DRAG_STEP + 1
+
+/*  Simpson's rule intervals per step of the grid, when filling it in */
+#define DRAG_SIMPSON 8
+
+/*  Units */
+#define FPS_TO_MPS 0.3048
+#define YD_TO_M 0.9144
+#define LB_IN2_TO_KG_M2 703.0695796
+
+
+/*  A standard projectile's drag coefficient at one Mach number */
+typedef struct drag_point {
+    double mach;
+    double cd;
+} drag_point;
+
+
+/*  The G1 standard projectile (flat base, 2 calibre ogive) */
+static const drag_point g1[] = {
+    { 0.00, 0.2629 }, { 0.05, 0.2558 }, { 0.10, 0.2487 }, { 0.15, 0.2413 },
+    { 0.20, 0.2344 }, { 0.25, 0.2278 }, { 0.30, 0.2214 }, { 0.35, 0.2155 },
+    { 0.40, 0.2104 }, { 0.45, 0.2061 }, { 0.50, 0.2032 }, { 0.55, 0.2020 },
+    { 0.60, 0.2034 }, { 0.70, 0.2165 }, { 0.725, 0.2230 }, { 0.75, 0.2313 },
+    { 0.775, 0.2417 }, { 0.80, 0.2546 }, { 0.825, 0.2706 }, { 0.85, 0.2901 },
+    { 0.875, 0.3136 }, { 0.90, 0.3415 }, { 0.925, 0.3734 }, { 0.95, 0.4084 },
+    { 0.975, 0.4448 }, { 1.00, 0.4805 }, { 1.025, 0.5136 }, { 1.05, 0.5427 },
+    { 1.075, 0.5677 }, { 1.10, 0.5883 }, { 1.125, 0.6053 }, { 1.15, 0.6191 },
+    { 1.20, 0.6393 }, { 1.25, 0.6518 }, { 1.30, 0.6589 }, { 1.35, 0.6621 },
+    { 1.40, 0.6625 }, { 1.45, 0.6607 }, { 1.50, 0.6573 }, { 1.55, 0.6528 },
+    { 1.60, 0.6474 }, { 1.65, 0.6413 }, { 1.70, 0.6347 }, { 1.75, 0.6280 },
+    { 1.80, 0.6210 }, { 1.85, 0.6141 }, { 1.90, 0.6072 }, { 1.95, 0.6003 },
+    { 2.00, 0.5934 }, { 2.05, 0.5867 }, { 2.10, 0.5804 }, { 2.15, 0.5743 },
+    { 2.20, 0.5685 }, { 2.25, 0.5630 }, { 2.30, 0.5577 }, { 2.35, 0.5527 },
+    { 2.40, 0.5481 }, { 2.45, 0.5438 }, { 2.50, 0.5397 }, { 2.60, 0.5325 },
+    { 2.70, 0.5264 }, { 2.80, 0.5211 }, { 2.90, 0.5168 }, { 3.00, 0.5133 },
+    { 3.10, 0.5105 }, { 3.20, 0.5084 }, { 3.30, 0.5067 }, { 3.40, 0.5054 },
+    { 3.50, 0.5040 }, { 3.60, 0.5030 }, { 3.70, 0.5022 }, { 3.80, 0.5016 },
+    { 3.90, 0.5010 }, { 4.00, 0.5006 }, { 4.20, 0.4998 }, { 4.40, 0.4995 },
+    { 4.60, 0.4992 }, { 4.80, 0.4990 }, { 5.00, 0.4988 }
+};
+
+
+/*  The G7 standard projectile (boat tail, long secant ogive) */
+static const drag_point g7[] = {
+    { 0.00, 0.1198 }, { 0.05, 0.1197 }, { 0.10, 0.1196 }, { 0.15, 0.1194 },
+    { 0.20, 0.1193 }, { 0.25, 0.1194 }, { 0.30, 0.1194 }, { 0.35, 0.1194 },
+    { 0.40, 0.1193 }, { 0.45, 0.1193 }, { 0.50, 0.1194 }, { 0.55, 0.1193 },
+    { 0.60, 0.1194 }, { 0.65, 0.1197 }, { 0.70, 0.1202 }, { 0.725, 0.1207 },
+    { 0.75, 0.1215 }, { 0.775, 0.1226 }, { 0.80, 0.1242 }, { 0.825, 0.1266 },
+    { 0.85, 0.1306 }, { 0.875, 0.1368 }, { 0.90, 0.1464 }, { 0.925, 0.1660 },
+    { 0.95, 0.2054 }, { 0.975, 0.2993 }, { 1.00, 0.3803 }, { 1.025, 0.4015 },
+    { 1.05, 0.4043 }, { 1.075, 0.4034 }, { 1.10, 0.4014 }, { 1.125, 0.3987 },
+    { 1.15, 0.3955 }, { 1.20, 0.3884 }, { 1.25, 0.3810 }, { 1.30, 0.3732 },
+    { 1.35, 0.3657 }, { 1.40, 0.3580 }, { 1.50, 0.3440 }, { 1.55, 0.3376 },
+    { 1.60, 0.3315 }, { 1.65, 0.3260 }, { 1.70, 0.3209 }, { 1.75, 0.3160 },
+    { 1.80, 0.3117 }, { 1.85, 0.3078 }, { 1.90, 0.3042 }, { 1.95, 0.3010 },
+    { 2.00, 0.2980 }, { 2.05, 0.2951 }, { 2.10, 0.2922 }, { 2.15, 0.2892 },
+    { 2.20, 0.2864 }, { 2.25, 0.2835 }, { 2.30, 0.2807 }, { 2.35, 0.2779 },
+    { 2.40, 0.2752 }, { 2.45, 0.2725 }, { 2.50, 0.2697 }, { 2.55, 0.2670 },
+    { 2.60, 0.2643 }, { 2.65, 0.2615 }, { 2.70, 0.2588 }, { 2.75, 0.2561 },
+    { 2.80, 0.2533 }, { 2.85, 0.2506 }, { 2.90, 0.2479 }, { 2.95, 0.2451 },
+    { 3.00, 0.2424 }, { 3.10, 0.2368 }, { 3.20, 0.2313 }, { 3.30, 0.2258 },
+    { 3.40, 0.2205 }, { 3.50, 0.2154 }, { 3.60, 0.2106 }, { 3.70, 0.2060 },
+    { 3.80, 0.2017 }, { 3.90, 0.1975 }, { 4.00, 0.1935 }, { 4.20, 0.1861 },
+    { 4.40, 0.1793 }, { 4.60, 0.1730 }, { 4.80, 0.1672 }, { 5.00, 0.1618 }
+};
+
+
+/*  One model:  its drag curve, and what's worked out from it */
+typedef struct drag_model {
+    const drag_point *curve;
+    int points;
+    double space[ DRAG_POINTS ];    //  At DRAG_MIN + i * DRAG_STEP
+    double low;                     //  Cd below DRAG_MIN
+    double high;                    //  Cd above DRAG_MAX
+} drag_model;
+
+static drag_model models[ 2 ] = {
+    { g1, sizeof( g1 ) / sizeof( g1[0] ), { 0 }, 0, 0 },
+    { g7, sizeof( g7 ) / sizeof( g7[0] ), { 0 }, 0, 0 }
+};
+
+
+
+/*==============================================================================
+                                   DRAG CD
+--------------------------------------------------------------------------------
+*   A model's drag coefficient at a speed (m/s), interpolated straight
+*   between the Mach numbers of its curve.
+*/
+static double drag_cd( const drag_model *m, double v )
+{
+    double mach = v / SOUND_SPEED;
+    int lo = 0;
+    int hi = m->points - 1;
+    int mid;
+
+    if( mach <= m->curve[0].mach )
+        return( m->curve[0].cd );
+    if( mach >= m->curve[ hi ].mach )
+        return( m->curve[ hi ].cd );
+
+    while( hi - lo > 1 )
+    {
+        mid = ( lo + hi ) / 2;
+        if( m->curve[ mid ].mach <= mach )
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return( m->curve[ lo ].cd + ( m->curve[ hi ].cd - m->curve[ lo ].cd )
+            * ( mach - m->curve[ lo ].mach )
+            / ( m->curve[ hi ].mach - m->curve[ lo ].mach ));
+}
+
+
+
+/*==============================================================================
+                                   DRAG INIT
+--------------------------------------------------------------------------------
+*   Integrates each model's space function down from DRAG_MAX, a step of the
+*   grid at a time, by Simpson's rule.
+*/
+__attribute__(( constructor ))
+static void drag_init( void )
+{
+    drag_model *m;
+    double h = DRAG_STEP / DRAG_SIMPSON;
+    double v, sum;
+    int i, j;
+
+    for( m = models; m < models + 2; ++m )
+    {
+        m->space[ DRAG_POINTS - 1 ] = 0;
+        m->low = drag_cd( m, DRAG_MIN );
+        m->high = drag_cd( m, DRAG_MAX );
+
+        for( i = DRAG_POINTS - 2; i >= 0; --i )
+        {
+            sum = 0;
+            for( j = 0; j <= DRAG_SIMPSON; ++j )
+            {
+                v = DRAG_MIN + i * DRAG_STEP + j * h;
+                sum += ( j == 0 || j == DRAG_SIMPSON ? 1 : ( j % 2 ? 4 : 2 ))
+                    / ( DRAG_K * v * drag_cd( m, v ));
+            }
+
+            m->space[i] = m->space[ i + 1 ] + sum * h / 3;
+        }
+    }
+}
+
+
+
+/*==============================================================================
+                                  SPACE AT
+--------------------------------------------------------------------------------
+*   Where a speed (m/s) is on a model's space function.
+*/
+static double space_at( const drag_model *m, double v )
+{
+    double pos;
+    int i;
+
+    if( v >= DRAG_MAX )
+        return( -log( v / DRAG_MAX ) / ( DRAG_K * m->high ));
+
+    if( v <= DRAG_MIN )
+        return( m->space[0] - log( v / DRAG_MIN ) / ( DRAG_K * m->low ));
+
+    pos = ( v - DRAG_MIN ) / DRAG_STEP;
+    i = (int)pos;
+    if( i > DRAG_POINTS - 2 )
+        i = DRAG_POINTS - 2;
+
+    return( m->space[i] + ( m->space[ i + 1 ] - m->space[i] ) * ( pos - i ));
+}
+
+
+
+/*==============================================================================
+                                  SPEED AT
+--------------------------------------------------------------------------------
+*   The speed (m/s) at a point on a model's space function:  the inverse of
+*   space_at().
+*/
+static double speed_at( const drag_model *m, double s )
+{
+    int lo = 0;
+    int hi = DRAG_POINTS - 1;
+    int mid;
+
+    if( s <= 0 )
+        return( DRAG_MAX * exp( -s * DRAG_K * m->high ));
+
+    if( s >= m->space[0] )
+        return( DRAG_MIN * exp( -( s - m->space[0] ) * DRAG_K * m->low ));
+
+    /*  space[] only goes down:  find space[lo] >= s > space[hi] */
+    while( hi - lo > 1 )
+    {
+        mid = ( lo + hi ) / 2;
+        if( m->space[ mid ] >= s )
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return( DRAG_MIN + DRAG_STEP * ( lo + ( m->space[ lo ] - s )
+                / ( m->space[ lo ] - m->space[ hi ] )));
+}
+
+
+
+/*==============================================================================
+                                 DOWNRANGE
+--------------------------------------------------------------------------------
+*   Velocity left after a distance, for a bullet of the given BC under a drag
+*   model.  Units are the context's:  ft/s and yards, or m/s and meters; the
+*   BC is in lb/in^2 either way, since that's how they're published.
+*
+*   Params
+*       muzz_ctx *ctx       |   The context
+*       int drag            |   One of enum muzz_drag
+*       double bc           |   Ballistic coefficient
+*       double velocity     |   Muzzle velocity
+*       double distance     |   How far downrange
+*/
+double muzz_downrange( const muzz_ctx *ctx, int drag, double bc,
+        double velocity, double distance )
+{
+    const drag_model *m = &models[ drag == MUZZ_DRAG_G7 ];
+    double v = velocity;
+    double x = distance;
+
+    if( ! ctx->si )
+    {
+        v *= FPS_TO_MPS;
+        x *= YD_TO_M;
+    }
+
+    if( !( v > 0 ) || !( bc > 0 ))
+        return( NAN );
+
+    v = speed_at( m, space_at( m, v ) + x / ( bc * LB_IN2_TO_KG_M2 ));
+    return( ctx->si ? v : v / FPS_TO_MPS );
+}
+
+
+
+/*==============================================================================
+                                DOWNRANGE (N)
+--------------------------------------------------------------------------------
+*/
+void muzz_downrange_n( const muzz_ctx *ctx, int drag, const double *bc,
+        const double *velocity, const double *distance, double *out,
+        size_t n )
+{
+    size_t i;
+
+    for( i = 0; i < n; ++i )
+        out[i] = muzz_downrange( ctx, drag, bc[i], velocity[i], distance[i] );
+}
@@ -0,0 +1,307 @@
+/*******************************************************************************
+ *  fixed.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The formulas in fixed point (see muzzfix.h).  Every one of them comes down
+ *  to a * b / c, rounded, sometimes followed by a square root:
+ *
+ *      energy      m v^2 / ( 1000 K )          (2000 K, Si)
+ *      mass        E K 1000 / v^2              (E K 2000, Si)
+ *      velocity    sqrt( E K 1000 / m )        (E K 2000, Si)
+ *      TKOF        m v d / ( 1e6 div )
+ *      backwards   T div 1e6 / ( other d )
+ *
+ *  where everything's in thousandths, and the 1000s put the answer back in
+ *  thousandths too.  So there's one mul_div(), with a 96 bit product in
+ *  between so nothing overflows on the way, and one integer square root.
+ *  The division is done a bit at a time, 64 steps, and the root 32, so
+ *  there's no call to a division helper (a Cortex-M0 has no divide
+ *  instruction) and every shot takes the same number of steps.
+ *
+ *  This file includes nothing that needs a C library, on purpose.
+ *
+ ******************************************************************************/
+#include <stdint.h>
+
+#include "muzzfix.h"
+
+
+/*  K, in thousandths */
+#define FIX_K_INDUSTRY      450240000u
+#define FIX_K_GAC1          450282000u      //  2 * 32.163 * 7000
+#define FIX_K_GAC2          450434600u      //  2 * 32.1739 * 7000
+#define FIX_K_SI            1000000u
+
+/*  Divisors for the Taylor Knockout Formula */
+#define FIX_TKOF_IMPERIAL   7000u
+#define FIX_TKOF_SI         3500u
+
+
+
+/*==============================================================================
+                                    MUL DIV
+--------------------------------------------------------------------------------
+*   a * b / c, rounded to the nearest, or UINT64_MAX if it doesn't fit (or c
+*   is 0).  The product is 96 bits, in hi and lo, and is divided by shifting
+*   and subtracting, a bit of the quotient per step.
+*
+*   Params
+*       uint64_t a      |   First factor
+*       uint32_t b      |   Second factor
+*       uint64_t c      |   Divisor
+*/
+static uint64_t mul_div( uint64_t a, uint32_t b, uint64_t c )
+{
+    uint64_t lo = (uint64_t)(uint32_t)a * b;
+    uint64_t mid = ( a >> 32 ) * b;
+    uint64_t hi = mid >> 32;
+    uint64_t quot = 0;
+    uint64_t rem;
+    uint64_t top;
+    int i;
+
+    lo += mid << 32;
+    if( lo < ( mid << 32 ))
+        ++hi;
+
+    /*  Round to the nearest */
+    lo += c >> 1;
+    if( lo < ( c >> 1 ))
+        ++hi;
+
+    /*  The quotient only fits in 64 bits if the top word is less than c */
+    if( hi >= c )
+        return( UINT64_MAX );
+
+    rem = hi;
+    for( i = 0; i < 64; ++i )
+    {
+        top = rem >> 63;
+        rem = ( rem << 1 ) | ( lo >> 63 );
+        lo <<= 1;
+        quot <<= 1;
+
+        if( top || rem >= c )
+        {
+            rem -= c;
+            quot |= 1;
+        }
+    }
+
+    return( quot );
+}
+
+
+
+/*==============================================================================
+                                     ISQRT
+--------------------------------------------------------------------------------
+*   The square root of x, rounded to the nearest, two bits of x at a time.
+*/
+static uint64_t isqrt( uint64_t x )
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    int i;
+
+    for( i = 0; i < 32; ++i )
+    {
+        if( x >= root + bit )
+        {
+            x -= root + bit;
+            root = ( root >> 1 ) + bit;
+        }
+        else
+            root >>= 1;
+
+        bit >>= 2;
+    }
+
+    /*  x is what's left over, x - root^2; past root + 1/2 rounds up */
+    return( x > root ? root + 1 : root );
+}
+
+
+
+/*==============================================================================
+                                      FIT
+--------------------------------------------------------------------------------
+*   A result as a muzz_fix, or MUZZ_FIX_MAX if it's too big for one.
+*/
+static muzz_fix fit( uint64_t x )
+{
+    return( x > MUZZ_FIX_MAX ? MUZZ_FIX_MAX : (muzz_fix)x );
+}
+
+
+
+/*==============================================================================
+                                    FIX INIT
+--------------------------------------------------------------------------------
+*   Sets a context to the defaults:  Imperial units, industry standard K.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   The context to set up
+*/
+void muzz_fix_init( muzz_fix_ctx *ctx )
+{
+    ctx->si = 0;
+    ctx->kMode = MUZZ_K_INDUSTRY;
+    ctx->customK = 0;
+
+    muzz_fix_resolve( ctx );
+}
+
+
+
+/*==============================================================================
+                                  FIX RESOLVE
+--------------------------------------------------------------------------------
+*   Works out K, as muzz_ctx_resolve() does:  a custom K is used as it is,
+*   in any units; otherwise Si units use 1000.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   The context
+*/
+void muzz_fix_resolve( muzz_fix_ctx *ctx )
+{
+    switch( ctx->kMode )
+    {
+        case MUZZ_K_CUSTOM: ctx->k = ctx->customK;      return;
+        case MUZZ_K_GAC1:   ctx->k = FIX_K_GAC1;        break;
+        case MUZZ_K_GAC2:   ctx->k = FIX_K_GAC2;        break;
+        default:            ctx->k = FIX_K_INDUSTRY;    break;
+    }
+
+    if( ctx->si )
+        ctx->k = FIX_K_SI;
+}
+
+
+
+/*==============================================================================
+                                   FIX ENERGY
+--------------------------------------------------------------------------------
+*   Returns the energy, given the mass and velocity of the projectile.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   Units and constant
+*       muzz_fix mass       |   Mass of the projectile
+*       muzz_fix velocity   |   Velocity of the projectile
+*/
+muzz_fix muzz_fix_energy( const muzz_fix_ctx *ctx, muzz_fix mass,
+        muzz_fix velocity )
+{
+    uint64_t div = (uint64_t)ctx->k * ( ctx->si ? 2000 : 1000 );
+
+    return( fit( mul_div( (uint64_t)velocity * velocity, mass, div )));
+}
+
+
+
+/*==============================================================================
+                                    FIX MASS
+--------------------------------------------------------------------------------
+*   Returns the mass, given the velocity and energy of the projectile.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   Units and constant
+*       muzz_fix velocity   |   Velocity of the projectile
+*       muzz_fix energy     |   Energy of the projectile
+*/
+muzz_fix muzz_fix_mass( const muzz_fix_ctx *ctx, muzz_fix velocity,
+        muzz_fix energy )
+{
+    return( fit( mul_div( (uint64_t)energy * ctx->k, ( ctx->si ? 2000 : 1000 ),
+                    (uint64_t)velocity * velocity )));
+}
+
+
+
+/*==============================================================================
+                                  FIX VELOCITY
+--------------------------------------------------------------------------------
+*   Returns the velocity, given the mass and energy of the projectile.  A
+*   square too big to take the root of comes out as MUZZ_FIX_MAX, the same
+*   as a root too big to keep.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   Units and constant
+*       muzz_fix mass       |   Mass of the projectile
+*       muzz_fix energy     |   Energy of the projectile
+*/
+muzz_fix muzz_fix_velocity( const muzz_fix_ctx *ctx, muzz_fix mass,
+        muzz_fix energy )
+{
+    uint64_t square = mul_div( (uint64_t)energy * ctx->k,
+            ( ctx->si ? 2000 : 1000 ), mass );
+
+    if( square == UINT64_MAX )
+        return( MUZZ_FIX_MAX );
+
+    return( fit( isqrt( square )));
+}
+
+
+
+/*==============================================================================
+                                    FIX TKOF
+--------------------------------------------------------------------------------
+*   Returns the Taylor knockout factor of the projectile.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   Units
+*       muzz_fix mass       |   Mass of the projectile
+*       muzz_fix velocity   |   Velocity of the projectile
+*       muzz_fix diameter   |   Diameter of the projectile
+*/
+muzz_fix muzz_fix_tkof( const muzz_fix_ctx *ctx, muzz_fix mass,
+        muzz_fix velocity, muzz_fix diameter )
+{
+    uint32_t div = ( ctx->si ? FIX_TKOF_SI : FIX_TKOF_IMPERIAL );
+
+    return( fit( mul_div( (uint64_t)mass * velocity, diameter,
+                    (uint64_t)div * 1000000 )));
+}
+
+
+
+/*==============================================================================
+                                 FIX TKOF MASS
+--------------------------------------------------------------------------------
+*   Returns the mass it takes to reach a TKOF.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   Units
+*       muzz_fix velocity   |   Velocity of the projectile
+*       muzz_fix diameter   |   Diameter of the projectile
+*       muzz_fix tkof       |   The TKOF to reach
+*/
+muzz_fix muzz_fix_tkof_mass( const muzz_fix_ctx *ctx, muzz_fix velocity,
+        muzz_fix diameter, muzz_fix tkof )
+{
+    uint32_t div = ( ctx->si ? FIX_TKOF_SI : FIX_TKOF_IMPERIAL );
+
+    return( fit( mul_div( (uint64_t)tkof * div, 1000000,
+                    (uint64_t)velocity * diameter )));
+}
+
+
+
+/*==============================================================================
+                               FIX TKOF VELOCITY
+--------------------------------------------------------------------------------
+*   Returns the velocity it takes to reach a TKOF.
+*
+*   Params
+*       muzz_fix_ctx *ctx   |   Units
+*       muzz_fix mass       |   Mass of the projectile
+*       muzz_fix diameter   |   Diameter of the projectile
+*       muzz_fix tkof       |   The TKOF to reach
+*/
+muzz_fix muzz_fix_tkof_velocity( const muzz_fix_ctx *ctx, muzz_fix mass,
+        muzz_fix diameter, muzz_fix tkof )
+{
+    return( muzz_fix_tkof_mass( ctx, mass, diameter, tkof ));
+}
@@ -0,0 +1,415 @@
+/*******************************************************************************
+ *  format.c    |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Formatting results.  Every line muzz prints is a few bits of fixed text
+ *  and a few numbers with 0, 2 or 3 decimals, so rather than have printf
+ *  parse a format string for every record we write the pieces ourselves.
+ *
+ *  fmt_fixed() gives exactly what printf's "%.*f" does.  A double is a whole
+ *  number times a power of two, so for anything up to about 2^53 we can work
+ *  out (number * 10^decimals) exactly in 64 bits and round it the way glibc
+ *  does (to nearest, ties to even).  Anything bigger, and infinities and NaN,
+ *  go to snprintf().
+ *
+ *  The CSV and NDJSON lines go one step further:  the run's layout is made
+ *  into a template once, literal text and number slots, so a line is just
+ *  memcpy()s and fmt_fixed()s with nothing left to decide.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "muzz.h"
+#include "format.h"
+
+
+/*  Most decimals the fast path handles */
+#define FAST_DECIMALS 3
+
+static const uint64_t scales[ FAST_DECIMALS + 1 ] = { 1, 10, 100, 1000 };
+
+
+
+/*==============================================================================
+                                   FMT UINT
+--------------------------------------------------------------------------------
+*   Writes an unsigned number, padded with zeros to at least 'width' digits.
+*   Returns the end of what was written.
+*/
+static char *fmt_uint( char *p, uint64_t n, int width )
+{
+    char digits[ 20 ];
+    int len = 0;
+
+    do
+    {
+        digits[ len++ ] = '0' + ( n % 10 );
+        n /= 10;
+    } while( n > 0 );
+
+    while( len < width )
+        digits[ len++ ] = '0';
+
+    while( len > 0 )
+        *p++ = digits[ --len ];
+
+    return( p );
+}
+
+
+
+/*==============================================================================
+                                   FMT FIXED
+--------------------------------------------------------------------------------
+*   Writes a number with a fixed number of decimals, the same as printf's
+*   "%.*f", and returns the end of what was written.
+*
+*   Params
+*       char *p         |   Where to write; needs FMT_FIXED_MAX bytes
+*       double v        |   The number
+*       int decimals    |   How many decimals
+*/
+char *fmt_fixed( char *p, double v, int decimals )
+{
+    uint64_t bits;
+    uint64_t mantissa;
+    uint64_t scaled;
+    uint64_t rem;
+    uint64_t half;
+    uint64_t scale;
+    int exponent;
+    int shift;
+
+    memcpy( &bits, &v, sizeof( bits ));
+    mantissa = bits & ( ( (uint64_t)1 << 52 ) - 1 );
+    exponent = (int)( ( bits >> 52 ) & 0x7ff );
+
+    /*  Infinity, NaN, or more decimals than we bother with */
+    if( exponent == 0x7ff || decimals < 0 || decimals > FAST_DECIMALS )
+        return( p + snprintf( p, FMT_FIXED_MAX, "%.*f", decimals, v ));
+
+    /*  v = mantissa * 2^exponent */
+    if( exponent == 0 )
+        exponent = -1074;
+    else
+    {
+        mantissa |= (uint64_t)1 << 52;
+        exponent -= 1075;
+    }
+
+    scale = scales[ decimals ];
+
+    /*  A whole number; fine as long as it fits once scaled */
+    if( exponent >= 0 )
+    {
+        if( exponent > 10 || ( mantissa << exponent ) > UINT64_MAX / scale )
+            return( p + snprintf( p, FMT_FIXED_MAX, "%.*f", decimals, v ));
+
+        scaled = ( mantissa << exponent ) * scale;
+    }
+
+    /*  Has a fraction; mantissa * scale < 2^63, so this is all exact */
+    else
+    {
+        scaled = mantissa * scale;
+        shift = -exponent;
+
+        /*  Less than half of the last decimal place */
+        if( shift >= 64 )
+            scaled = 0;
+
+        else
+        {
+            rem = scaled & ( ( (uint64_t)1 << shift ) - 1 );
+            half = (uint64_t)1 << ( shift - 1 );
+            scaled >>= shift;
+
+            if( rem > half || ( rem == half && ( scaled & 1 )))
+                ++scaled;
+        }
+    }
+
+    if( bits >> 63 )
+        *p++ = '-';
+
+    p = fmt_uint( p, scaled / scale, 1 );
+
+    if( decimals > 0 )
+    {
+        *p++ = '.';
+        p = fmt_uint( p, scaled % scale, decimals );
+    }
+
+    return( p );
+}
+
+
+
+/*==============================================================================
+                                 TEMPLATE INIT
+--------------------------------------------------------------------------------
+*   Params
+*       fmt_template *t         |   The template
+*       const char *nonFinite   |   What an infinity or NaN is written as
+*                               |   ("null", in JSON), or NULL
+*/
+void fmt_template_init( fmt_template *t, const char *nonFinite )
+{
+    t->textLen = 0;
+    t->litEnd[0] = 0;
+    t->numSlots = 0;
+    t->nonFinite = nonFinite;
+}
+
+
+
+/*==============================================================================
+                                 TEMPLATE TEXT
+--------------------------------------------------------------------------------
+*   Adds text onto the end of the literal after the last slot.
+*/
+int fmt_template_text( fmt_template *t, const char *s )
+{
+    size_t len = strlen( s );
+
+    if( t->textLen + len > FMT_TEMPLATE_TEXT )
+        return( -1 );
+
+    memcpy( t->text + t->textLen, s, len );
+    t->textLen += len;
+    t->litEnd[ t->numSlots ] = (uint16_t)t->textLen;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 TEMPLATE SLOT
+--------------------------------------------------------------------------------
+*   Params
+*       fmt_template *t |   The template
+*       int value       |   Which of the values it's filled with
+*       int decimals    |   How many decimals it gets
+*/
+int fmt_template_slot( fmt_template *t, int value, int decimals )
+{
+    if( t->numSlots == FMT_TEMPLATE_SLOTS )
+        return( -1 );
+
+    t->values[ t->numSlots ] = value;
+    t->decimals[ t->numSlots ] = decimals;
+    ++t->numSlots;
+    t->litEnd[ t->numSlots ] = (uint16_t)t->textLen;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 TEMPLATE MAX
+--------------------------------------------------------------------------------
+*/
+size_t fmt_template_max( const fmt_template *t )
+{
+    return( t->textLen + t->numSlots * FMT_FIXED_MAX );
+}
+
+
+
+/*==============================================================================
+                                 TEMPLATE WRITE
+--------------------------------------------------------------------------------
+*   Params
+*       fmt_template *t         |   The template
+*       const double *values    |   What its slots show
+*       char *p                 |   Where to write; fmt_template_max() bytes
+*/
+char *fmt_template_write( const fmt_template *t, const double *values,
+        char *p )
+{
+    size_t start = 0;
+    double v;
+    int i;
+
+    for( i = 0; i < t->numSlots; ++i )
+    {
+        memcpy( p, t->text + start, t->litEnd[i] - start );
+        p += t->litEnd[i] - start;
+        start = t->litEnd[i];
+
+        v = values[ t->values[i] ];
+        if( t->nonFinite != NULL && ! isfinite( v ))
+        {
+            memcpy( p, t->nonFinite, strlen( t->nonFinite ));
+            p += strlen( t->nonFinite );
+        }
+        else
+            p = fmt_fixed( p, v, t->decimals[i] );
+    }
+
+    memcpy( p, t->text + start, t->textLen - start );
+    return( p + t->textLen - start );
+}
+
+
+
+/*==============================================================================
+                                 FORMAT RESULT
+--------------------------------------------------------------------------------
+*   Writes the standard (energy) result of a shot the way the muzz program has
+*   always printed it.  Returns the end of what was written.
+*/
+static char *format_result( const muzz_ctx *ctx, const muzz_shot *shot,
+        char *p )
+{
+    /*  Terse; only the number we solved for */
+    if( ! ctx->verbose )
+    {
+        p = fmt_fixed( p, *muzz_shot_wanted( ctx, (muzz_shot *)shot ),
+                ( ctx->precise ? 2 : 0 ));
+        return( FMT_LIT( p, "\n" ));
+    }
+
+    /*  Si */
+    if( ctx->si )
+    {
+        p = fmt_fixed( p, shot->mass, 2 );
+        p = FMT_LIT( p, " g @ " );
+        p = fmt_fixed( p, shot->velocity, 2 );
+        p = FMT_LIT( p, " m/s = " );
+
+        if( ctx->precise )
+            p = fmt_fixed( p, shot->energy, 2 );
+        else
+            p = fmt_fixed( p, round( shot->energy ), 0 );
+
+        return( FMT_LIT( p, " J\n" ));
+    }
+
+    /*  Imperial, if we're being precise */
+    if( ctx->precise )
+    {
+        p = fmt_fixed( p, shot->mass, 2 );
+        p = FMT_LIT( p, " gr @ " );
+        p = fmt_fixed( p, shot->velocity, 2 );
+        p = FMT_LIT( p, " ft/s = " );
+        p = fmt_fixed( p, shot->energy, 2 );
+        return( FMT_LIT( p, " lbf\n" ));
+    }
+
+    /*  Otherwise, keep the output prettier */
+    p = fmt_fixed( p, round( shot->mass ), 0 );
+    p = FMT_LIT( p, " gr @ " );
+    p = fmt_fixed( p, round( shot->velocity ), 0 );
+    p = FMT_LIT( p, " ft/s = " );
+    p = fmt_fixed( p, round( shot->energy ), 0 );
+    return( FMT_LIT( p, " lbf\n" ));
+}
+
+
+
+/*==============================================================================
+                                  FORMAT TKOF
+--------------------------------------------------------------------------------
+*   Writes the Taylor Knockout result of a shot, whichever way round it was
+*   solved.  Returns the end of what was written.
+*/
+static char *format_tkof( const muzz_ctx *ctx, const muzz_shot *shot,
+        char *p )
+{
+    /*  Terse, and backwards; the mass or velocity, as format_result() has it */
+    if( ! ctx->verbose && ctx->solve != MUZZ_SOLVE_TKOF )
+    {
+        p = fmt_fixed( p, *muzz_shot_wanted( ctx, (muzz_shot *)shot ),
+                ( ctx->precise ? 2 : 0 ));
+        return( FMT_LIT( p, "\n" ));
+    }
+
+    /*  Terse */
+    if( ! ctx->verbose )
+    {
+        p = fmt_fixed( p, shot->tkof, 2 );
+        return( FMT_LIT( p, "\n" ));
+    }
+
+    /*  Si */
+    if( ctx->si )
+    {
+        p = fmt_fixed( p, shot->mass, 2 );
+        p = FMT_LIT( p, " g @ " );
+        p = fmt_fixed( p, shot->velocity, 2 );
+        p = FMT_LIT( p, " m/s (" );
+        p = fmt_fixed( p, shot->diameter, 2 );
+        p = FMT_LIT( p, " mm diameter) = " );
+        p = fmt_fixed( p, shot->tkof, 2 );
+        return( FMT_LIT( p, " TKOF\n" ));
+    }
+
+    /*  Imperial */
+    if( ctx->precise )
+    {
+        p = fmt_fixed( p, shot->mass, 2 );
+        p = FMT_LIT( p, " gr @ " );
+        p = fmt_fixed( p, shot->velocity, 2 );
+    }
+    else
+    {
+        p = fmt_fixed( p, round( shot->mass ), 0 );
+        p = FMT_LIT( p, " gr @ " );
+        p = fmt_fixed( p, round( shot->velocity ), 0 );
+    }
+
+    p = FMT_LIT( p, " ft/s (" );
+    p = fmt_fixed( p, shot->diameter, 3 );
+    p = FMT_LIT( p, "\" diameter) = " );
+    p = fmt_fixed( p, shot->tkof, 2 );
+    return( FMT_LIT( p, " TKOF\n" ));
+}
+
+
+
+/*==============================================================================
+                                     FORMAT
+--------------------------------------------------------------------------------
+*   Writes the line the muzz program prints for a shot into a buffer, newline
+*   and all, and terminates it if there's room.  Returns the length of the
+*   line, as snprintf does.  A buffer of MUZZ_FORMAT_MAX always has room.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*       muzz_shot *shot |   A solved shot
+*       char *buf       |   Where to write
+*       size_t size     |   Size of buf
+*/
+int muzz_format( const muzz_ctx *ctx, const muzz_shot *shot,
+        char *buf, size_t size )
+{
+    char tmp[ MUZZ_FORMAT_MAX ];
+    char *p = ( size >= MUZZ_FORMAT_MAX ? buf : tmp );
+    char *end;
+    size_t len;
+
+    if( muzz_knockout( ctx ))
+        end = format_tkof( ctx, shot, p );
+    else
+        end = format_result( ctx, shot, p );
+
+    len = end - p;
+
+    /*  Didn't have room to write it in place; copy what fits */
+    if( p == tmp && size > 0 )
+    {
+        size_t fits = ( len < size ? len : size - 1 );
+        memcpy( buf, tmp, fits );
+        buf[ fits ] = '\0';
+    }
+
+    else if( p == buf )
+        buf[ len ] = '\0';
+
+    return( (int)len );
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  format.h    |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Writing numbers and text straight into a buffer, for the result lines.
+ *  Internal to libmuzz and the muzz program.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_FORMAT_H
+#define MUZZ_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/*  Longest number fmt_fixed() will ever write (%.3f of the biggest double) */
+#define FMT_FIXED_MAX 320
+
+
+/*
+ *  Writes v with the given number of decimals, exactly as printf's "%.*f"
+ *  would, and returns the end of what was written.  No terminator.  Needs
+ *  FMT_FIXED_MAX bytes of room.
+ */
+char *fmt_fixed( char *p, double v, int decimals );
+
+
+/*  Most numbers a template can have, and how much text goes around them */
+#define FMT_TEMPLATE_SLOTS 8
+#define FMT_TEMPLATE_TEXT 256
+
+
+/*
+ *  A line laid out once, for a whole run:  literal text, a number, literal
+ *  text, a number, ..., literal text.  Each number slot says which of the
+ *  values it's filled from and how many decimals it gets.
+ */
+typedef struct fmt_template {
+    char text[ FMT_TEMPLATE_TEXT ];     //  All the literals, back to back
+    size_t textLen;
+    uint16_t litEnd[ FMT_TEMPLATE_SLOTS + 1 ];  //  Where each one ends
+    int values[ FMT_TEMPLATE_SLOTS ];   //  Which value each slot shows
+    int decimals[ FMT_TEMPLATE_SLOTS ];
+    int numSlots;
+    const char *nonFinite;  //  Written for an infinity or NaN, or NULL for
+                            //  what printf would write
+} fmt_template;
+
+
+/*  An empty template; nonFinite as above */
+void fmt_template_init( fmt_template *t, const char *nonFinite );
+
+/*  Adds literal text, or a number slot.  0, or -1 if there's no room. */
+int fmt_template_text( fmt_template *t, const char *s );
+int fmt_template_slot( fmt_template *t, int value, int decimals );
+
+/*  Longest line the template can write */
+size_t fmt_template_max( const fmt_template *t );
+
+/*
+ *  Writes a line, its slots filled from values, and returns the end of it.
+ *  Needs fmt_template_max() bytes of room.
+ */
+char *fmt_template_write( const fmt_template *t, const double *values,
+        char *p );
+
+
+/*  Copies a string literal (no terminator) and returns the end */
+#define FMT_LIT( p, s ) ( memcpy( (p), (s), sizeof( s ) - 1 ), \
+        (p) + sizeof( s ) - 1 )
+
+#endif
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  formulas.h  |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The formulas, one value at a time, with the units and constant already
+ *  decided.  Everything that calculates (the scalar functions in libmuzz.c,
+ *  the tails of the array kernels) goes through these, so there's exactly one
+ *  place that says how each number is worked out.  Internal to libmuzz.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_FORMULAS_H
+#define MUZZ_FORMULAS_H
+
+#include <math.h>   //  Make sure to link with -lm
+
+
+/*  Divisors for the Taylor Knockout Formula */
+#define TKOF_DIV_IMPERIAL   7000.0
+#define TKOF_DIV_SI         3500.0
+
+
+/*  Energy, Imperial:  ( mass * (velocity*velocity)) / K */
+static inline double energy_imp( double k, double mass, double velocity )
+{
+    return( ( mass * (velocity*velocity)) / k );
+}
+
+/*  Energy, Si:  ( (mass/2) * (velocity*velocity)) / K */
+static inline double energy_si( double k, double mass, double velocity )
+{
+    return( ( (mass/2.0) * (velocity*velocity)) / k );
+}
+
+/*  Mass, Imperial:  (energy/(velocity*velocity)) * K */
+static inline double mass_imp( double k, double velocity, double energy )
+{
+    return( (energy/(velocity*velocity)) * k );
+}
+
+/*  Mass, Si:  ( (energy*2)/(velocity*velocity) ) * K */
+static inline double mass_si( double k, double velocity, double energy )
+{
+    return( ( (energy*2)/(velocity*velocity) ) * k );
+}
+
+/*  Velocity, Imperial:  sqrt( (energy/mass) * K ) */
+static inline double velocity_imp( double k, double mass, double energy )
+{
+    return( sqrt( (energy/mass) * k ));
+}
+
+/*  Velocity, Si:  sqrt( ( (energy*2)/mass ) * K ) */
+static inline double velocity_si( double k, double mass, double energy )
+{
+    return( sqrt( ( (energy*2)/mass ) * k ));
+}
+
+/*  Taylor Knockout Formula:  ( mass * velocity * diameter ) / divisor */
+static inline double tkof_div( double div, double mass, double velocity,
+        double diameter )
+{
+    return( ( mass * velocity * diameter ) / div );
+}
+
+/*  The same, backwards (mass or velocity):  ( tkof * divisor ) / ( other *
+ *  diameter ) */
+static inline double tkof_inv_div( double div, double other, double diameter,
+        double tkof )
+{
+    return( ( tkof * div ) / ( other * diameter ));
+}
+
+#endif
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ *  kernel_body.h   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                       |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The array kernels, written once in terms of a handful of vector macros.
+ *  kernels.c includes this once per instruction set after defining:
+ *
+ *      ISA             Name prefix (scalar, avx2, avx512, neon)
+ *      KERNEL_NAME_STR The same, as a string
+ *      KERNEL_ATTR     Function attributes (e.g. target("avx2")), or nothing
+ *      VEC             Vector type of doubles
+ *      WIDTH           Doubles per vector
+ *      VLOAD(p)        Unaligned load
+ *      VSTORE(p,v)     Unaligned store
+ *      VSET1(x)        Broadcast
+ *      VMUL/VDIV(a,b)  Arithmetic
+ *      VSQRT(a)        Square root
+ *
+ *  Every kernel takes the same arguments (constant, three input columns,
+ *  output, count) so that a muzz_plan can hold any of them; the two-input ones
+ *  ignore the third column.
+ *
+ *  The vector loops do exactly the same operations, in the same order, as the
+ *  scalar formulas in libmuzz.c, so the results are identical to the last bit.
+ *  Whatever's left over after the last whole vector goes through those.
+ *
+ ******************************************************************************/
+
+#define KERNEL_NAME2( a, b )    a##_##b
+#define KERNEL_NAME( a, b )     KERNEL_NAME2( a, b )
+
+
+/*  Energy (Imperial):  ( mass * (velocity*velocity)) / K */
+KERNEL_ATTR static void KERNEL_NAME( ISA, energy_imp )( double k,
+        const double *mass, const double *velocity, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VSTORE( out + i, VDIV( VMUL( VLOAD( mass + i ), VMUL( v, v )), vk ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = energy_imp( k, mass[i], velocity[i] );
+}
+
+
+/*  Energy (Si):  ( (mass/2) * (velocity*velocity)) / K */
+KERNEL_ATTR static void KERNEL_NAME( ISA, energy_si )( double k,
+        const double *mass, const double *velocity, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    VEC half = VSET1( 0.5 );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VEC m = VMUL( VLOAD( mass + i ), half );
+        VSTORE( out + i, VDIV( VMUL( m, VMUL( v, v )), vk ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = energy_si( k, mass[i], velocity[i] );
+}
+
+
+/*  Mass (Imperial):  (energy/(velocity*velocity)) * K */
+KERNEL_ATTR static void KERNEL_NAME( ISA, mass_imp )( double k,
+        const double *velocity, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VSTORE( out + i, VMUL( VDIV( VLOAD( energy + i ), VMUL( v, v )), vk ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = mass_imp( k, velocity[i], energy[i] );
+}
+
+
+/*  Mass (Si):  ( (energy*2)/(velocity*velocity) ) * K */
+KERNEL_ATTR static void KERNEL_NAME( ISA, mass_si )( double k,
+        const double *velocity, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    VEC two = VSET1( 2.0 );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VEC e = VMUL( VLOAD( energy + i ), two );
+        VSTORE( out + i, VMUL( VDIV( e, VMUL( v, v )), vk ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = mass_si( k, velocity[i], energy[i] );
+}
+
+
+/*  Velocity (Imperial):  sqrt( (energy/mass) * K ) */
+KERNEL_ATTR static void KERNEL_NAME( ISA, velocity_imp )( double k,
+        const double *mass, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC r = VDIV( VLOAD( energy + i ), VLOAD( mass + i ));
+        VSTORE( out + i, VSQRT( VMUL( r, vk )));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = velocity_imp( k, mass[i], energy[i] );
+}
+
+
+/*  Velocity (Si):  sqrt( ( (energy*2)/mass ) * K ) */
+KERNEL_ATTR static void KERNEL_NAME( ISA, velocity_si )( double k,
+        const double *mass, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    VEC two = VSET1( 2.0 );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC e = VMUL( VLOAD( energy + i ), two );
+        VEC r = VDIV( e, VLOAD( mass + i ));
+        VSTORE( out + i, VSQRT( VMUL( r, vk )));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = velocity_si( k, mass[i], energy[i] );
+}
+
+
+/*  TKOF:  ( mass * velocity * diameter ) / 7000 (Imperial) or 3500 (Si) */
+KERNEL_ATTR static void KERNEL_NAME( ISA, tkof )( double div,
+        const double *mass, const double *velocity, const double *diameter,
+        double *out, size_t n )
+{
+    VEC vd = VSET1( div );
+    size_t i = 0;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC p = VMUL( VLOAD( mass + i ), VLOAD( velocity + i ));
+        VSTORE( out + i, VDIV( VMUL( p, VLOAD( diameter + i )), vd ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = tkof_div( div, mass[i], velocity[i], diameter[i] );
+}
+
+
+/*  TKOF backwards:  ( tkof * divisor ) / ( mass (or velocity) * diameter ) */
+KERNEL_ATTR static void KERNEL_NAME( ISA, tkof_inv )( double div,
+        const double *other, const double *diameter, const double *ko,
+        double *out, size_t n )
+{
+    VEC vd = VSET1( div );
+    size_t i = 0;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC p = VMUL( VLOAD( other + i ), VLOAD( diameter + i ));
+        VSTORE( out + i, VDIV( VMUL( VLOAD( ko + i ), vd ), p ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = tkof_inv_div( div, other[i], diameter[i], ko[i] );
+}
+
+
+/*  The set, for the dispatch table */
+static const struct kernel_set KERNEL_NAME( ISA, kernels ) = {
+    KERNEL_NAME_STR,
+    { KERNEL_NAME( ISA, energy_imp ), KERNEL_NAME( ISA, energy_si ) },
+    { KERNEL_NAME( ISA, mass_imp ), KERNEL_NAME( ISA, mass_si ) },
+    { KERNEL_NAME( ISA, velocity_imp ), KERNEL_NAME( ISA, velocity_si ) },
+    { KERNEL_NAME( ISA, tkof ), KERNEL_NAME( ISA, tkof ) },
+    { KERNEL_NAME( ISA, tkof_inv ), KERNEL_NAME( ISA, tkof_inv ) }
+};
+
+#undef KERNEL_NAME
+#undef KERNEL_NAME2
@@ -0,0 +1,281 @@
+/*******************************************************************************
+ *  kernel_fast.h   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                       |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The fast kernels:  the same formulas as kernel_body.h, reworked so that
+ *  no vector ever divides or takes a square root.  Dividing by K becomes
+ *  multiplying by 1/K, worked out once per call; 1/x and 1/sqrt(x) start
+ *  from the CPU's estimate and are refined with Newton's method (in FMAs,
+ *  where there are any).  That makes them a few bits off the reference,
+ *  which is why a plan only uses one once it's been checked against the
+ *  reference (see muzz_fast_check() in kernels.c).
+ *
+ *  kernels.c includes this once per instruction set, after kernel_body.h,
+ *  with these defined as well as its macros:
+ *
+ *      KERNEL_FAST_ATTR    Function attributes for these (e.g. FMA)
+ *      VFMA(a,b,c)         a * b + c
+ *      VFNMA(a,b,c)        c - a * b
+ *      VRCP_EST(x)         Rough 1/x
+ *      VRSQRT_EST(x)       Rough 1/sqrt(x)
+ *      VIN_RANGE(x)        Whether every lane is from FAST_MIN to FAST_MAX
+ *      FAST_STEPS          Newton steps to get the estimates to full double
+ *
+ *  The estimates only hold up for numbers that are neither tiny nor huge
+ *  (and AVX2's go through floats), so a vector with anything outside that
+ *  range goes through the reference formulas instead, as does the tail.
+ *
+ ******************************************************************************/
+
+#define KERNEL_NAME2( a, b )    a##_##b
+#define KERNEL_NAME( a, b )     KERNEL_NAME2( a, b )
+
+
+/*  1/x, refined:  y += y * ( 1 - x * y ) */
+KERNEL_FAST_ATTR static inline VEC KERNEL_NAME( ISA, fast_rcp )( VEC x )
+{
+    VEC one = VSET1( 1.0 );
+    VEC y = VRCP_EST( x );
+    int s;
+
+    for( s = 0; s < FAST_STEPS; ++s )
+        y = VFMA( y, VFNMA( x, y, one ), y );
+
+    return( y );
+}
+
+
+/*  1/sqrt(x), refined:  y *= 1.5 - ( x / 2 ) * y * y */
+KERNEL_FAST_ATTR static inline VEC KERNEL_NAME( ISA, fast_rsqrt )( VEC x )
+{
+    VEC h = VMUL( x, VSET1( 0.5 ));
+    VEC threeHalves = VSET1( 1.5 );
+    VEC y = VRSQRT_EST( x );
+    int s;
+
+    for( s = 0; s < FAST_STEPS; ++s )
+        y = VMUL( y, VFNMA( VMUL( h, y ), y, threeHalves ));
+
+    return( y );
+}
+
+
+/*  Energy (Imperial):  mass * (velocity*velocity) * (1/K) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_energy_imp )( double k,
+        const double *mass, const double *velocity, const double *unused,
+        double *out, size_t n )
+{
+    VEC rk = VSET1( 1.0 / k );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VSTORE( out + i, VMUL( VMUL( VLOAD( mass + i ), VMUL( v, v )), rk ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = energy_imp( k, mass[i], velocity[i] );
+}
+
+
+/*  Energy (Si):  mass * (velocity*velocity) * (1/2K) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_energy_si )( double k,
+        const double *mass, const double *velocity, const double *unused,
+        double *out, size_t n )
+{
+    VEC rk = VSET1( 0.5 / k );
+    size_t i = 0;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VSTORE( out + i, VMUL( VMUL( VLOAD( mass + i ), VMUL( v, v )), rk ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = energy_si( k, mass[i], velocity[i] );
+}
+
+
+/*  Mass (Imperial):  (energy*K) * 1/(velocity*velocity) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_mass_imp )( double k,
+        const double *velocity, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    size_t i = 0;
+    size_t j;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VEC x = VMUL( v, v );
+
+        if( VIN_RANGE( x ))
+        {
+            VEC ek = VMUL( VLOAD( energy + i ), vk );
+            VSTORE( out + i, VMUL( ek, KERNEL_NAME( ISA, fast_rcp )( x )));
+        }
+        else
+            for( j = i; j < i + WIDTH; ++j )
+                out[j] = mass_imp( k, velocity[j], energy[j] );
+    }
+
+    for( ; i < n; ++i )
+        out[i] = mass_imp( k, velocity[i], energy[i] );
+}
+
+
+/*  Mass (Si):  (energy*2K) * 1/(velocity*velocity) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_mass_si )( double k,
+        const double *velocity, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( 2.0 * k );
+    size_t i = 0;
+    size_t j;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC v = VLOAD( velocity + i );
+        VEC x = VMUL( v, v );
+
+        if( VIN_RANGE( x ))
+        {
+            VEC ek = VMUL( VLOAD( energy + i ), vk );
+            VSTORE( out + i, VMUL( ek, KERNEL_NAME( ISA, fast_rcp )( x )));
+        }
+        else
+            for( j = i; j < i + WIDTH; ++j )
+                out[j] = mass_si( k, velocity[j], energy[j] );
+    }
+
+    for( ; i < n; ++i )
+        out[i] = mass_si( k, velocity[i], energy[i] );
+}
+
+
+/*  Velocity (Imperial):  (energy*K) * 1/sqrt( energy*K * mass ) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_velocity_imp )( double k,
+        const double *mass, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( k );
+    size_t i = 0;
+    size_t j;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC ek = VMUL( VLOAD( energy + i ), vk );
+        VEC x = VMUL( ek, VLOAD( mass + i ));
+
+        /*  ek has to be positive too (so the mass is):  both negative
+         *  make x positive, but ek * 1/sqrt(x) then comes out negative */
+        if( VIN_RANGE( x ) && VIN_RANGE( ek ))
+            VSTORE( out + i, VMUL( ek, KERNEL_NAME( ISA, fast_rsqrt )( x )));
+        else
+            for( j = i; j < i + WIDTH; ++j )
+                out[j] = velocity_imp( k, mass[j], energy[j] );
+    }
+
+    for( ; i < n; ++i )
+        out[i] = velocity_imp( k, mass[i], energy[i] );
+}
+
+
+/*  Velocity (Si):  (energy*2K) * 1/sqrt( energy*2K * mass ) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_velocity_si )( double k,
+        const double *mass, const double *energy, const double *unused,
+        double *out, size_t n )
+{
+    VEC vk = VSET1( 2.0 * k );
+    size_t i = 0;
+    size_t j;
+    (void)unused;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC ek = VMUL( VLOAD( energy + i ), vk );
+        VEC x = VMUL( ek, VLOAD( mass + i ));
+
+        /*  ek has to be positive too (so the mass is):  both negative
+         *  make x positive, but ek * 1/sqrt(x) then comes out negative */
+        if( VIN_RANGE( x ) && VIN_RANGE( ek ))
+            VSTORE( out + i, VMUL( ek, KERNEL_NAME( ISA, fast_rsqrt )( x )));
+        else
+            for( j = i; j < i + WIDTH; ++j )
+                out[j] = velocity_si( k, mass[j], energy[j] );
+    }
+
+    for( ; i < n; ++i )
+        out[i] = velocity_si( k, mass[i], energy[i] );
+}
+
+
+/*  TKOF:  ( mass * velocity * diameter ) * (1/divisor) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_tkof )( double div,
+        const double *mass, const double *velocity, const double *diameter,
+        double *out, size_t n )
+{
+    VEC rd = VSET1( 1.0 / div );
+    size_t i = 0;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC p = VMUL( VLOAD( mass + i ), VLOAD( velocity + i ));
+        VSTORE( out + i, VMUL( VMUL( p, VLOAD( diameter + i )), rd ));
+    }
+
+    for( ; i < n; ++i )
+        out[i] = tkof_div( div, mass[i], velocity[i], diameter[i] );
+}
+
+
+/*  TKOF backwards:  ( tkof * divisor ) * 1/( mass (or velocity) * diameter ) */
+KERNEL_FAST_ATTR static void KERNEL_NAME( ISA, fast_tkof_inv )( double div,
+        const double *other, const double *diameter, const double *ko,
+        double *out, size_t n )
+{
+    VEC vd = VSET1( div );
+    size_t i = 0;
+    size_t j;
+
+    for( ; i + WIDTH <= n; i += WIDTH )
+    {
+        VEC x = VMUL( VLOAD( other + i ), VLOAD( diameter + i ));
+
+        if( VIN_RANGE( x ))
+        {
+            VEC kd = VMUL( VLOAD( ko + i ), vd );
+            VSTORE( out + i, VMUL( kd, KERNEL_NAME( ISA, fast_rcp )( x )));
+        }
+        else
+            for( j = i; j < i + WIDTH; ++j )
+                out[j] = tkof_inv_div( div, other[j], diameter[j], ko[j] );
+    }
+
+    for( ; i < n; ++i )
+        out[i] = tkof_inv_div( div, other[i], diameter[i], ko[i] );
+}
+
+
+/*  The set, for the dispatch table */
+static const struct kernel_set KERNEL_NAME( ISA, fast_kernels ) = {
+    KERNEL_NAME_STR "-fast",
+    { KERNEL_NAME( ISA, fast_energy_imp ), KERNEL_NAME( ISA, fast_energy_si ) },
+    { KERNEL_NAME( ISA, fast_mass_imp ), KERNEL_NAME( ISA, fast_mass_si ) },
+    { KERNEL_NAME( ISA, fast_velocity_imp ),
+        KERNEL_NAME( ISA, fast_velocity_si ) },
+    { KERNEL_NAME( ISA, fast_tkof ), KERNEL_NAME( ISA, fast_tkof ) },
+    { KERNEL_NAME( ISA, fast_tkof_inv ), KERNEL_NAME( ISA, fast_tkof_inv ) }
+};
+
+#undef KERNEL_NAME
+#undef KERNEL_NAME2
@@ -0,0 +1,799 @@
+/*******************************************************************************
+ *  kernels.c   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Array versions of the formulas, for when there's a whole column of masses
+ *  and velocities (or whatever) to get through at once.  The same kernels are
+ *  built for plain C, AVX2 and AVX-512 (x86-64) or NEON (ARM64), and whichever
+ *  is best for the CPU we're running on gets picked when the library loads.
+ *  Set MUZZ_ISA (scalar, avx2, avx512, neon) to force a particular one.
+ *
+ *  Each instruction set also has a set of fast kernels (kernel_fast.h), which
+ *  a plan only uses if the context asks for them and they pass the check in
+ *  muzz_fast_check():  run side by side with the reference over a sample
+ *  of realistic shots with the context's own units and constant, they have
+ *  to stay within MUZZ_FAST_MAX_ERROR, well below anything '-p' can show.
+ *
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include "muzz.h"
+#include "formulas.h"
+
+#if defined( __x86_64__ ) && defined( __GNUC__ )
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined( __aarch64__ )
+#define HAVE_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+
+
+/*  One instruction set's worth of kernels, indexed by [si] */
+struct kernel_set {
+    const char *name;
+    muzz_kernel_fn energy[ 2 ];
+    muzz_kernel_fn mass[ 2 ];
+    muzz_kernel_fn velocity[ 2 ];
+    muzz_kernel_fn tkof[ 2 ];
+    muzz_kernel_fn tkofInv[ 2 ];    //  Mass or velocity, for a TKOF
+};
+
+
+/*  Where the estimates in the fast kernels can be trusted (see VIN_RANGE) */
+#define FAST_MIN 0x1p-100
+#define FAST_MAX 0x1p100
+
+/*  Shots the fast kernels are checked over when a plan is made */
+#define FAST_SAMPLES 4096
+
+/*  Shots checked at a time */
+#define CHECK_CHUNK 512
+
+
+
+/*  ---------------------------  Plain C  ------------------------------- */
+#define ISA             scalar
+#define KERNEL_NAME_STR "scalar"
+#define KERNEL_ATTR
+#define VEC             double
+#define WIDTH           1
+#define VLOAD( p )      ( *(p) )
+#define VSTORE( p, v )  ( *(p) = (v) )
+#define VSET1( x )      ( x )
+#define VMUL( a, b )    ( (a) * (b) )
+#define VDIV( a, b )    ( (a) / (b) )
+#define VSQRT( a )      sqrt( a )
+#include "kernel_body.h"
+#define KERNEL_FAST_ATTR
+#define VFMA( a, b, c ) ( (a) * (b) + (c) )
+#define VFNMA( a, b, c )    ( (c) - (a) * (b) )
+#define VRCP_EST( x )   ( 1.0 / (x) )
+#define VRSQRT_EST( x ) ( 1.0 / sqrt( x ))
+#define VIN_RANGE( x )  ( (x) >= FAST_MIN && (x) <= FAST_MAX )
+#define FAST_STEPS      0
+#include "kernel_fast.h"
+#undef ISA
+#undef KERNEL_NAME_STR
+#undef KERNEL_ATTR
+#undef VEC
+#undef WIDTH
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VMUL
+#undef VDIV
+#undef VSQRT
+#undef KERNEL_FAST_ATTR
+#undef VFMA
+#undef VFNMA
+#undef VRCP_EST
+#undef VRSQRT_EST
+#undef VIN_RANGE
+#undef FAST_STEPS
+
+
+
+#ifdef HAVE_X86_KERNELS
+
+/*  Whether every lane of a vector is from FAST_MIN to FAST_MAX */
+__attribute__(( target( "avx2" )))
+static inline int avx2_in_range( __m256d x )
+{
+    __m256d ok = _mm256_and_pd(
+            _mm256_cmp_pd( x, _mm256_set1_pd( FAST_MIN ), _CMP_GE_OQ ),
+            _mm256_cmp_pd( x, _mm256_set1_pd( FAST_MAX ), _CMP_LE_OQ ));
+
+    return( _mm256_movemask_pd( ok ) == 0xf );
+}
+
+__attribute__(( target( "avx512f" )))
+static inline int avx512_in_range( __m512d x )
+{
+    return( ( _mm512_cmp_pd_mask( x, _mm512_set1_pd( FAST_MIN ), _CMP_GE_OQ )
+            & _mm512_cmp_pd_mask( x, _mm512_set1_pd( FAST_MAX ), _CMP_LE_OQ ))
+            == 0xff );
+}
+
+/*  -----------------------------  AVX2  -------------------------------- */
+#define ISA             avx2
+#define KERNEL_NAME_STR "avx2"
+#define KERNEL_ATTR     __attribute__(( target( "avx2" )))
+#define VEC             __m256d
+#define WIDTH           4
+#define VLOAD( p )      _mm256_loadu_pd( p )
+#define VSTORE( p, v )  _mm256_storeu_pd( p, v )
+#define VSET1( x )      _mm256_set1_pd( x )
+#define VMUL( a, b )    _mm256_mul_pd( a, b )
+#define VDIV( a, b )    _mm256_div_pd( a, b )
+#define VSQRT( a )      _mm256_sqrt_pd( a )
+#include "kernel_body.h"
+#define KERNEL_FAST_ATTR    __attribute__(( target( "avx2,fma" )))
+#define VFMA( a, b, c ) _mm256_fmadd_pd( a, b, c )
+#define VFNMA( a, b, c )    _mm256_fnmadd_pd( a, b, c )
+#define VRCP_EST( x )   _mm256_cvtps_pd( _mm_rcp_ps( _mm256_cvtpd_ps( x )))
+#define VRSQRT_EST( x ) _mm256_cvtps_pd( _mm_rsqrt_ps( _mm256_cvtpd_ps( x )))
+#define VIN_RANGE( x )  avx2_in_range( x )
+#define FAST_STEPS      3
+#include "kernel_fast.h"
+#undef ISA
+#undef KERNEL_NAME_STR
+#undef KERNEL_ATTR
+#undef VEC
+#undef WIDTH
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VMUL
+#undef VDIV
+#undef VSQRT
+#undef KERNEL_FAST_ATTR
+#undef VFMA
+#undef VFNMA
+#undef VRCP_EST
+#undef VRSQRT_EST
+#undef VIN_RANGE
+#undef FAST_STEPS
+
+
+/*  ----------------------------  AVX-512  ------------------------------ */
+#define ISA             avx512
+#define KERNEL_NAME_STR "avx512"
+#define KERNEL_ATTR     __attribute__(( target( "avx512f" )))
+#define VEC             __m512d
+#define WIDTH           8
+#define VLOAD( p )      _mm512_loadu_pd( p )
+#define VSTORE( p, v )  _mm512_storeu_pd( p, v )
+#define VSET1( x )      _mm512_set1_pd( x )
+#define VMUL( a, b )    _mm512_mul_pd( a, b )
+#define VDIV( a, b )    _mm512_div_pd( a, b )
+#define VSQRT( a )      _mm512_sqrt_pd( a )
+#include "kernel_body.h"
+#define KERNEL_FAST_ATTR    __attribute__(( target( "avx512f" )))
+#define VFMA( a, b, c ) _mm512_fmadd_pd( a, b, c )
+#define VFNMA( a, b, c )    _mm512_fnmadd_pd( a, b, c )
+#define VRCP_EST( x )   _mm512_rcp14_pd( x )
+#define VRSQRT_EST( x ) _mm512_rsqrt14_pd( x )
+#define VIN_RANGE( x )  avx512_in_range( x )
+#define FAST_STEPS      2
+#include "kernel_fast.h"
+#undef ISA
+#undef KERNEL_NAME_STR
+#undef KERNEL_ATTR
+#undef VEC
+#undef WIDTH
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VMUL
+#undef VDIV
+#undef VSQRT
+#undef KERNEL_FAST_ATTR
+#undef VFMA
+#undef VFNMA
+#undef VRCP_EST
+#undef VRSQRT_EST
+#undef VIN_RANGE
+#undef FAST_STEPS
+
+#endif  //  HAVE_X86_KERNELS
+
+
+
+#ifdef HAVE_NEON_KERNELS
+
+/*  Whether both lanes of a vector are from FAST_MIN to FAST_MAX */
+static inline int neon_in_range( float64x2_t x )
+{
+    uint64x2_t ok = vandq_u64( vcgeq_f64( x, vdupq_n_f64( FAST_MIN )),
+            vcleq_f64( x, vdupq_n_f64( FAST_MAX )));
+
+    return( ( vgetq_lane_u64( ok, 0 ) & vgetq_lane_u64( ok, 1 )) != 0 );
+}
+
+/*  -----------------------------  NEON  -------------------------------- */
+#define ISA             neon
+#define KERNEL_NAME_STR "neon"
+#define KERNEL_ATTR
+#define VEC             float64x2_t
+#define WIDTH           2
+#define VLOAD( p )      vld1q_f64( p )
+#define VSTORE( p, v )  vst1q_f64( p, v )
+#define VSET1( x )      vdupq_n_f64( x )
+#define VMUL( a, b )    vmulq_f64( a, b )
+#define VDIV( a, b )    vdivq_f64( a, b )
+#define VSQRT( a )      vsqrtq_f64( a )
+#include "kernel_body.h"
+#define KERNEL_FAST_ATTR
+#define VFMA( a, b, c ) vfmaq_f64( c, a, b )
+#define VFNMA( a, b, c )    vfmsq_f64( c, a, b )
+#define VRCP_EST( x )   vrecpeq_f64( x )
+#define VRSQRT_EST( x ) vrsqrteq_f64( x )
+#define VIN_RANGE( x )  neon_in_range( x )
+#define FAST_STEPS      3
+#include "kernel_fast.h"
+#undef ISA
+#undef KERNEL_NAME_STR
+#undef KERNEL_ATTR
+#undef VEC
+#undef WIDTH
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VMUL
+#undef VDIV
+#undef VSQRT
+#undef KERNEL_FAST_ATTR
+#undef VFMA
+#undef VFNMA
+#undef VRCP_EST
+#undef VRSQRT_EST
+#undef VIN_RANGE
+#undef FAST_STEPS
+
+#endif  //  HAVE_NEON_KERNELS
+
+
+
+/*  Every set this build has, best first */
+static const struct kernel_set *allKernels[] = {
+#ifdef HAVE_X86_KERNELS
+    &avx512_kernels,
+    &avx2_kernels,
+#endif
+#ifdef HAVE_NEON_KERNELS
+    &neon_kernels,
+#endif
+    &scalar_kernels
+};
+
+/*  Their fast kernels, in the same order */
+static const struct kernel_set *allFast[] = {
+#ifdef HAVE_X86_KERNELS
+    &avx512_fast_kernels,
+    &avx2_fast_kernels,
+#endif
+#ifdef HAVE_NEON_KERNELS
+    &neon_fast_kernels,
+#endif
+    &scalar_fast_kernels
+};
+
+#define TOTAL_KERNEL_SETS ( sizeof( allKernels ) / sizeof( allKernels[0] ))
+
+
+/*  The sets we're using; picked once, when the library is loaded */
+static const struct kernel_set *kernels = &scalar_kernels;
+static const struct kernel_set *fastKernels = &scalar_fast_kernels;
+
+
+/*
+ *  What muzz_fast_check() said about the fast kernels, by [solve][si]:  it
+ *  only depends on those, the constant and the set picked above, so each is
+ *  worked out the first time a plan wants it, and again only if K changes.
+ *  The lock is a spinlock so that the library doesn't need pthreads; it's
+ *  only ever held for a check.
+ */
+typedef struct fast_verdict {
+    int known;
+    int allowed;
+    double k;               //  The constant it was checked with
+} fast_verdict;
+
+static fast_verdict fastVerdicts[ MUZZ_SOLVE_TKOF_VELOCITY + 1 ][ 2 ];
+static atomic_flag verdictLock = ATOMIC_FLAG_INIT;
+
+
+
+/*==============================================================================
+                                 CPU SUPPORTS
+--------------------------------------------------------------------------------
+*   Returns 1 if the CPU we're on can run the given set of kernels.
+*/
+static int cpu_supports( const struct kernel_set *set )
+{
+#ifdef HAVE_X86_KERNELS
+    if( set == &avx512_kernels )
+        return( __builtin_cpu_supports( "avx512f" ) );
+
+    if( set == &avx2_kernels )
+        return( __builtin_cpu_supports( "avx2" ) );
+
+    if( set == &avx512_fast_kernels )
+        return( __builtin_cpu_supports( "avx512f" ) );
+
+    if( set == &avx2_fast_kernels )
+        return( __builtin_cpu_supports( "avx2" )
+                && __builtin_cpu_supports( "fma" ) );
+#endif
+
+    /*  Plain C, or NEON, which every ARM64 CPU has */
+    (void)set;
+    return( 1 );
+}
+
+
+
+/*==============================================================================
+                                 PICK KERNELS
+--------------------------------------------------------------------------------
+*   Runs when the library is loaded.  Picks the best set of kernels the CPU
+*   supports, unless MUZZ_ISA says otherwise (and the CPU can run that one),
+*   and its fast kernels, if the CPU can run those too.
+*/
+__attribute__(( constructor ))
+static void pick_kernels( void )
+{
+    const char *wanted = getenv( "MUZZ_ISA" );
+    size_t i;
+
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+#endif
+
+    for( i = 0; i < TOTAL_KERNEL_SETS; ++i )
+    {
+        if( wanted != NULL && strcmp( wanted, allKernels[i]->name ) != 0 )
+            continue;
+
+        if( cpu_supports( allKernels[i] ))
+        {
+            kernels = allKernels[i];
+            if( cpu_supports( allFast[i] ))
+                fastKernels = allFast[i];
+            return;
+        }
+    }
+}
+
+
+
+/*==============================================================================
+                                   KERNEL ISA
+--------------------------------------------------------------------------------
+*   Returns the name of the instruction set the array functions are using.
+*/
+const char *muzz_kernel_isa( void )
+{
+    return( kernels->name );
+}
+
+
+
+/*==============================================================================
+                                 GET ENERGY (N)
+--------------------------------------------------------------------------------
+*   Array version of muzz_get_energy().
+*
+*   Params
+*       muzz_ctx *ctx       |   Units and constant
+*       double *mass        |   Masses of the projectiles
+*       double *velocity    |   Velocities of the projectiles
+*       double *energy      |   Where to put the energies
+*       size_t n            |   How many of each
+*/
+void muzz_get_energy_n( const muzz_ctx *ctx, const double *mass,
+        const double *velocity, double *energy, size_t n )
+{
+    kernels->energy[ ctx->si != 0 ]( ctx->k, mass, velocity, NULL, energy, n );
+}
+
+
+
+/*==============================================================================
+                                  GET MASS (N)
+--------------------------------------------------------------------------------
+*   Array version of muzz_get_mass().
+*
+*   Params
+*       muzz_ctx *ctx       |   Units and constant
+*       double *velocity    |   Velocities of the projectiles
+*       double *energy      |   Energies of the projectiles
+*       double *mass        |   Where to put the masses
+*       size_t n            |   How many of each
+*/
+void muzz_get_mass_n( const muzz_ctx *ctx, const double *velocity,
+        const double *energy, double *mass, size_t n )
+{
+    kernels->mass[ ctx->si != 0 ]( ctx->k, velocity, energy, NULL, mass, n );
+}
+
+
+
+/*==============================================================================
+                                GET VELOCITY (N)
+--------------------------------------------------------------------------------
+*   Array version of muzz_get_velocity().
+*
+*   Params
+*       muzz_ctx *ctx       |   Units and constant
+*       double *mass        |   Masses of the projectiles
+*       double *energy      |   Energies of the projectiles
+*       double *velocity    |   Where to put the velocities
+*       size_t n            |   How many of each
+*/
+void muzz_get_velocity_n( const muzz_ctx *ctx, const double *mass,
+        const double *energy, double *velocity, size_t n )
+{
+    kernels->velocity[ ctx->si != 0 ]( ctx->k, mass, energy, NULL,
+            velocity, n );
+}
+
+
+
+/*==============================================================================
+                                    TKOF (N)
+--------------------------------------------------------------------------------
+*   Array version of muzz_tkof().
+*
+*   Params
+*       muzz_ctx *ctx       |   Units
+*       double *mass        |   Masses of the projectiles
+*       double *velocity    |   Velocities of the projectiles
+*       double *diameter    |   Diameters of the projectiles
+*       double *ko          |   Where to put the knockout numbers
+*       size_t n            |   How many of each
+*/
+void muzz_tkof_n( const muzz_ctx *ctx, const double *mass,
+        const double *velocity, const double *diameter, double *ko, size_t n )
+{
+    double div = ( ctx->si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL );
+
+    kernels->tkof[ ctx->si != 0 ]( div, mass, velocity, diameter, ko, n );
+}
+
+
+
+/*==============================================================================
+                                 TKOF MASS (N)
+--------------------------------------------------------------------------------
+*   Array version of muzz_tkof_mass().
+*
+*   Params
+*       muzz_ctx *ctx       |   Units
+*       double *velocity    |   Velocities of the projectiles
+*       double *diameter    |   Diameters of the projectiles
+*       double *ko          |   Knockout numbers wanted
+*       double *mass        |   Where to put the masses
+*       size_t n            |   How many of each
+*/
+void muzz_tkof_mass_n( const muzz_ctx *ctx, const double *velocity,
+        const double *diameter, const double *ko, double *mass, size_t n )
+{
+    double div = ( ctx->si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL );
+
+    kernels->tkofInv[ ctx->si != 0 ]( div, velocity, diameter, ko, mass, n );
+}
+
+
+
+/*==============================================================================
+                               TKOF VELOCITY (N)
+--------------------------------------------------------------------------------
+*   Array version of muzz_tkof_velocity().
+*
+*   Params
+*       muzz_ctx *ctx       |   Units
+*       double *mass        |   Masses of the projectiles
+*       double *diameter    |   Diameters of the projectiles
+*       double *ko          |   Knockout numbers wanted
+*       double *velocity    |   Where to put the velocities
+*       size_t n            |   How many of each
+*/
+void muzz_tkof_velocity_n( const muzz_ctx *ctx, const double *mass,
+        const double *diameter, const double *ko, double *velocity, size_t n )
+{
+    double div = ( ctx->si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL );
+
+    kernels->tkofInv[ ctx->si != 0 ]( div, mass, diameter, ko, velocity, n );
+}
+
+
+
+/*==============================================================================
+                                   PLAN PICK
+--------------------------------------------------------------------------------
+*   Fills in a plan's kernel, number and name for the context from one set of
+*   kernels.
+*
+*   Params
+*       muzz_plan *plan         |   The plan to fill in
+*       kernel_set *set         |   Kernels to pick from
+*       muzz_ctx *ctx           |   A resolved context
+*/
+static void plan_pick( muzz_plan *plan, const struct kernel_set *set,
+        const muzz_ctx *ctx )
+{
+    int si = ( ctx->si != 0 );
+
+    plan->k = ctx->k;
+    plan->isa = set->name;
+
+    switch( ctx->solve )
+    {
+        case MUZZ_SOLVE_MASS:
+            plan->kernel = set->mass[ si ];
+            plan->name = ( si ? "mass-si" : "mass-imperial" );
+            break;
+
+        case MUZZ_SOLVE_VELOCITY:
+            plan->kernel = set->velocity[ si ];
+            plan->name = ( si ? "velocity-si" : "velocity-imperial" );
+            break;
+
+        case MUZZ_SOLVE_TKOF:
+            plan->kernel = set->tkof[ si ];
+            plan->k = ( si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL );
+            plan->name = ( si ? "tkof-si" : "tkof-imperial" );
+            break;
+
+        case MUZZ_SOLVE_TKOF_MASS:
+            plan->kernel = set->tkofInv[ si ];
+            plan->k = ( si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL );
+            plan->name = ( si ? "tkof-mass-si" : "tkof-mass-imperial" );
+            break;
+
+        case MUZZ_SOLVE_TKOF_VELOCITY:
+            plan->kernel = set->tkofInv[ si ];
+            plan->k = ( si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL );
+            plan->name = ( si ? "tkof-velocity-si" : "tkof-velocity-imperial" );
+            break;
+
+        default:
+            plan->kernel = set->energy[ si ];
+            plan->name = ( si ? "energy-si" : "energy-imperial" );
+            break;
+    }
+}
+
+
+
+/*==============================================================================
+                                  FAST ALLOWED
+--------------------------------------------------------------------------------
+*   Whether the fast kernels passed muzz_fast_check() for this context,
+*   from fastVerdicts if they've been checked with its constant already.
+*/
+static int fast_allowed( const muzz_ctx *ctx )
+{
+    muzz_accuracy acc;
+    fast_verdict *v;
+    int allowed;
+
+    if( ctx->solve < 0 || ctx->solve > MUZZ_SOLVE_TKOF_VELOCITY )
+        return( muzz_fast_check( ctx, FAST_SAMPLES, &acc ));
+
+    v = &fastVerdicts[ ctx->solve ][ ctx->si != 0 ];
+
+    while( atomic_flag_test_and_set_explicit( &verdictLock,
+                memory_order_acquire ))
+        ;
+
+    if( ! v->known || memcmp( &v->k, &ctx->k, sizeof( v->k )) != 0 )
+    {
+        v->allowed = muzz_fast_check( ctx, FAST_SAMPLES, &acc );
+        v->k = ctx->k;
+        v->known = 1;
+    }
+    allowed = v->allowed;
+
+    atomic_flag_clear_explicit( &verdictLock, memory_order_release );
+    return( allowed );
+}
+
+
+
+/*==============================================================================
+                                   PLAN INIT
+--------------------------------------------------------------------------------
+*   Settles, once, everything a context says about how to calculate:  which
+*   formula, which units, the constant, and which instruction set.  The plan
+*   ends up holding a single kernel and the number to hand it, so running it
+*   over a chunk of records doesn't have to decide anything.  If the context
+*   asks for the fast kernels, it gets them only if they pass the check.
+*
+*   Params
+*       muzz_plan *plan |   The plan to fill in
+*       muzz_ctx *ctx   |   A resolved context
+*/
+void muzz_plan_init( muzz_plan *plan, const muzz_ctx *ctx )
+{
+    if( ctx->fast && fast_allowed( ctx ))
+        plan_pick( plan, fastKernels, ctx );
+    else
+        plan_pick( plan, kernels, ctx );
+}
+
+
+
+/*==============================================================================
+                                  CHECK RANDOM
+--------------------------------------------------------------------------------
+*   SplitMix64, scaled to somewhere from lo to hi, spread evenly over the
+*   logarithms, so that a 10 grain pellet gets as much of a look as a 500
+*   grain slug.  Always the same numbers, so the check always says the same.
+*
+*   Params
+*       uint64_t *state     |   Generator state
+*       double lo, hi       |   Range, both positive
+*/
+static double check_random( uint64_t *state, double lo, double hi )
+{
+    uint64_t z = ( *state += 0x9e3779b97f4a7c15ULL );
+    double u;
+
+    z = ( z ^ ( z >> 30 )) * 0xbf58476d1ce4e5b9ULL;
+    z = ( z ^ ( z >> 27 )) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    u = (double)( z >> 11 ) * 0x1p-53;
+
+    return( lo * pow( hi / lo, u ));
+}
+
+
+
+/*==============================================================================
+                                   FAST CHECK
+--------------------------------------------------------------------------------
+*   Runs the fast kernel for the context's formula and units next to the
+*   reference over a sample of realistic shots (the ones muzz.h lists),
+*   corners included, and reports how far apart they get.  The corners go
+*   round again with the mass negative, which the reference turns into a
+*   negative energy (and a positive velocity from both), so a fast kernel
+*   that gets a sign wrong doesn't pass.
+*   Returns whether that's close enough to use them (acc->allowed).
+*
+*   Params
+*       muzz_ctx *ctx       |   A resolved context
+*       size_t samples      |   How many shots to check
+*       muzz_accuracy *acc  |   Where to put the results
+*/
+int muzz_fast_check( const muzz_ctx *ctx, size_t samples, muzz_accuracy *acc )
+{
+    double mass[ CHECK_CHUNK ], velocity[ CHECK_CHUNK ];
+    double other[ CHECK_CHUNK ], diameter[ CHECK_CHUNK ];
+    double want[ CHECK_CHUNK ], got[ CHECK_CHUNK ];
+    double lo[ 3 ], hi[ 3 ];
+    const double *a = mass, *b = velocity, *c = diameter;
+    uint64_t state = 0x6d757a7aULL;
+    muzz_plan ref, fast;
+    size_t done, n, i;
+    int si = ( ctx->si != 0 );
+
+    plan_pick( &ref, kernels, ctx );
+    plan_pick( &fast, fastKernels, ctx );
+
+    acc->name = ref.name;
+    acc->isa = fast.isa;
+    acc->samples = 0;
+    acc->maxUlp = acc->maxRel = acc->maxAbs = 0;
+
+    /*  Mass, velocity and diameter, for the units we're in */
+    lo[0] = ( si ? 0.065 : 1.0 );
+    hi[0] = ( si ? 65.0 : 1000.0 );
+    lo[1] = ( si ? 30.0 : 100.0 );
+    hi[1] = ( si ? 1500.0 : 5000.0 );
+    lo[2] = ( si ? 2.5 : 0.1 );
+    hi[2] = ( si ? 25.0 : 1.0 );
+
+    /*  The inputs, in command line order; other is the energy or TKOF */
+    if( ctx->solve == MUZZ_SOLVE_MASS )
+    {
+        a = velocity;
+        b = other;
+    }
+    else if( ctx->solve == MUZZ_SOLVE_VELOCITY )
+        b = other;
+    else if( ctx->solve == MUZZ_SOLVE_TKOF_MASS
+            || ctx->solve == MUZZ_SOLVE_TKOF_VELOCITY )
+    {
+        a = ( ctx->solve == MUZZ_SOLVE_TKOF_MASS ? velocity : mass );
+        b = diameter;
+        c = other;
+    }
+
+    for( done = 0; done < samples; done += n )
+    {
+        n = samples - done;
+        if( n > CHECK_CHUNK )
+            n = CHECK_CHUNK;
+
+        for( i = 0; i < n; ++i )
+        {
+            mass[i] = check_random( &state, lo[0], hi[0] );
+            velocity[i] = check_random( &state, lo[1], hi[1] );
+            diameter[i] = check_random( &state, lo[2], hi[2] );
+        }
+
+        /*  The corners of the domain go in first, then again with a
+         *  negative mass */
+        for( i = 0; done == 0 && i < 16 && i < n; ++i )
+        {
+            mass[i] = ( i & 1 ? hi[0] : lo[0] ) * ( i & 8 ? -1 : 1 );
+            velocity[i] = ( i & 2 ? hi[1] : lo[1] );
+            diameter[i] = ( i & 4 ? hi[2] : lo[2] );
+        }
+
+        /*  Energies (or knockout numbers) for the shots, as an input */
+        if( muzz_knockout( ctx ))
+            kernels->tkof[ si ]( ( si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL ),
+                    mass, velocity, diameter, other, n );
+        else
+            kernels->energy[ si ]( ctx->k, mass, velocity, NULL, other, n );
+
+        muzz_plan_run( &ref, a, b, c, want, n );
+        muzz_plan_run( &fast, a, b, c, got, n );
+
+        for( i = 0; i < n; ++i )
+        {
+            double d = fabs( got[i] - want[i] );
+            double w = fabs( want[i] );
+
+            if( isnan( d ))
+                d = INFINITY;
+
+            if( d > acc->maxAbs )
+                acc->maxAbs = d;
+
+            if( w > 0 && d / w > acc->maxRel )
+                acc->maxRel = d / w;
+
+            if( w > 0 && d / ( nextafter( w, INFINITY ) - w ) > acc->maxUlp )
+                acc->maxUlp = d / ( nextafter( w, INFINITY ) - w );
+        }
+
+        acc->samples += n;
+    }
+
+    acc->allowed = ( acc->maxAbs < MUZZ_FAST_MAX_ERROR );
+
+    return( acc->allowed );
+}
+
+
+
+/*==============================================================================
+                                    PLAN RUN
+--------------------------------------------------------------------------------
+*   Runs a plan over n records.  The input columns are in the order the numbers
+*   are given on the command line; the third is only read for TKOF.
+*
+*   Params
+*       muzz_plan *plan |   The plan
+*       double *a,*b,*c |   Input columns
+*       double *out     |   Where to put the results
+*       size_t n        |   How many records
+*/
+void muzz_plan_run( const muzz_plan *plan, const double *a, const double *b,
+        const double *c, double *out, size_t n )
+{
+    plan->kernel( plan->k, a, b, c, out, n );
+}
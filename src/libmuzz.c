@@ -0,0 +1,414 @@
+/*******************************************************************************
+ *  libmuzz.c   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The calculations themselves:  muzzle energy, mass and velocity, and the
+ *  Taylor Knockout Formula.  Nothing in here keeps any state of its own;
+ *  everything comes from the muzz_ctx handed in, so it's safe to call from as
+ *  many threads as you like.
+ *
+ ******************************************************************************/
+#include <math.h>   //  Make sure to link with -lm
+
+#include "muzz.h"
+#include "formulas.h"
+
+
+/*
+ *  Note that I'm not including the Si gravity accleration constant because
+ *  the constant is used to calculate a number by which we divide other numbers.
+ *  For imperial, K = ( 2 * (constant) * 7000 ), while for Si, K = 1000.
+ *
+ *  Also, for Imperial calculations we'll by default set K to 450240, which is
+ *  the standard number used when not calculating with the gravity constant.
+ *  It's very close to the result given when doing so, though I don't know
+ *  where they get it precisely.
+ */
+
+
+
+/*==============================================================================
+                                    CTX INIT
+--------------------------------------------------------------------------------
+*   Sets a context to the program's defaults:  Imperial units, verbose output,
+*   rounded numbers, solving for energy with the industry standard constant.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context to set up
+*/
+void muzz_ctx_init( muzz_ctx *ctx )
+{
+    ctx->si = 0;
+    ctx->verbose = 1;
+    ctx->precise = 0;
+    ctx->fast = 0;
+    ctx->solve = MUZZ_SOLVE_ENERGY;
+    ctx->kMode = MUZZ_K_INDUSTRY;
+    ctx->customK = 0;
+
+    muzz_ctx_resolve( ctx );
+}
+
+
+
+/*==============================================================================
+                                  CTX RESOLVE
+--------------------------------------------------------------------------------
+*   Works out the constant (K) by which we divide (mass*(velocity**2)).
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*/
+void muzz_ctx_resolve( muzz_ctx *ctx )
+{
+    switch( ctx->kMode )
+    {
+        case MUZZ_K_CUSTOM:
+            ctx->k = ctx->customK;
+            return;
+
+        /* Use the industry's version of the grav. accel. constant (32.163) */
+        case MUZZ_K_GAC1:
+            ctx->k = ( 2 * MUZZ_GRAVITY_IMPERIAL_APPROX * 7000 );
+            break;
+
+        /*  Use standard (32.1739) */
+        case MUZZ_K_GAC2:
+            ctx->k = ( 2 * MUZZ_GRAVITY_IMPERIAL * 7000 );
+            break;
+
+        default:    //  Industry standard, don't calculate in-program (default)
+            ctx->k = 450240.0f;
+            break;
+    }
+
+    /*  If the user is using Si units, K = 1000 unless they entered their own */
+    if( ctx->si )
+        ctx->k = 1000.0f;
+}
+
+
+
+/*==============================================================================
+                                   GET ENERGY
+--------------------------------------------------------------------------------
+*   Returns the energy, given the mass and velocity of the projectile.
+*
+*   Params
+*       muzz_ctx *ctx   |   Units and constant
+*       double mass     |   Mass of the projectile
+*       double velocity |   Velocity of the projectile
+*/
+double muzz_get_energy( const muzz_ctx *ctx, double mass, double velocity )
+{
+    /*  Si */
+    if( ctx->si )
+        return( energy_si( ctx->k, mass, velocity ));
+
+    /*  Imperial */
+    else
+        return( energy_imp( ctx->k, mass, velocity ));
+}
+
+
+
+/*==============================================================================
+                                    GET MASS
+--------------------------------------------------------------------------------
+*   Returns the mass of the projectile, given the velocity and muzzle energy.
+*
+*   Params
+*       muzz_ctx *ctx   |   Units and constant
+*       double velocity |   Velocity of the projectile
+*       double energy   |   Energy of the projectile
+*/
+double muzz_get_mass( const muzz_ctx *ctx, double velocity, double energy )
+{
+    /*  Si */
+    if( ctx->si )
+        return( mass_si( ctx->k, velocity, energy ));
+
+    /*  Imperial */
+    else
+        return( mass_imp( ctx->k, velocity, energy ));
+}
+
+
+
+/*==============================================================================
+                                  GET VELOCITY
+--------------------------------------------------------------------------------
+*   Returns the velocity of the projectile, given the mass and muzzle energy.
+*
+*   Params
+*       muzz_ctx *ctx   |   Units and constant
+*       double mass     |   Mass of the projectile
+*       double energy   |   Energy of the projectile
+*/
+double muzz_get_velocity( const muzz_ctx *ctx, double mass, double energy )
+{
+    /*  Si */
+    if( ctx->si )
+        return( velocity_si( ctx->k, mass, energy ));
+
+    /*  Imperial */
+    else
+        return( velocity_imp( ctx->k, mass, energy ));
+}
+
+
+
+/*==============================================================================
+                                      TKOF
+                           (Taylor Knockout Formula)
+--------------------------------------------------------------------------------
+*   Returns the Taylor Knockout number, an alternative to the standard muzzle
+*   energy formula developed by African big-game hunter John Taylor.  Its
+*   purpose is not to be scientific, but to present the hunter with a simple
+*   number that is supposed to correspond well to its real-world performance
+*   according to Taylor's experience.
+*
+*   Params
+*       muzz_ctx *ctx   |   Units
+*       double mass     |   Mass of the projectile
+*       double velocity |   Velocity of projectile
+*       double diameter |   Diameter of the projectile
+*/
+double muzz_tkof( const muzz_ctx *ctx, double mass, double velocity,
+        double diameter )
+{
+    /*  Si */
+    if( ctx->si )
+        return( tkof_div( TKOF_DIV_SI, mass, velocity, diameter ));
+
+    /*  Imperial */
+    else
+        return( tkof_div( TKOF_DIV_IMPERIAL, mass, velocity, diameter ));
+}
+
+
+
+/*==============================================================================
+                                   TKOF MASS
+--------------------------------------------------------------------------------
+*   Returns the mass a projectile needs to reach a Taylor Knockout number,
+*   given its velocity and diameter.
+*
+*   Params
+*       muzz_ctx *ctx   |   Units
+*       double velocity |   Velocity of the projectile
+*       double diameter |   Diameter of the projectile
+*       double tkof     |   The knockout number wanted
+*/
+double muzz_tkof_mass( const muzz_ctx *ctx, double velocity, double diameter,
+        double tkof )
+{
+    return( tkof_inv_div( ( ctx->si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL ),
+                velocity, diameter, tkof ));
+}
+
+
+
+/*==============================================================================
+                                 TKOF VELOCITY
+--------------------------------------------------------------------------------
+*   Returns the velocity a projectile needs to reach a Taylor Knockout
+*   number, given its mass and diameter.
+*
+*   Params
+*       muzz_ctx *ctx   |   Units
+*       double mass     |   Mass of the projectile
+*       double diameter |   Diameter of the projectile
+*       double tkof     |   The knockout number wanted
+*/
+double muzz_tkof_velocity( const muzz_ctx *ctx, double mass, double diameter,
+        double tkof )
+{
+    return( tkof_inv_div( ( ctx->si ? TKOF_DIV_SI : TKOF_DIV_IMPERIAL ),
+                mass, diameter, tkof ));
+}
+
+
+
+/*==============================================================================
+                                     INPUTS
+--------------------------------------------------------------------------------
+*   Returns how many numbers one record needs:  three for the Taylor Knockout
+*   Formula (mass, velocity, diameter, or two of them and the TKOF), two for
+*   everything else.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*/
+int muzz_inputs( const muzz_ctx *ctx )
+{
+    return( muzz_knockout( ctx ) ? 3 : 2 );
+}
+
+
+
+/*==============================================================================
+                                    KNOCKOUT
+--------------------------------------------------------------------------------
+*   Returns 1 if the context solves the Taylor Knockout Formula, either way
+*   round, or 0 if it solves the energy formula.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*/
+int muzz_knockout( const muzz_ctx *ctx )
+{
+    return( ctx->solve == MUZZ_SOLVE_TKOF || ctx->solve == MUZZ_SOLVE_TKOF_MASS
+            || ctx->solve == MUZZ_SOLVE_TKOF_VELOCITY );
+}
+
+
+
+/*==============================================================================
+                                  SHOT INPUTS
+--------------------------------------------------------------------------------
+*   Fills in a shot from the numbers in the order they're given on the command
+*   line.  Everything not given is -1.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*       muzz_shot *shot |   The shot to fill in
+*       double *nums    |   The numbers; muzz_inputs() of them
+*/
+void muzz_shot_inputs( const muzz_ctx *ctx, muzz_shot *shot,
+        const double *nums )
+{
+    shot->mass = shot->velocity = shot->energy = -1;
+    shot->diameter = shot->tkof = -1;
+
+    switch( ctx->solve )
+    {
+        case MUZZ_SOLVE_ENERGY:
+            shot->mass = nums[0];
+            shot->velocity = nums[1];
+            break;
+
+        case MUZZ_SOLVE_MASS:
+            shot->velocity = nums[0];
+            shot->energy = nums[1];
+            break;
+
+        case MUZZ_SOLVE_VELOCITY:
+            shot->mass = nums[0];
+            shot->energy = nums[1];
+            break;
+
+        case MUZZ_SOLVE_TKOF:
+            shot->mass = nums[0];
+            shot->velocity = nums[1];
+            shot->diameter = nums[2];
+            break;
+
+        case MUZZ_SOLVE_TKOF_MASS:
+            shot->velocity = nums[0];
+            shot->diameter = nums[1];
+            shot->tkof = nums[2];
+            break;
+
+        case MUZZ_SOLVE_TKOF_VELOCITY:
+            shot->mass = nums[0];
+            shot->diameter = nums[1];
+            shot->tkof = nums[2];
+            break;
+    }
+}
+
+
+
+/*==============================================================================
+                                    SHOT SET
+--------------------------------------------------------------------------------
+*   Fills in a shot from the numbers in the order they're given on the command
+*   line, then solves for whatever's missing.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*       muzz_shot *shot |   The shot to fill in
+*       double *nums    |   The numbers; muzz_inputs() of them
+*/
+void muzz_shot_set( const muzz_ctx *ctx, muzz_shot *shot, const double *nums )
+{
+    muzz_shot_inputs( ctx, shot, nums );
+    muzz_solve( ctx, shot );
+}
+
+
+
+/*==============================================================================
+                                  SHOT WANTED
+--------------------------------------------------------------------------------
+*   Returns the member of a shot that the context solves for.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*       muzz_shot *shot |   The shot
+*/
+double *muzz_shot_wanted( const muzz_ctx *ctx, muzz_shot *shot )
+{
+    switch( ctx->solve )
+    {
+        case MUZZ_SOLVE_MASS:
+        case MUZZ_SOLVE_TKOF_MASS:
+            return( &shot->mass );
+
+        case MUZZ_SOLVE_VELOCITY:
+        case MUZZ_SOLVE_TKOF_VELOCITY:
+            return( &shot->velocity );
+
+        case MUZZ_SOLVE_TKOF:
+            return( &shot->tkof );
+
+        default:
+            return( &shot->energy );
+    }
+}
+
+
+
+/*==============================================================================
+                                     SOLVE
+--------------------------------------------------------------------------------
+*   Fills in whichever value of the shot the context says we're solving for.
+*
+*   Params
+*       muzz_ctx *ctx   |   The context
+*       muzz_shot *shot |   The shot
+*/
+void muzz_solve( const muzz_ctx *ctx, muzz_shot *shot )
+{
+    switch( ctx->solve )
+    {
+        case MUZZ_SOLVE_ENERGY:
+            shot->energy = muzz_get_energy( ctx, shot->mass, shot->velocity );
+            break;
+
+        case MUZZ_SOLVE_MASS:
+            shot->mass = muzz_get_mass( ctx, shot->velocity, shot->energy );
+            break;
+
+        case MUZZ_SOLVE_VELOCITY:
+            shot->velocity = muzz_get_velocity( ctx, shot->mass, shot->energy );
+            break;
+
+        case MUZZ_SOLVE_TKOF:
+            shot->tkof = muzz_tkof( ctx, shot->mass, shot->velocity,
+                    shot->diameter );
+            break;
+
+        case MUZZ_SOLVE_TKOF_MASS:
+            shot->mass = muzz_tkof_mass( ctx, shot->velocity, shot->diameter,
+                    shot->tkof );
+            break;
+
+        case MUZZ_SOLVE_TKOF_VELOCITY:
+            shot->velocity = muzz_tkof_velocity( ctx, shot->mass,
+                    shot->diameter, shot->tkof );
+            break;
+    }
+}
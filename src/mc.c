@@ -0,0 +1,108 @@
+/*******************************************************************************
+ *  mc.c        |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Normally distributed numbers for '--mc'.  The uniform bits come from a
+ *  counter hashed by the SplitMix64 finalizer:  there's no state to carry
+ *  from one number to the next, so the hashing runs a whole batch of
+ *  counters at once (and the compiler can spread it over vector lanes), and
+ *  sample i of a stream is the same number whoever draws it.  Pairs of
+ *  uniforms become pairs of normals by the Box-Muller transform.
+ *
+ ******************************************************************************/
+#include <math.h>
+
+#include "mc.h"
+
+
+/*  Step between counters, and between streams; 2^64 over the golden ratio */
+#define GOLDEN 0x9e3779b97f4a7c15ull
+
+/*  Pairs of samples hashed at a time */
+#define MC_PAIRS 256
+
+#define TWO_PI 6.283185307179586
+
+
+
+/*==============================================================================
+                                     MIX64
+--------------------------------------------------------------------------------
+*   The SplitMix64 finalizer:  every bit of x affects every bit of the result.
+*/
+static inline uint64_t mix64( uint64_t x )
+{
+    x = ( x ^ ( x >> 30 )) * 0xbf58476d1ce4e5b9ull;
+    x = ( x ^ ( x >> 27 )) * 0x94d049bb133111ebull;
+    return( x ^ ( x >> 31 ));
+}
+
+
+
+/*==============================================================================
+                                   MC NORMALS
+--------------------------------------------------------------------------------
+*   Samples 2p and 2p + 1 of a stream are the two halves of one Box-Muller
+*   pair, made from counters 2p and 2p + 1, so a run that starts or stops
+*   halfway through a pair still gets the same numbers.
+*
+*   Params
+*       double *out     |   Where to put them
+*       size_t n        |   How many
+*       uint64_t seed   |   The run's seed
+*       int stream      |   Which stream (one per input)
+*       uint64_t first  |   Which sample of the stream out[0] is
+*       double mean     |   Mean of the distribution
+*       double sd       |   Standard deviation; 0 for the mean every time
+*/
+void mc_normals( double *out, size_t n, uint64_t seed, int stream,
+        uint64_t first, double mean, double sd )
+{
+    uint64_t bits[ 2 * MC_PAIRS ];
+    uint64_t key = mix64( seed + GOLDEN * (uint64_t)( stream + 1 ));
+    uint64_t pair = first / 2;
+    uint64_t end = first + n;
+    uint64_t s;
+    size_t pairs;
+    size_t i;
+    double u1, u2, r, z[ 2 ];
+    int half;
+
+    if( sd == 0 )
+    {
+        for( i = 0; i < n; ++i )
+            out[i] = mean;
+        return;
+    }
+
+    while( 2 * pair < end )
+    {
+        pairs = ( end - 2 * pair + 1 ) / 2;
+        if( pairs > MC_PAIRS )
+            pairs = MC_PAIRS;
+
+        for( i = 0; i < 2 * pairs; ++i )
+            bits[i] = mix64( key + GOLDEN * ( 2 * pair + i ));
+
+        for( i = 0; i < pairs; ++i )
+        {
+            /*  53 bits each; u1 is in (0, 1] so its log is finite */
+            u1 = (double)(( bits[ 2 * i ] >> 11 ) + 1 ) * 0x1p-53;
+            u2 = (double)( bits[ 2 * i + 1 ] >> 11 ) * 0x1p-53;
+
+            r = sqrt( -2 * log( u1 ));
+            z[0] = r * cos( TWO_PI * u2 );
+            z[1] = r * sin( TWO_PI * u2 );
+
+            for( half = 0; half < 2; ++half )
+            {
+                s = 2 * ( pair + i ) + half;
+                if( s >= first && s < end )
+                    out[ s - first ] = mean + sd * z[ half ];
+            }
+        }
+
+        pair += pairs;
+    }
+}
@@ -0,0 +1,26 @@
+/*******************************************************************************
+ *  mc.h        |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Random numbers for '--mc'.  Every sample of every stream is worked out
+ *  from the seed and its own position alone, so any part of a run can be
+ *  drawn on its own, on any thread, and still come out the same.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_MC_H
+#define MUZZ_MC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ *  Fills out[0..n-1] with samples first to first + n - 1 of a stream of
+ *  normally distributed numbers with the given mean and SD.  Streams with
+ *  the same seed but a different number are independent.
+ */
+void mc_normals( double *out, size_t n, uint64_t seed, int stream,
+        uint64_t first, double mean, double sd );
+
+#endif
@@ -1,5 +1,5 @@
 /*******************************************************************************
- *  muzz.c  |   version 1.01    |   zlib license    |   2017-11-23
+ *  muzz.c  |   version 1.02    |   zlib license    |   2026-10-14
  *  James Hendrie               |   hendrie.james@gmail.com
  *  ----------------------------------------------------------------------------
  *
@@ -12,70 +12,53 @@
  *  on which the user prefers.
  *
  *  The program can also output results using the 'Taylor Knockout Formula', if
- *  the user wishes to do so, but will not convert from the TKOF number to get
- *  mass, velocity, etc.  All TKOF calculations MUST be provided all three
- *  parameters:  Mass, velocity, diameter.  Again, these can be Imperial or Si.
+ *  the user wishes to do so.  All TKOF calculations MUST be provided all three
+ *  parameters:  Mass, velocity, diameter; or, to work out the mass (or
+ *  velocity) it takes to reach a TKOF, the velocity (or mass), diameter and
+ *  the TKOF.  Again, these can be Imperial or Si.
+ *
+ *  In batch mode ('-b', '-f FILE' or '-'), the parameters are instead read one
+ *  record per line, and one result is printed for each record.  In sweep mode
+ *  ('-g'), each parameter can be a range, START:STOP[:STEP], and a result is
+ *  printed for every combination of them.  With '--summary', either mode
+ *  prints the mean, spread and percentiles of the results instead, split up
+ *  by the first field of each record with '--group'.  With '--top', only the
+ *  best few results are printed, and '--where' leaves out any results that
+ *  don't meet its conditions.  With '--mc', each parameter is MEAN[+-SD],
+ *  and the summary is of that many random draws from those distributions.
+ *  With '--drag', each set of parameters ends with a ballistic coefficient,
+ *  and the results are at every distance of '--range' instead of the muzzle.
+ *  gzip (or zstd) input is decompressed as it's read, and '--compress'
+ *  compresses the output.  With '--target', the energy (or TKOF) to reach is
+ *  the same for every record, and the records are a catalog of the rest.
+ *  With '--shard=I/N', only the I'th of N pieces of the file, sweep or draws
+ *  is done; a shard's summary or top is written as a partial, and 'muzz
+ *  merge' adds the partials up into the whole run's.
+ *
+ *  In server mode ('--serve ADDR'), the program stays up and answers requests
+ *  from clients, one line each, over a Unix or TCP socket.
  *
  ******************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
 #include <unistd.h>
-#include <math.h>   //  Make sure to link with -lm
-
-#define VERSION "1.01"
-
-#define MAX_STR 255
-
-
-
-
-/*  The parameter types we'll want */
-enum ParametersGiven {
-    PARAM_MASS,
-    PARAM_VELOCITY,
-    PARAM_ENERGY,
-    TOTAL_VALUES_WANTED
-};
+#include <getopt.h>
 
+#include "muzz.h"
+#include "batch.h"
+#include "serve.h"
+#include "stats.h"
+#include "cache.h"
+#include "zstream.h"
+#include "partial.h"
 
-/*  The options we're going to use later */
-enum OptionsEnum {
-    OPT_VERBOSE,
-    OPT_SI,
-    OPT_PRECISE,
-    OPT_TKOF,
-    OPT_K,
-    TOTAL_OPTIONS
-};
-
-
-/*  
- *  Gravitational constant ( ( (N * (distance**2))/second) ** 2 )
- *
- *  This is the 'approximated' constant, apparently used in the small arms
- *  business when calculating lbf.
- */
-//  Units of measure:  feet
-const double GRAVITY_IMPERIAL_APPROX = 32.163;
-
-//  Same but not approximated
-const double GRAVITY_IMPERIAL = 32.1739;
-
-/*
- *  Note that I'm not including the Si gravity accleration constant because
- *  the constant is used to calculate a number by which we divide other numbers.
- *  For imperial, K = ( 2 * (constant) * 7000 ), while for Si, K = 1000.
- *
- *  Also, for Imperial calculations we'll later assign K to 450240, which is
- *  the standard number used when not calculating with the gravity constant.
- *  It's very close to the result given when doing so, though I don't know
- *  where they get it precisely.
- */
-
+#define VERSION MUZZ_VERSION
 
-/*  Value 'K' (constant by which we divide (mass*(velocity**2)) */
-double K;
+#define MAX_STR 255
 
 
 
@@ -92,13 +75,103 @@ double K;
  *  v   for velocity
  *  e   for energy (default)
  *  p   Be precise (do not floor results, do not ceiling results)
- *  t   Print results for Taylor Knockout Formula instead of standard
+ *  t   Print results for Taylor Knockout Formula instead of standard (with
+ *      m or v, the mass or velocity for a TKOF)
  *  c   'Small arms standard' for earth gravitational accel. constant
  *  C   Use non-approximated standard for earth gravitational accel. constant
  *  K   Use industry standard constant (do not calculate) (default)
  *  k   Custom constant
+ *  b   Batch mode; read records from standard input
+ *  f   Batch mode; read records from the given file
+ *  j   Number of threads to use in batch mode
+ *  g   Sweep mode; parameters are ranges
+ *  l   Server mode; listen on the given socket (also '--serve')
+ *  a   Summarize batch or sweep results instead of printing them
+ *
+ *  Long only:
+ *  --stats[=json]  Print counts and timings for batch, sweep and server mode
+ *                  at exit
+ *  --input=FMT     Batch mode records are 'text' (default) or 'binary'
+ *  --output=FMT    Batch and sweep results are 'text' (default), 'binary',
+ *                  'csv' or 'ndjson'
+ *  --summary[=json]    Same as '-a', printed as a table or as JSON
+ *  --group         Summaries are grouped by the first field of each record
+ *  --top=K[:[-]COL]    Only print the K highest (or lowest) results
+ *  --where=COND    Only count results where COND holds, e.g. 'velocity<1100'
+ *  --mc[=N]        Monte Carlo:  parameters are MEAN[+-SD]; draw N samples
+ *  --seed=N        Where the Monte Carlo draws start from (default 0)
+ *  --drag=MODEL    Downrange:  parameters end with a G1 or G7 BC
+ *  --range=RANGE   Downrange:  distances, START:STOP[:STEP]
+ *  --fast          Batch and sweep mode use the fast kernels, if they pass
+ *  --follow        Batch mode:  keep reading the file as it grows
+ *  --tagged        Batch mode:  numbers may carry units, e.g. '230gr 900fps'
+ *  --compress=FMT  Batch and sweep results are compressed, 'gzip' or 'zstd'
+ *  --target=NUM    With m or v:  the energy (or TKOF) every record is to reach
+ *  --cache[=N]     Server mode:  keep N formatted answers for reuse
+ *  --shard=I/N     Batch, sweep and Monte Carlo:  only do shard I of N
+ *
+ *  'muzz merge FILE ...' adds up the partials the shards wrote.
  */
-static const char *optString = "VhEHSqsimveptcCKk:";
+static const char *optString = "VhEHSqsimveptcCKk:bf:j:gl:a";
+
+/*  Long options with no short version */
+#define OPT_STATS 256
+#define OPT_INPUT 257
+#define OPT_OUTPUT 258
+#define OPT_SUMMARY 259
+#define OPT_GROUP 260
+#define OPT_TOP 261
+#define OPT_WHERE 262
+#define OPT_MC 263
+#define OPT_SEED 264
+#define OPT_DRAG 265
+#define OPT_RANGE 266
+#define OPT_FAST 267
+#define OPT_FOLLOW 268
+#define OPT_TAGGED 269
+#define OPT_COMPRESS 270
+#define OPT_TARGET 271
+#define OPT_CACHE 272
+#define OPT_SHARD 273
+
+/*  Most threads '-j' may ask for */
+#define JOBS_MAX 1024
+
+/*  Monte Carlo samples, unless '--mc' says otherwise */
+#define MC_SAMPLES 1000000
+
+/*  Distances downrange, unless '--range' says otherwise */
+#define DRAG_RANGE "0:1000:100"
+
+/*  What '--stats' asked for */
+enum StatsMode {
+    STATS_OFF,
+    STATS_TEXT,
+    STATS_JSON
+};
+
+static const struct option longOpts[] = {
+    { "serve",  required_argument,  NULL,   'l' },
+    { "stats",  optional_argument,  NULL,   OPT_STATS },
+    { "input",  required_argument,  NULL,   OPT_INPUT },
+    { "output", required_argument,  NULL,   OPT_OUTPUT },
+    { "summary", optional_argument, NULL,   OPT_SUMMARY },
+    { "group",  no_argument,        NULL,   OPT_GROUP },
+    { "top",    required_argument,  NULL,   OPT_TOP },
+    { "where",  required_argument,  NULL,   OPT_WHERE },
+    { "mc",     optional_argument,  NULL,   OPT_MC },
+    { "seed",   required_argument,  NULL,   OPT_SEED },
+    { "drag",   required_argument,  NULL,   OPT_DRAG },
+    { "range",  required_argument,  NULL,   OPT_RANGE },
+    { "fast",   no_argument,        NULL,   OPT_FAST },
+    { "follow", no_argument,        NULL,   OPT_FOLLOW },
+    { "tagged", no_argument,        NULL,   OPT_TAGGED },
+    { "compress", required_argument, NULL,  OPT_COMPRESS },
+    { "target", required_argument,  NULL,   OPT_TARGET },
+    { "cache",  optional_argument,  NULL,   OPT_CACHE },
+    { "shard",  required_argument,  NULL,   OPT_SHARD },
+    { NULL,     0,                  NULL,   0 }
+};
 
 
 
@@ -111,6 +184,14 @@ static const char *optString = "VhEHSqsimveptcCKk:";
 void print_usage( FILE *fp )
 {
     fprintf( fp, "Usage:  muzz [OPTION] MASS VELOCITY [DIAMETER]\n" );
+    fprintf( fp, "        muzz [OPTION] -b | -f FILE | -\n" );
+    fprintf( fp, "        muzz [OPTION] --follow -f FILE\n" );
+    fprintf( fp, "        muzz [OPTION] -g START:STOP[:STEP] ...\n" );
+    fprintf( fp, "        muzz [OPTION] --mc[=N] MEAN[+-SD] ...\n" );
+    fprintf( fp, "        muzz [OPTION] --drag=G1|G7 MASS VELOCITY [DIAMETER] "
+            "BC\n" );
+    fprintf( fp, "        muzz [OPTION] --serve SOCKET | [HOST:]PORT\n" );
+    fprintf( fp, "        muzz merge PARTIAL ...\n" );
 }
 
 
@@ -153,7 +234,63 @@ void print_help( void )
 
     printf( "  -p\t\tBe precise (do not round any numbers)\n  " );
     printf("-t\t\tUse Taylor Knockout Formula (give mass, velocity, diameter)");
-    putchar( '\n' );
+    printf( "\n\t\tWith -m or -v, the mass (velocity) for a TKOF:  give ");
+    printf( "velocity\n\t\t(mass), diameter and TKOF\n" );
+
+    printf( "  -b\t\tBatch mode:  read one record per line from stdin\n" );
+    printf( "  -f [file]\tBatch mode:  read one record per line from file\n" );
+    printf( "  -j [num]\tBatch mode:  use this many threads (0 = all CPUs)\n");
+    printf( "  -g\t\tSweep mode:  parameters are ranges, START:STOP[:STEP]\n");
+    printf( "  -l [addr]\tServer mode:  answer requests on a Unix socket ");
+    printf( "or TCP port\n\t\t(same as --serve)\n" );
+    printf( "  --stats[=json]\tBatch, sweep and server mode:  print counts ");
+    printf( "and timings to\n\t\tstderr at exit, as text or JSON\n" );
+    printf( "  --input=[fmt]\tBatch mode:  records are 'text' (default) or ");
+    printf( "'binary'\n\t\tcolumns\n" );
+    printf( "  --output=[fmt]\tBatch and sweep mode:  results are 'text' ");
+    printf( "(default),\n\t\t'binary' columns, 'csv' or 'ndjson', with ");
+    printf( "every field and its\n\t\tunits\n" );
+    printf( "  --compress=[fmt]\tBatch and sweep mode:  compress the results ");
+    printf( "with 'gzip'\n\t\tor 'zstd' (gzip or zstd input is always ");
+    printf( "decompressed)\n" );
+    printf( "  -a\t\tBatch and sweep mode:  print the mean, SD, extreme ");
+    printf( "spread and\n\t\tpercentiles of the results instead of each ");
+    printf( "one\n" );
+    printf( "  --summary[=json]\tSame as -a, as a table or JSON\n" );
+    printf( "  --group\tSummarize by the first field of each record (a load ");
+    printf( "ID, say)\n" );
+    printf( "  --top=[k]\tBatch and sweep mode:  print only the k highest ");
+    printf( "results, best\n\t\tfirst; k:-COL for the k lowest of a column ");
+    printf( "instead\n" );
+    printf( "  --where=[cond]\tBatch and sweep mode:  leave out results ");
+    printf( "unless COL OP NUM\n\t\tholds (OP is < <= > >= == !=); may ");
+    printf( "be given more than once;\n\t\t== and != take a list, e.g. ");
+    printf( "'diameter==.308,.338'\n" );
+    printf( "  --target=[num]\tWith -m or -v:  the energy (with -t, the ");
+    printf( "TKOF) to reach,\n\t\tso records (or parameters) leave it ");
+    printf( "out\n" );
+    printf( "  --mc[=num]\tMonte Carlo:  parameters are MEAN[+-SD]; ");
+    printf( "summarize num\n\t\trandom draws (default 1,000,000)\n" );
+    printf( "  --seed=[num]\tMonte Carlo:  start the draws from this seed ");
+    printf( "(default 0)\n" );
+    printf( "  --drag=[G1|G7]\tDownrange:  parameters end with a BC for ");
+    printf( "this drag model;\n\t\tenergy or TKOF at each distance instead ");
+    printf( "of the muzzle\n" );
+    printf( "  --range=[range]\tDownrange:  the distances (yards or ");
+    printf( "meters),\n\t\tSTART:STOP[:STEP] (default 0:1000:100)\n" );
+    printf( "  --fast\tBatch and sweep mode:  use the fast kernels, if they ");
+    printf( "check out\n\t\tthe same as the reference to well past what -p ");
+    printf( "shows\n" );
+    printf( "  --follow\tBatch mode:  keep reading the file (-f) as lines ");
+    printf( "are added,\n\t\tlike tail -F, until interrupted\n" );
+    printf( "  --tagged\tBatch mode:  numbers may end in their units (gr g ");
+    printf( "fps m/s ftlb J\n\t\tin mm), which also say what each record ");
+    printf( "solves for\n" );
+    printf( "  --cache[=num]\tServer mode:  keep num answers (default ");
+    printf( "16,384), formatted,\n\t\tfor requests that come again\n" );
+    printf( "  --shard=I/N\tBatch, sweep and Monte Carlo:  only do shard I ");
+    printf( "(from 0) of N;\n\t\ta summary or top is written as a partial ");
+    printf( "for 'muzz merge'\n" );
 }
 
 
@@ -186,6 +323,85 @@ void print_examples( void )
 
     printf( "\nmuzz -ts 15 255 11.6\n" );
     printf( "  Same, but using Si units (grams, meters/second, mm)\n");
+
+    printf( "\nmuzz -tv 500 .458 40\n" );
+    printf( "  Returns the velocity a 500 grain, .458\" bullet needs for a ");
+    printf( "TKOF of 40\n" );
+
+    printf( "\nmuzz -q -f shots.csv\n" );
+    printf( "  Prints the energy of every 'mass,velocity' record in shots.csv,");
+    printf( " one\n  result per line\n" );
+
+    printf( "\nprintf '230 900\\n185 1000\\n' | muzz -b\n" );
+    printf( "  Same, but reading the records from standard input\n" );
+
+    printf( "\nmuzz -q -g 100:500 600:3500:5\n" );
+    printf( "  Prints the energy of every mass from 100 to 500 grains at every");
+    printf( "\n  velocity from 600 to 3500 ft/s, in steps of 5\n" );
+
+    printf( "\nmuzz -a --group -f strings.txt\n" );
+    printf( "  Prints the mean, SD, extreme spread and percentiles of the ");
+    printf( "mass, velocity\n  and energy for each load in strings.txt, where ");
+    printf( "each line is 'LOAD MASS\n  VELOCITY'\n" );
+
+    printf( "\nmuzz -q --top=10 --where='velocity<=1100' -g 100:500 600:1500"
+            "\n" );
+    printf( "  Prints the ten most energetic loads from 100 to 500 grains at ");
+    printf( "up to\n  1100 ft/s, most energetic first\n" );
+
+    printf( "\nmuzz --mc -j0 230+-0.3 900+-12\n" );
+    printf( "  Prints the mean, SD, spread and percentiles of the energy of a ");
+    printf( "230 grain\n  bullet (+/- 0.3 gr SD) @ 900 ft/s (+/- 12 ft/s ");
+    printf( "SD), from a million\n  draws spread over every CPU\n" );
+
+    printf( "\nmuzz --drag=G7 --range=0:1000:250 175 2600 .243\n" );
+    printf( "  Prints the velocity and energy of a 175 grain bullet with a ");
+    printf( "G7 BC of .243,\n  fired at 2600 ft/s, at the muzzle and every ");
+    printf( "250 yards out to 1000\n" );
+
+    printf( "\nmuzz -q -p --fast -f shots.csv\n" );
+    printf( "  Same as '-q -f shots.csv' but precise, with the fast kernels ");
+    printf( "if they\n  pass their check\n" );
+
+    printf( "\nmuzz --summary=json --follow -f chrono.csv\n" );
+    printf( "  Prints a summary of every shot in chrono.csv, then a new one ");
+    printf( "each time\n  the chronograph adds shots, until interrupted\n" );
+
+    printf( "\nmuzz -q -j0 --compress=gzip -f chrono-2025.csv.gz > res.gz\n" );
+    printf( "  Reads a gzipped log, decompressing on a thread of its own, ");
+    printf( "and writes\n  the results gzipped as well\n" );
+
+    printf( "\nmuzz --tagged -f mixed.txt\n" );
+    printf( "  Reads lines like '230gr 900fps', '15g 270m/s' and '900fps ");
+    printf( "400ftlb' and\n  prints the energy of the first, the energy (in ");
+    printf( "joules) of the second\n  and the mass of the third\n" );
+
+    printf( "\nmuzz -tv --target=20 --where='velocity<=2800' ");
+    printf( "--where='diameter==.308,.338'\n     -f bullets.txt\n" );
+    printf( "  Reads 'MASS DIAMETER' lines and prints the velocity each ");
+    printf( "bullet needs for\n  a TKOF of 20, for the .308\" and .338\" ");
+    printf( "bullets that get there by 2800 ft/s\n" );
+
+    printf( "\nmuzz --serve /run/muzz.sock\n" );
+    printf( "  Answers requests on a Unix socket; 'echo 230 900 | nc -U ");
+    printf( "/run/muzz.sock'\n  prints the energy of a 230 grain bullet @ ");
+    printf( "900 ft/s\n" );
+
+    printf( "\nmuzz --cache --stats --serve 8080\n" );
+    printf( "  Answers requests on TCP port 8080, keeping answers for the ");
+    printf( "requests that\n  come again, and prints counts (cache hits too) ");
+    printf( "once it's stopped\n" );
+
+    printf( "\nmuzz --output=ndjson -g 100:300:100 900\n" );
+    printf( "  Prints a line of JSON per shot, like " );
+    printf( "'{\"mass_gr\":100.00,\n" );
+    printf( "  \"velocity_fps\":900.00,\"energy_ftlbf\":179.90}'\n" );
+
+    printf( "\nmuzz --shard=3/8 --top=10 -f catalog.txt > top.3; " );
+    printf( "muzz merge top.*\n" );
+    printf( "  Ranks the fourth eighth of catalog.txt (on a node of its " );
+    printf( "own, say); once all\n  eight are done, prints the ten best " );
+    printf( "of the whole catalog\n" );
 }
 
 
@@ -252,282 +468,160 @@ void print_version( void )
 
 
 
-
 /*==============================================================================
-                                   GET ENERGY
+                                     RESULT
 --------------------------------------------------------------------------------
-*   Returns the energy, given the mass and velocity of the projectile.
+*   This function is where we shove all of our lovely data, where it then
+*   calls the library to do the calculations and prints the results.
 *
 *   Params
-*       double mass     |   Mass of the projectile
-*       double velocity |   Velocity of the projectile
-*       int si          |   Are we using Si units of measure
+*       muzz_ctx *ctx   |   Program options (si, verbose, etc.) and constant
+*       double *nums    |   The numbers, in the order the user gave them
 */
-double get_energy( double mass, double velocity, int si )
+void result( const muzz_ctx *ctx, const double *nums )
 {
-    /*  Si */
-    if( si == 1 )
-        return( (double)(( (mass/2.0f) * (velocity*velocity)) / K) );
+    char line[ MUZZ_FORMAT_MAX ];
+    muzz_shot shot;
 
-    /*  Imperial */
-    else
-        return( (double)( ( mass * (velocity*velocity)) / K ));
+    muzz_shot_set( ctx, &shot, nums );
+    muzz_format( ctx, &shot, line, sizeof( line ));
+    fputs( line, stdout );
 }
 
 
-
 /*==============================================================================
-                                    GET MASS
+                                  PARSE NUMBER
 --------------------------------------------------------------------------------
-*   Returns the mass of the projectile, given the velocity and muzzle energy.
+*   Reads a number from the command line.  Returns 0, or complains and returns
+*   -1 if it isn't a number.
 *
 *   Params
-*       double velocity |   Velocity of the projectile
-*       double energy   |   Energy of the projectile
-*       int si          |   Are we using Si units of measure
+*       const char *str |   The argument
+*       double *out     |   Where to put the number
 */
-double get_mass( double velocity, double energy, int si )
+int parse_number( const char *str, double *out )
 {
-    /*  Si */
-    if( si == 1 )
-        return( (double)( ( (energy*2)/(velocity*velocity) ) * K ));
+    if( muzz_parse_double( str, strlen( str ), out ) == 0 )
+        return( 0 );
 
-    /*  Imperial */
-    else
-        return( (double)( (energy/(velocity*velocity)) * K ));
+    fprintf( stderr, "ERROR:  Not a number:  %s\n", str );
+    print_usage( stderr );
+    fprintf( stderr, "\nTo view help, run with -h argument.\n" );
+    return( -1 );
 }
 
 
 
 /*==============================================================================
-                                  GET VELOCITY
+                                  PARSE FORMAT
 --------------------------------------------------------------------------------
-*   Returns the velocity of the projectile, given the mass and muzzle energy.
+*   Reads the format given to '--input' or '--output'.  Returns 0, or
+*   complains and returns -1 if we don't know it (CSV and NDJSON are only
+*   for output).
 *
 *   Params
-*       double mass     |   Mass of the projectile
-*       double energy   |   Energy of the projectile
-*       int si          |   Are we using Si units of measure
+*       const char *str |   The argument
+*       int *format     |   Where to put it (enum BatchFormat)
+*       int output      |   1 for '--output'
 */
-double get_velocity( double mass, double energy, int si )
+int parse_format( const char *str, int *format, int output )
 {
-    /*  Si */
-    if( si == 1 )
-        return( sqrt( ( (energy*2)/mass ) * K ));
-
-    /*  Imperial */
+    if( strcmp( str, "text" ) == 0 )
+        *format = BATCH_TEXT;
+    else if( strcmp( str, "binary" ) == 0 )
+        *format = BATCH_BINARY;
+    else if( output && strcmp( str, "csv" ) == 0 )
+        *format = BATCH_CSV;
+    else if( output && strcmp( str, "ndjson" ) == 0 )
+        *format = BATCH_NDJSON;
     else
-        return( sqrt( (energy/mass) * K ));
+    {
+        fprintf( stderr, "ERROR:  Unknown format:  %s\n", str );
+        return( -1 );
+    }
+
+    return( 0 );
 }
 
 
 
 /*==============================================================================
-                                 VERBOSE RESULT
+                                  PARSE COUNT
 --------------------------------------------------------------------------------
-*   Prints the results to the user in a 'verbose' way; i.e., more than just the
-*   number.
+*   Reads a whole number of at least one, which may be written like 1e6.
+*   Returns 0, or complains and returns -1 if it isn't one.
 *
 *   Params
-*       double mass     |   Mass of the projectile
-*       double velocity |   Velocity of the projectile
-*       double energy   |   Energy of the projectile
-*       int *options    |   Program options (si, verbosity, etc.)
+*       const char *str |   The argument
+*       uint64_t *count |   Where to put it
 */
-void verbose_result( double mass, double velocity, double energy, int *options )
+int parse_count( const char *str, uint64_t *count )
 {
-    if( options[ OPT_VERBOSE ] == 1 )
-    {
-        /*  Si */
-        if( options[ OPT_SI ] == 1 )
-        {
-            if( options[ OPT_PRECISE ] == 1 )
-            {
-                printf( "%.02lf g @ %.02lf m/s = %.02lf J\n",
-                        mass, velocity, energy );
-            }
-
-            else
-            {
-                printf( "%.02lf g @ %.02lf m/s = %.0lf J\n",
-                        mass, velocity, round(energy) );
-            }
-
-        }   //  END if si
+    double d;
 
-
-        /*  Imperial */
-        else
-        {
-            /*  If we're being precise */
-            if( options[ OPT_PRECISE ] == 1 )
-            {
-                printf( "%.02lf gr @ %.02lf ft/s = %.02lf lbf\n",
-                        mass, velocity, energy );
-            }
-
-            /*  Otherwise, keep the output prettier */
-            else
-            {
-                printf( "%.0lf gr @ %.0lf ft/s = %.0lf lbf\n",
-                        round( mass ), round( velocity ), round( energy ));
-            }
-
-        }   //  END else imperial
+    if( muzz_parse_double( str, strlen( str ), &d ) || d < 1 || d > 1e15
+            || d != (double)(uint64_t)d )
+    {
+        fprintf( stderr, "ERROR:  Not a count:  %s\n", str );
+        return( -1 );
     }
-}
 
+    *count = (uint64_t)d;
+    return( 0 );
+}
 
 
 
 /*==============================================================================
-                                     RESULT
+                                  PARSE SHARD
 --------------------------------------------------------------------------------
-*   This function is where we shove all of our lovely data, where it then
-*   calls other functions to do the calculations and print the results.
+*   Reads I/N, shard I (from 0) of N, into opts.  Returns 0, or complains
+*   and returns -1 if it isn't one.
 *
 *   Params
-*       double mass     |   Mass of the projectile
-*       double velocity |   Velocity of the projectile
-*       double energy   |   Energy of the projectile
-*       int param       |   Which of the three (mass, vel, energy) we solve for
-*       int *options    |   Program options (si, verbose, etc.)
+*       const char *str     |   The argument
+*       batch_opts *opts    |   Where to put it
 */
-void result( double mass, double velocity, double energy,
-        int param, int *options )
+int parse_shard( const char *str, batch_opts *opts )
 {
-    /*
-     *  Here, we set the constant.
-     */
-
-    switch( options[ OPT_K ] )
-    {
-        case -1:    //  Industry standard, don't calculate in-program (default)
-            K = 450240.0f;
-            break;
-
-        /* Use the industry's version of the grav. accel. constant (32.163) */
-        case 1:
-            K = ( 2 * GRAVITY_IMPERIAL_APPROX * 7000 );
-            break;
-
-        /*  Use standard (32.1739) */
-        case 2:
-            K = ( 2 * GRAVITY_IMPERIAL * 7000 );
-            break;
-    }
-
-    /*  If the user is using Si units, K = 1000 unless they entered their own */
-    if( options[ OPT_SI ] == 1 && options[ OPT_K ] != 0 )
-        K = 1000.0f;
-
-
-    double result = -1;
-
-    switch( param )
+    const char *slash = strchr( str, '/' );
+    double i;
+    double n;
+
+    if( slash == NULL || muzz_parse_double( str, slash - str, &i )
+            || muzz_parse_double( slash + 1, strlen( slash + 1 ), &n )
+            || n < 1 || n > PARTIAL_SHARDS_MAX || n != (int)n
+            || i < 0 || i >= n || i != (int)i )
     {
-        case PARAM_ENERGY:
-            result = get_energy( mass, velocity, options[ OPT_SI ] );
-            verbose_result( mass, velocity, result, options );
-            break;
-
-        case PARAM_MASS:
-            result = get_mass( velocity, energy, options[ OPT_SI ] );
-            verbose_result( result, velocity, energy, options );
-            break;
-
-        case PARAM_VELOCITY:
-            result = get_velocity( mass, energy, options[ OPT_SI ] );
-            verbose_result( mass, result, energy, options );
-            break;
-
-        default:
-            result = -1;
-            break;
+        fprintf( stderr, "ERROR:  Not a shard (I/N, 0 <= I < N <= %d):  %s\n",
+                PARTIAL_SHARDS_MAX, str );
+        return( -1 );
     }
 
-
-    /*  Print terse result */
-    if( options[ OPT_VERBOSE ] != 1 )
-    {
-        if( options[ OPT_PRECISE ] == 1 )
-            printf( "%.02lf\n", result );
-        else
-            printf( "%.0lf\n", result );
-    }
-
-
+    opts->shard = (int)i;
+    opts->shards = (int)n;
+    return( 0 );
 }
 
 
 
 /*==============================================================================
-                                      TKOF
-                           (Taylor Knockout Formula)
+                                  PRINT STATS
 --------------------------------------------------------------------------------
-*   This function prints results using the Taylor Knockout Formula, an
-*   alternative to the standard muzzle energy formula developed by African
-*   big-game hunter John Taylor.  Its purpose is not to be scientific, but to
-*   present the hunter with a simple number that is supposed to correspond
-*   well to its real-world performance according to Taylor's experience.
-*
+*   Prints the stats from a batch, sweep or server to stderr, if they were
+*   asked for.
 *
 *   Params
-*       double mass     |   Mass of the projectile
-*       double velocity |   Velocity of projectile
-*       double diameter |   Diameter of the projectile
-*       int *options    |   Program options
+*       run_stats *stats    |   What we counted
+*       int mode            |   One of enum StatsMode
 */
-void tkof( double mass, double velocity, double diameter, int *options )
+void print_stats( run_stats *stats, int mode )
 {
-    /*  Knockout number */
-    double ko;
-
-    /*  Si */
-    if( options[ OPT_SI ] == 1 )
-    {
-        ko = ( mass * velocity * diameter ) / 3500.0f;
-
-        /*  Verbose output */
-        if( options[ OPT_VERBOSE ] == 1 )
-        {
-            printf("%.02lf g @ %.02lf m/s (%.02lf mm diameter) = %.02lf TKOF\n",
-                    mass, velocity, diameter, ko );
+    if( mode == STATS_OFF )
+        return;
 
-        }
-
-        /*  Terse */
-        else
-            printf( "%.02lf\n", ko );
-    }
-
-    /*  Imperial */
-    else
-    {
-        ko = ( mass * velocity * diameter ) / 7000.0f;
-
-        /*  Verbose output */
-        if( options[ OPT_VERBOSE ] == 1 )
-        {
-            if( options[ OPT_PRECISE ] == 1 )
-            {
-                printf("%.02lf gr @ %.02lf ft/s (%.03lf\" diameter) = %.02lf ",
-                        mass, velocity, diameter, ko );
-                printf( "TKOF\n" );
-            }
-
-            else
-            {
-                printf( "%.0lf gr @ %.0lf ft/s (%.03lf\" diameter) = %.02lf ",
-                        round( mass ), round( velocity ), diameter, ko );
-                printf( "TKOF\n" );
-            }
-        }
-
-        /*  Terse */
-        else
-            printf( "%.02lf\n", ko );
-    }
+    stats_finish( stats );
+    stats_print( stats, stderr, ( mode == STATS_JSON ));
 }
 
 
@@ -553,32 +647,74 @@ int main( int argc, char *argv[] )
         return( 1 );
     }
 
-    /*  Init global options */
-    int options[ TOTAL_OPTIONS ];
+    /*  Putting a sharded run back together */
+    if( strcmp( argv[1], "merge" ) == 0 )
+    {
+        if( argc < 3 )
+        {
+            fprintf( stderr, "ERROR:  Nothing to merge\n" );
+            print_usage( stderr );
+            return( 1 );
+        }
+
+        return( batch_merge( argv + 2, argc - 2 ));
+    }
+
+    /*  Program options, starting from the defaults */
+    muzz_ctx ctx;
+    muzz_ctx_init( &ctx );
+
+    /*  The numbers given on the command line (mass, velocity, etc.) */
+    double nums[ 3 ];
     int i;
-    for( i = 0; i < TOTAL_OPTIONS; ++i )
-        options[ i ] = -1;
 
-    /*  Some options, we don't want set to -1 */
-    options[ OPT_VERBOSE ] = 1;
+    /*  Which value are we solving for? */
+    int valueWanted = MUZZ_SOLVE_ENERGY;
 
+    /*  Taylor Knockout Formula trumps whatever we'd otherwise solve for */
+    int useTkof = 0;
 
-    /*  Now, we create the variables we'll be using */
-    double mass;        //  Mass of the projectile
-    double velocity;    //  Velocity of the projectile
-    double diameter;    //  Diameter of projectile
-    double energy;      //  Energy of the projectile at the muzzle
+    /*  Batch input, if any ("-" is stdin), and how many threads to use */
+    char *batchFile = NULL;
+    int jobs = 1;
+    long jobNum;
+    int sweep = 0;
+    int follow = 0;         //  Keep reading the file as it grows
 
-    /*  Initialize everything to -1, which is default 'no' or 'invalid' */
-    mass = velocity = diameter = energy = -1;
+    /*  Monte Carlo:  how many draws (0 for none), and from where */
+    uint64_t mcSamples = 0;
+    uint64_t mcSeed = 0;
+    char *end;
 
-    /*  Which value are we solving for? */
-    int valueWanted = PARAM_ENERGY;
+    /*  '--cache':  answers to keep, or 0 */
+    uint64_t cacheSize = 0;
+
+    /*  '--target':  the energy (or TKOF) to reach, left out of the records */
+    double target;
+
+    /*  Downrange:  the distances, once '--drag' or '--range' asks for them */
+    batch_range distances;
+    batch_parse_range( DRAG_RANGE, &distances );
+    int fields;
+
+    /*  Where to listen, in server mode */
+    char *serveAddr = NULL;
+
+    /*  Whether to keep and print stats, and how */
+    int statsMode = STATS_OFF;
+    run_stats stats;
+
+    /*  How to run batches and sweeps */
+    batch_where where[ BATCH_WHERE_MAX ];
+    batch_opts batchOpts;
+    memset( &batchOpts, 0, sizeof( batchOpts ));
+    batchOpts.input = batchOpts.output = BATCH_TEXT;
+    batchOpts.where = where;
 
 
     /*  Do our optstring thing */
     int opt = 0;
-    opt = getopt( argc, argv, optString );
+    opt = getopt_long( argc, argv, optString, longOpts, NULL );
     while( opt != -1 )
     {
         switch( opt )
@@ -606,62 +742,450 @@ int main( int argc, char *argv[] )
             case 'S':   //  Silent mode
                 //  FALL THROUGH
             case 'q':
-                options[ OPT_VERBOSE ] = -1;
+                ctx.verbose = 0;
                 break;
 
             case 's':   //  Use si units of measure
-                options[ OPT_SI ] = 1;
+                ctx.si = 1;
                 break;
 
             case 'i':   //  Imperial units of measure (default)
-                options[ OPT_SI ] = -1;
+                ctx.si = 0;
                 break;
 
             case 'm':   //  Mass of the projectile
-                valueWanted = PARAM_MASS;
+                valueWanted = MUZZ_SOLVE_MASS;
                 break;
 
             case 'v':   //  Velocity of the projectile
-                valueWanted = PARAM_VELOCITY;
+                valueWanted = MUZZ_SOLVE_VELOCITY;
                 break;
 
             case 'e':   //  Energy of the projectile at the muzzle (default)
-                valueWanted = PARAM_ENERGY;
+                valueWanted = MUZZ_SOLVE_ENERGY;
                 break;
 
             case 'c':   //  Approximate earth gravitational constant
-                options[ OPT_K ] = 1;
+                ctx.kMode = MUZZ_K_GAC1;
                 break;
 
             case 'C':   //  Do not approximate earth gravitational constant
-                options[ OPT_K ] = 2;
+                ctx.kMode = MUZZ_K_GAC2;
                 break;
 
             case 'k':   //  User wants to input a custom constant
-                options[ OPT_K ] = 0;
-                K = atof( optarg );
+                ctx.kMode = MUZZ_K_CUSTOM;
+                if( parse_number( optarg, &ctx.customK ))
+                    return( 1 );
                 break;
 
             case 'K':   //  Use industry standard constant 450240 (default)
-                options[ OPT_K ] = -1;
+                ctx.kMode = MUZZ_K_INDUSTRY;
                 break;
 
             case 'p':
-                options[ OPT_PRECISE ] = 1;
+                ctx.precise = 1;
                 break;
 
             case 't':
-                options[ OPT_TKOF ] = 1;
+                useTkof = 1;
+                break;
+
+            case 'b':   //  Batch mode, reading from stdin
+                batchFile = "-";
+                break;
+
+            case 'f':   //  Batch mode, reading from a file
+                batchFile = optarg;
+                break;
+
+            case 'j':   //  Threads for batch mode
+                errno = 0;
+                jobNum = strtol( optarg, &end, 10 );
+                if( ! isdigit( (unsigned char)*optarg ) || errno
+                        || *end != '\0' || jobNum > JOBS_MAX )
+                {
+                    fprintf( stderr, "ERROR:  Not a number of threads (0 ");
+                    fprintf( stderr, "to %d):  %s\n", JOBS_MAX, optarg );
+                    print_usage( stderr );
+                    fprintf( stderr, "\nTo view help, run with -h ");
+                    fprintf( stderr, "argument.\n" );
+                    return( 1 );
+                }
+
+                /*  0 is every CPU */
+                jobs = (int)jobNum;
+                if( jobs == 0 )
+                    jobs = (int)sysconf( _SC_NPROCESSORS_ONLN );
+                if( jobs <= 0 )
+                    jobs = 1;
+                break;
+
+            case OPT_INPUT:     //  Format of batch records
+            case OPT_OUTPUT:    //  Format of results
+                if( parse_format( optarg, ( opt == OPT_INPUT ?
+                            &batchOpts.input : &batchOpts.output ),
+                            ( opt == OPT_OUTPUT )))
+                    return( 1 );
+                break;
+
+            case OPT_COMPRESS:  //  Compress the results
+                batchOpts.compress = zstream_format( optarg );
+                if( batchOpts.compress < 0
+                        || ! zstream_supported( batchOpts.compress ))
+                {
+                    fprintf( stderr, "ERROR:  Can't compress with %s\n",
+                            optarg );
+                    return( 1 );
+                }
+                break;
+
+            case 'g':   //  Sweep mode
+                sweep = 1;
+                break;
+
+            case 'l':   //  Server mode
+                serveAddr = optarg;
+                break;
+
+            case 'a':   //  Summarize the results
+                batchOpts.summary = SUMMARY_TEXT;
+                break;
+
+            case OPT_SUMMARY:   //  Same, maybe as JSON
+                if( optarg == NULL )
+                    batchOpts.summary = SUMMARY_TEXT;
+                else if( strcmp( optarg, "json" ) == 0 )
+                    batchOpts.summary = SUMMARY_JSON;
+                else
+                {
+                    fprintf( stderr, "ERROR:  Unknown summary format:  %s\n",
+                            optarg );
+                    return( 1 );
+                }
+                break;
+
+            case OPT_GROUP:     //  Summarize by key
+                batchOpts.group = 1;
+                if( batchOpts.summary == SUMMARY_OFF )
+                    batchOpts.summary = SUMMARY_TEXT;
+                break;
+
+            case OPT_TOP:       //  Only the best few
+                if( batch_parse_top( optarg, &batchOpts ))
+                {
+                    fprintf( stderr, "ERROR:  Invalid top:  %s\n", optarg );
+                    return( 1 );
+                }
+                break;
+
+            case OPT_WHERE:     //  Only results meeting a condition
+                if( batchOpts.numWhere == BATCH_WHERE_MAX )
+                {
+                    fprintf( stderr, "ERROR:  No more than %d conditions\n",
+                            BATCH_WHERE_MAX );
+                    return( 1 );
+                }
+
+                if( batch_parse_where( optarg,
+                            &where[ batchOpts.numWhere++ ] ))
+                {
+                    fprintf( stderr, "ERROR:  Invalid condition:  %s\n",
+                            optarg );
+                    return( 1 );
+                }
+                break;
+
+            case OPT_MC:        //  Monte Carlo
+                mcSamples = MC_SAMPLES;
+                if( optarg != NULL && parse_count( optarg, &mcSamples ))
+                    return( 1 );
+                break;
+
+            case OPT_SEED:      //  Where Monte Carlo starts
+                errno = 0;
+                mcSeed = strtoull( optarg, &end, 0 );
+                if( ! isdigit( (unsigned char)*optarg ) || errno
+                        || *end != '\0' )
+                {
+                    fprintf( stderr, "ERROR:  Invalid seed:  %s\n", optarg );
+                    return( 1 );
+                }
+                break;
+
+            case OPT_DRAG:      //  Downrange, under a drag model
+                if( strcasecmp( optarg, "G1" ) == 0 )
+                    batchOpts.drag = MUZZ_DRAG_G1;
+                else if( strcasecmp( optarg, "G7" ) == 0 )
+                    batchOpts.drag = MUZZ_DRAG_G7;
+                else
+                {
+                    fprintf( stderr, "ERROR:  Unknown drag model:  %s\n",
+                            optarg );
+                    return( 1 );
+                }
+                batchOpts.distances = &distances;
+                break;
+
+            case OPT_RANGE:     //  How far downrange
+                if( batch_parse_range( optarg, &distances )
+                        || ! ( distances.start >= 0 ) || ! ( distances.start
+                            + ( distances.count - 1 ) * distances.step >= 0 ))
+                {
+                    fprintf( stderr, "ERROR:  Not a range:  %s\n", optarg );
+                    return( 1 );
+                }
+                batchOpts.distances = &distances;
+                break;
+
+            case OPT_FOLLOW:    //  Keep reading as the file grows
+                follow = 1;
+                break;
+
+            case OPT_TAGGED:    //  Records may carry their units
+                batchOpts.tagged = 1;
+                break;
+
+            case OPT_TARGET:    //  The same energy (or TKOF) for every record
+                if( parse_number( optarg, &target ))
+                    return( 1 );
+                batchOpts.target = &target;
+                break;
+
+            case OPT_SHARD:     //  Only our part of the run
+                if( parse_shard( optarg, &batchOpts ))
+                    return( 1 );
+                break;
+
+            case OPT_CACHE:     //  Keep answers that may come again
+                cacheSize = CACHE_DEFAULT;
+                if( optarg != NULL && parse_count( optarg, &cacheSize ))
+                    return( 1 );
+                break;
+
+            case OPT_FAST:      //  Fast kernels, if they're good enough
+                ctx.fast = 1;
+                break;
+
+            case OPT_STATS: //  Counts and timings at exit
+                if( optarg == NULL )
+                    statsMode = STATS_TEXT;
+                else if( strcmp( optarg, "json" ) == 0 )
+                    statsMode = STATS_JSON;
+                else
+                {
+                    fprintf( stderr, "ERROR:  Unknown stats format:  %s\n",
+                            optarg );
+                    return( 1 );
+                }
                 break;
         }
 
-        opt = getopt( argc, argv, optString );
+        opt = getopt_long( argc, argv, optString, longOpts, NULL );
     }
 
     /*  Once outside the loop, adjust argc and argv */
     argv += ( optind - 1 );
     argc -= ( optind - 1 );
 
+    /*  Now that we know everything, settle on the constant once; with -t, -m
+     *  and -v work the knockout formula backwards */
+    if( useTkof && valueWanted == MUZZ_SOLVE_MASS )
+        ctx.solve = MUZZ_SOLVE_TKOF_MASS;
+    else if( useTkof && valueWanted == MUZZ_SOLVE_VELOCITY )
+        ctx.solve = MUZZ_SOLVE_TKOF_VELOCITY;
+    else
+        ctx.solve = ( useTkof ? MUZZ_SOLVE_TKOF : valueWanted );
+    muzz_ctx_resolve( &ctx );
+
+
+    batchOpts.jobs = jobs;
+    batchOpts.stats = ( statsMode ? &stats : NULL );
+    fields = muzz_inputs( &ctx ) + ( batchOpts.distances != NULL )
+        - ( batchOpts.target != NULL );
+
+    /*  Monte Carlo is all about the summary, unless something else is wanted */
+    if( mcSamples > 0 && batchOpts.summary == SUMMARY_OFF && ! batchOpts.top
+            && batchOpts.output == BATCH_TEXT )
+        batchOpts.summary = SUMMARY_TEXT;
+
+    if( batchOpts.summary && batchOpts.output != BATCH_TEXT )
+    {
+        fprintf( stderr, "ERROR:  A summary is text or JSON ");
+        fprintf( stderr, "('--summary=json'), not --output\n" );
+        return( 1 );
+    }
+
+    if( batchOpts.top && batchOpts.summary )
+    {
+        fprintf( stderr, "ERROR:  Can't summarize and print a top at once\n" );
+        return( 1 );
+    }
+
+    if( sweep && mcSamples > 0 )
+    {
+        fprintf( stderr, "ERROR:  Can't sweep and do Monte Carlo at once\n" );
+        return( 1 );
+    }
+
+    if( batchOpts.group && ( sweep || mcSamples > 0
+                || batchOpts.input == BATCH_BINARY ))
+    {
+        fprintf( stderr, "ERROR:  Only text records can be grouped\n" );
+        return( 1 );
+    }
+
+    if( batchOpts.distances != NULL && ctx.solve != MUZZ_SOLVE_ENERGY
+            && ctx.solve != MUZZ_SOLVE_TKOF )
+    {
+        fprintf( stderr, "ERROR:  Downrange is for energy or TKOF\n" );
+        return( 1 );
+    }
+
+    if( batchOpts.distances != NULL && ( batchOpts.input == BATCH_BINARY
+                || serveAddr != NULL ))
+    {
+        fprintf( stderr, "ERROR:  Downrange needs text records, a sweep, ");
+        fprintf( stderr, "--mc or parameters\n" );
+        return( 1 );
+    }
+
+    if( follow && ( batchFile == NULL || strcmp( batchFile, "-" ) == 0
+                || batchOpts.input == BATCH_BINARY ))
+    {
+        fprintf( stderr, "ERROR:  --follow needs a file of text records ");
+        fprintf( stderr, "(-f FILE)\n" );
+        return( 1 );
+    }
+
+    if( batchOpts.tagged && batchFile == NULL && ! ( argc == 2
+                && strcmp( argv[1], "-" ) == 0 ))
+    {
+        fprintf( stderr, "ERROR:  --tagged is for batch mode ");
+        fprintf( stderr, "(-b, -f FILE or -)\n" );
+        return( 1 );
+    }
+
+    /*  A TKOF has no units to tag it with */
+    if( batchOpts.tagged && useTkof && valueWanted != MUZZ_SOLVE_ENERGY )
+    {
+        fprintf( stderr, "ERROR:  --tagged records can't be solved for a ");
+        fprintf( stderr, "TKOF\n" );
+        return( 1 );
+    }
+
+    /*  Tagged records can be in any units, so there's nothing to compare */
+    if( batchOpts.tagged && ( batchOpts.input == BATCH_BINARY
+                || batchOpts.output != BATCH_TEXT || batchOpts.summary
+                || batchOpts.top || batchOpts.numWhere > 0
+                || batchOpts.distances != NULL ))
+    {
+        fprintf( stderr, "ERROR:  --tagged records are text, and can't be ");
+        fprintf( stderr, "summarized, ranked,\n        filtered or taken ");
+        fprintf( stderr, "downrange\n" );
+        return( 1 );
+    }
+
+    /*  A target is what's solved from, so there has to be something to solve */
+    if( batchOpts.target != NULL && ( valueWanted == MUZZ_SOLVE_ENERGY
+                || batchOpts.tagged || serveAddr != NULL ))
+    {
+        fprintf( stderr, "ERROR:  --target is the energy (or TKOF) for -m or ");
+        fprintf( stderr, "-v to reach, and\n        isn't for --tagged ");
+        fprintf( stderr, "records or server mode\n" );
+        return( 1 );
+    }
+
+    if( batchOpts.compress != ZFORMAT_NONE && ( batchOpts.summary
+                || follow || serveAddr != NULL ))
+    {
+        fprintf( stderr, "ERROR:  Only batch and sweep results (not a ");
+        fprintf( stderr, "summary) can be compressed\n" );
+        return( 1 );
+    }
+
+    /*  A shard is a piece of a file, a sweep or a Monte Carlo run */
+    if( batchOpts.shards > 0 && ( follow || serveAddr != NULL
+                || batchOpts.input == BATCH_BINARY || ( batchFile == NULL
+                    && ! sweep && mcSamples == 0 && ! ( argc == 2
+                        && strcmp( argv[1], "-" ) == 0 ))))
+    {
+        fprintf( stderr, "ERROR:  --shard is for text records in a file, ");
+        fprintf( stderr, "sweeps and --mc\n" );
+        return( 1 );
+    }
+
+    /*  Partials are read back as they are */
+    if( batchOpts.shards > 0 && batchOpts.top
+            && batchOpts.compress != ZFORMAT_NONE )
+    {
+        fprintf( stderr, "ERROR:  A shard's --top is a partial, which ");
+        fprintf( stderr, "isn't compressed\n" );
+        return( 1 );
+    }
+
+    /*  Batch mode's kernels run a whole chunk in less time than looking up
+     *  each record would take, so only a server has answers worth keeping */
+    if( cacheSize > 0 && serveAddr == NULL )
+    {
+        fprintf( stderr, "ERROR:  --cache is for server mode\n" );
+        return( 1 );
+    }
+
+    /*  Server mode:  requests come from clients instead */
+    if( serveAddr != NULL )
+    {
+        int status;
+
+        stats_init( &stats );
+        status = serve_run( serveAddr, &ctx, cacheSize, batchOpts.stats );
+
+        print_stats( &stats, statsMode );
+        return( status );
+    }
+
+
+    /*  A lone "-" for the parameters means batch mode on stdin */
+    if( argc == 2 && strcmp( argv[1], "-" ) == 0 )
+        batchFile = "-";
+
+    /*  Batch mode:  every line of the input is its own set of parameters */
+    if( batchFile != NULL )
+    {
+        FILE *fp = stdin;
+        int status;
+
+        /*  Following a file:  it's never done, so it's opened its own way */
+        if( follow )
+        {
+            stats_init( &stats );
+            status = batch_follow( batchFile, &ctx, &batchOpts );
+
+            print_stats( &stats, statsMode );
+            return( status );
+        }
+
+        if( strcmp( batchFile, "-" ) != 0 )
+        {
+            fp = fopen( batchFile, "r" );
+            if( fp == NULL )
+            {
+                fprintf( stderr, "ERROR:  Could not open %s\n", batchFile );
+                return( 1 );
+            }
+        }
+
+        stats_init( &stats );
+        status = batch_run( fp, ( fp == stdin ? "stdin" : batchFile ), &ctx,
+                &batchOpts );
+
+        if( fp != stdin )
+            fclose( fp );
+
+        print_stats( &stats, statsMode );
+        return( status );
+    }
+
 
     /*
      *  If the user didn't specify mass/velocity/energy, assume they gave mass
@@ -670,7 +1194,7 @@ int main( int argc, char *argv[] )
     if( argc > 1 )
     {
         /*  Only one arg */
-        if( argc == 2 )
+        if( argc == 2 && fields > 1 )
         {
             fprintf( stderr, "ERROR:  Need more than one parameter\n" );
             print_usage( stderr );
@@ -682,35 +1206,121 @@ int main( int argc, char *argv[] )
          *  If they want the Taylor Knockout Formula, we need exactly three
          *  parameters:  mass, velocity and diameter of projectile.
          */
-        else if( options[ OPT_TKOF ] == 1 )
+        else if( useTkof && argc <= fields && ctx.solve != MUZZ_SOLVE_TKOF )
+        {
+            fprintf( stderr, "ERROR:  Working the Taylor Knockout Formula " );
+            fprintf( stderr, "backwards requires %d\nparameters:  %s, ",
+                    fields, ( valueWanted == MUZZ_SOLVE_MASS ? "Velocity"
+                        : "Mass" ));
+            fprintf( stderr, "%s\n", ( batchOpts.target != NULL ? "Diameter"
+                        : "Diameter and TKOF" ));
+            print_usage( stderr );
+            fprintf( stderr, "\nTo view help, run with -h argument.\n" );
+            return( 1 );
+        }
+
+        else if( ctx.solve == MUZZ_SOLVE_TKOF && argc <= 3 )
+        {
+            fprintf( stderr, "ERROR:  The Taylor Knockout Formula requires " );
+            fprintf( stderr, "three paramters:\n" );
+            fprintf( stderr, "Mass, Velocity and Diameter of projectile\n" );
+            print_usage( stderr );
+            fprintf( stderr, "\nTo view help, run with -h argument.\n" );
+            return( 1 );
+        }
+
+        /*  Downrange, a BC comes after everything else */
+        else if( argc <= fields )
+        {
+            fprintf( stderr, "ERROR:  Downrange needs the BC last:  " );
+            fprintf( stderr, "MASS VELOCITY [DIAMETER] BC\n" );
+            print_usage( stderr );
+            fprintf( stderr, "\nTo view help, run with -h argument.\n" );
+            return( 1 );
+        }
+
+        /*  Sweep mode:  every parameter is a range */
+        if( sweep )
         {
-            /*  Too few */
-            if( argc <= 3 )
+            batch_range ranges[ 4 ];
+
+            for( i = 0; i < fields; ++i )
             {
-                fprintf(stderr,"ERROR:  The Taylor Knockout Formula requires ");
-                fprintf( stderr, "three paramters:\n" );
-                fprintf( stderr, "Mass, Velocity and Diameter of projectile\n");
-                print_usage( stderr );
-                fprintf( stderr, "\nTo view help, run with -h argument.\n" );
-                return( 1 );
+                if( batch_parse_range( argv[ i + 1 ], &ranges[ i ] ))
+                {
+                    fprintf( stderr, "ERROR:  Not a range:  %s\n",
+                            argv[ i + 1 ] );
+                    print_usage( stderr );
+                    return( 1 );
+                }
             }
 
-            /*  We're good */
-            else
+            stats_init( &stats );
+            i = batch_sweep( ranges, &ctx, &batchOpts );
+
+            print_stats( &stats, statsMode );
+            return( i );
+        }
+
+        /*  Monte Carlo:  every parameter is a distribution */
+        if( mcSamples > 0 )
+        {
+            batch_dist dists[ 4 ];
+
+            for( i = 0; i < fields; ++i )
             {
-                mass = atof( argv[1] );
-                velocity = atof( argv[2] );
-                diameter = atof( argv[3] );
+                if( batch_parse_dist( argv[ i + 1 ], &dists[ i ] ))
+                {
+                    fprintf( stderr, "ERROR:  Not MEAN[+-SD]:  %s\n",
+                            argv[ i + 1 ] );
+                    print_usage( stderr );
+                    return( 1 );
+                }
             }
+
+            stats_init( &stats );
+            i = batch_mc( dists, mcSamples, mcSeed, &ctx, &batchOpts );
+
+            print_stats( &stats, statsMode );
+            return( i );
         }
 
-        /*  Two or more args, just grab the first two */
-        else
+        /*
+         *  Downrange, or anything else only batch and sweep mode do (a
+         *  condition, a summary or top, another output format or
+         *  compression):  the parameters are a sweep of one cell
+         */
+        if( batchOpts.distances != NULL || batchOpts.numWhere > 0
+                || batchOpts.summary || batchOpts.top
+                || batchOpts.output != BATCH_TEXT
+                || batchOpts.compress != ZFORMAT_NONE )
         {
-            mass = atof( argv[1] );
-            velocity = atof( argv[2] );
+            batch_range ranges[ 4 ];
+
+            for( i = 0; i < fields; ++i )
+            {
+                if( parse_number( argv[ i + 1 ], &ranges[ i ].start ))
+                    return( 1 );
+
+                ranges[ i ].step = 1;
+                ranges[ i ].count = 1;
+            }
+
+            stats_init( &stats );
+            i = batch_sweep( ranges, &ctx, &batchOpts );
+
+            print_stats( &stats, statsMode );
+            return( i );
         }
 
+        /*  We're good; grab as many as we need, and the target after them */
+        for( i = 0; i < fields; ++i )
+            if( parse_number( argv[ i + 1 ], &nums[ i ] ))
+                return( 1 );
+
+        if( batchOpts.target != NULL )
+            nums[ fields ] = target;
+
     }   //  END if argc > 1
 
     else
@@ -722,35 +1332,7 @@ int main( int argc, char *argv[] )
     }
 
 
-
-    /*  If we want the standard muzzle energy formula */
-    if( options[ OPT_TKOF ] == -1 )
-    {
-        switch( valueWanted )
-        {
-            case PARAM_ENERGY:
-                mass = atof( argv[1] );
-                velocity = atof( argv[2] );
-                break;
-
-            case PARAM_MASS:
-                velocity = atof( argv[1] );
-                energy = atof( argv[2] );
-                break;
-
-            case PARAM_VELOCITY:
-                mass = atof( argv[1] );
-                energy = atof( argv[2] );
-                break;
-        }
-
-        result( mass, velocity, energy, valueWanted, options );
-    }   //  END standard muzzle energy forumla
-
-
-    /*  If we want Taylor Knockout Formula */
-    else
-        tkof( mass, velocity, diameter, options );
+    result( &ctx, nums );
 
     return( 0 );
 }
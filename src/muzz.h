@@ -0,0 +1,220 @@
+/*******************************************************************************
+ *  muzz.h  |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie               |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Public interface to libmuzz, the calculations behind the muzz program.
+ *
+ *  Everything the calculations depend on (units, constant, what we're solving
+ *  for, how to print it) lives in a muzz_ctx.  Fill one in with
+ *  muzz_ctx_init(), change whatever you like, then call muzz_ctx_resolve()
+ *  once to work out the constant.  After that the context is only ever read,
+ *  so any number of threads may share it.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_H
+#define MUZZ_H
+
+#include <stddef.h>
+
+#define MUZZ_VERSION "1.02"
+
+
+/*  What we're solving for */
+enum muzz_solve {
+    MUZZ_SOLVE_MASS,
+    MUZZ_SOLVE_VELOCITY,
+    MUZZ_SOLVE_ENERGY,
+    MUZZ_SOLVE_TKOF,
+    MUZZ_SOLVE_TKOF_MASS,       //  Mass for a TKOF, given velocity, diameter
+    MUZZ_SOLVE_TKOF_VELOCITY    //  Velocity for a TKOF, given mass, diameter
+};
+
+
+/*  Which constant (K) to use */
+enum muzz_k_mode {
+    MUZZ_K_INDUSTRY,        //  450240 (Imperial), 1000 (Si) (default)
+    MUZZ_K_GAC1,            //  2 * 32.163 * 7000, 'industry' gravity constant
+    MUZZ_K_GAC2,            //  2 * 32.1739 * 7000, standard gravity constant
+    MUZZ_K_CUSTOM           //  Whatever's in customK
+};
+
+
+/*  Gravitational acceleration constants (feet), used to calculate K */
+#define MUZZ_GRAVITY_IMPERIAL_APPROX    32.163
+#define MUZZ_GRAVITY_IMPERIAL           32.1739
+
+
+/*  The calculation context; see muzz_ctx_init() for the defaults */
+typedef struct muzz_ctx {
+    int si;                 //  Si units of measure instead of Imperial
+    int verbose;            //  Print units and inputs along with the result
+    int precise;            //  Do not round numbers
+    int fast;               //  Plans may use the fast kernels (if they pass)
+    int solve;              //  One of enum muzz_solve
+    int kMode;              //  One of enum muzz_k_mode
+    double customK;         //  Constant used with MUZZ_K_CUSTOM
+
+    double k;               //  Resolved constant; set by muzz_ctx_resolve()
+} muzz_ctx;
+
+
+/*  One shot:  the inputs and whatever's been solved for */
+typedef struct muzz_shot {
+    double mass;
+    double velocity;
+    double energy;
+    double diameter;
+    double tkof;
+} muzz_shot;
+
+
+/*  Sets up a context with the defaults (Imperial, verbose, energy, K=450240) */
+void muzz_ctx_init( muzz_ctx *ctx );
+
+/*  Works out ctx->k from the units and K mode; call after changing either */
+void muzz_ctx_resolve( muzz_ctx *ctx );
+
+
+/*  The formulas.  These only read the context. */
+double muzz_get_energy( const muzz_ctx *ctx, double mass, double velocity );
+double muzz_get_mass( const muzz_ctx *ctx, double velocity, double energy );
+double muzz_get_velocity( const muzz_ctx *ctx, double mass, double energy );
+double muzz_tkof( const muzz_ctx *ctx, double mass, double velocity,
+        double diameter );
+
+/*  The Taylor Knockout Formula backwards:  what it takes to reach a TKOF */
+double muzz_tkof_mass( const muzz_ctx *ctx, double velocity, double diameter,
+        double tkof );
+double muzz_tkof_velocity( const muzz_ctx *ctx, double mass, double diameter,
+        double tkof );
+
+
+/*
+ *  Array versions of the formulas, over columns of n numbers.  These use the
+ *  best SIMD instructions the CPU has and give exactly the same results as
+ *  the functions above.  The output may be the same array as an input.
+ */
+void muzz_get_energy_n( const muzz_ctx *ctx, const double *mass,
+        const double *velocity, double *energy, size_t n );
+void muzz_get_mass_n( const muzz_ctx *ctx, const double *velocity,
+        const double *energy, double *mass, size_t n );
+void muzz_get_velocity_n( const muzz_ctx *ctx, const double *mass,
+        const double *energy, double *velocity, size_t n );
+void muzz_tkof_n( const muzz_ctx *ctx, const double *mass,
+        const double *velocity, const double *diameter, double *ko, size_t n );
+void muzz_tkof_mass_n( const muzz_ctx *ctx, const double *velocity,
+        const double *diameter, const double *ko, double *mass, size_t n );
+void muzz_tkof_velocity_n( const muzz_ctx *ctx, const double *mass,
+        const double *diameter, const double *ko, double *velocity,
+        size_t n );
+
+/*  Name of the instruction set the array functions use ("avx2", etc.) */
+const char *muzz_kernel_isa( void );
+
+
+/*  Standard drag models, for the BC a bullet's maker publishes against */
+enum muzz_drag {
+    MUZZ_DRAG_G1,           //  Flat base; most published BCs (default)
+    MUZZ_DRAG_G7            //  Boat tail, long ogive; long-range bullets
+};
+
+/*
+ *  Velocity left after flying a distance (yards, or meters with Si units),
+ *  given the muzzle velocity and the ballistic coefficient (lb/in^2, either
+ *  way) against a drag model.  Flat fire, ICAO atmosphere at sea level.  The
+ *  velocity feeds the formulas above for energy or TKOF downrange.  NAN if
+ *  the velocity or BC isn't positive.
+ */
+double muzz_downrange( const muzz_ctx *ctx, int drag, double bc,
+        double velocity, double distance );
+void muzz_downrange_n( const muzz_ctx *ctx, int drag, const double *bc,
+        const double *velocity, const double *distance, double *out,
+        size_t n );
+
+
+/*
+ *  A kernel:  constant (or TKOF divisor), up to three input columns in the
+ *  order they're given on the command line, output column, count.
+ */
+typedef void (*muzz_kernel_fn)( double k, const double *a, const double *b,
+        const double *c, double *out, size_t n );
+
+/*
+ *  A compute plan:  everything in a context boiled down to one kernel with no
+ *  decisions left in it.  Make one with muzz_plan_init() after resolving the
+ *  context, then hand whole chunks of records to muzz_plan_run().
+ */
+typedef struct muzz_plan {
+    muzz_kernel_fn kernel;
+    double k;
+    const char *name;       //  e.g. "energy-imperial"
+    const char *isa;        //  e.g. "avx2"
+} muzz_plan;
+
+void muzz_plan_init( muzz_plan *plan, const muzz_ctx *ctx );
+void muzz_plan_run( const muzz_plan *plan, const double *a, const double *b,
+        const double *c, double *out, size_t n );
+
+
+/*
+ *  The fast kernels skip the divisions and square roots, so they can be a few
+ *  ULP off the reference.  muzz_fast_check() runs them next to it over a
+ *  sample of realistic shots (1-1000 gr, 100-5000 ft/s, 0.1-1 in, or 0.065-65
+ *  g, 30-1500 m/s, 2.5-25 mm) and a plan only uses them if the context sets
+ *  'fast' and they never land further off than MUZZ_FAST_MAX_ERROR, a
+ *  hundredth of the last decimal place '-p' prints.
+ */
+#define MUZZ_FAST_MAX_ERROR 1e-4
+
+typedef struct muzz_accuracy {
+    const char *name;       //  Plan checked, e.g. "energy-imperial"
+    const char *isa;        //  Fast kernels checked, e.g. "avx2-fast"
+    size_t samples;
+    double maxUlp;          //  Worst error in units in the last place
+    double maxRel;          //  Worst relative error
+    double maxAbs;          //  Worst error in the result's own units
+    int allowed;            //  Whether plans may use them
+} muzz_accuracy;
+
+int muzz_fast_check( const muzz_ctx *ctx, size_t samples, muzz_accuracy *acc );
+
+
+/*
+ *  Reads a plain decimal number ("230", "-.45", "1.5e3") from exactly len
+ *  characters, no terminator needed.  Returns 0, or -1 if it isn't one.  The
+ *  result is always the same as strtod()'s.
+ */
+int muzz_parse_double( const char *p, size_t len, double *out );
+
+
+/*  How many numbers a record needs for the context's solve mode (2 or 3) */
+int muzz_inputs( const muzz_ctx *ctx );
+
+/*  Whether the context's solve mode is one of the Taylor Knockout Formula's */
+int muzz_knockout( const muzz_ctx *ctx );
+
+/*
+ *  Fills in a shot's inputs from the numbers as they'd be given on the command
+ *  line (e.g. VELOCITY ENERGY when solving for mass); everything else is -1.
+ *  muzz_shot_set() then solves for the rest, as does muzz_solve().
+ */
+void muzz_shot_inputs( const muzz_ctx *ctx, muzz_shot *shot,
+        const double *nums );
+void muzz_shot_set( const muzz_ctx *ctx, muzz_shot *shot, const double *nums );
+void muzz_solve( const muzz_ctx *ctx, muzz_shot *shot );
+
+/*  The member of a shot the context solves for, e.g. &shot->energy */
+double *muzz_shot_wanted( const muzz_ctx *ctx, muzz_shot *shot );
+
+/*
+ *  Writes the result line the muzz program would print for a shot, newline
+ *  included, into buf.  Returns what snprintf would.  A buffer of
+ *  MUZZ_FORMAT_MAX bytes always has room for the whole line.
+ */
+#define MUZZ_FORMAT_MAX 1536
+
+int muzz_format( const muzz_ctx *ctx, const muzz_shot *shot,
+        char *buf, size_t size );
+
+#endif
@@ -0,0 +1,185 @@
+/*******************************************************************************
+ *  parse.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Turning text into numbers, for the command line and for batch records.
+ *
+ *  atof() can't tell us when it's been handed garbage (it just says 0), and
+ *  strtod() wants a terminated string and checks the locale for every call.
+ *  This works straight off a pointer and a length, accepts plain decimal
+ *  numbers only ("230", "-.45", "1.5e3"), and says so when it gets anything
+ *  else.
+ *
+ *  Most numbers people actually type have few enough digits that the answer
+ *  can be worked out exactly with one multiply or divide by a power of ten
+ *  (Clinger's fast path).  Anything longer or bigger than that goes to
+ *  strtod(), so the result is always the same as strtod() would give.
+ *
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "muzz.h"
+
+
+/*  Most significant digits we'll keep in a 64 bit mantissa */
+#define MAX_DIGITS 19
+
+/*  Fields shorter than this get copied to the stack for strtod() */
+#define FALLBACK_BUF 64
+
+
+/*  Every power of ten a double holds exactly */
+static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_POWER 22
+
+
+
+/*==============================================================================
+                                 SLOW PARSE
+--------------------------------------------------------------------------------
+*   Hands a field we've already checked over to strtod(), which needs it
+*   terminated.  Returns 0, or -1 if we're out of memory.
+*/
+static int slow_parse( const char *p, size_t len, double *out )
+{
+    char buf[ FALLBACK_BUF ];
+    char *copy = buf;
+
+    if( len >= sizeof( buf ))
+    {
+        copy = malloc( len + 1 );
+        if( copy == NULL )
+            return( -1 );
+    }
+
+    memcpy( copy, p, len );
+    copy[ len ] = '\0';
+    *out = strtod( copy, NULL );
+
+    if( copy != buf )
+        free( copy );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  PARSE DOUBLE
+--------------------------------------------------------------------------------
+*   Reads a decimal number:  an optional sign, digits with an optional decimal
+*   point (at least one digit in all), and an optional exponent.  The whole
+*   span has to be the number.  Returns 0 and sets *out, or -1 if the text
+*   isn't a number.
+*
+*   Params
+*       const char *p   |   Start of the text
+*       size_t len      |   Length of the text
+*       double *out     |   Where to put the number
+*/
+int muzz_parse_double( const char *p, size_t len, double *out )
+{
+    const char *start = p;
+    const char *end = p + len;
+    uint64_t mantissa = 0;
+    int digits = 0;         //  Significant digits in mantissa
+    int seen = 0;           //  Any digits at all
+    int dropped = 0;        //  Significant digits that didn't fit
+    long exponent = 0;
+    long expPart = 0;
+    int negative = 0;
+    int expNegative = 0;
+    double value;
+
+    if( p < end && ( *p == '+' || *p == '-' ))
+        negative = ( *p++ == '-' );
+
+    /*  Whole part */
+    for( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+        seen = 1;
+        if( mantissa == 0 && *p == '0' )
+            continue;
+
+        if( digits < MAX_DIGITS )
+        {
+            mantissa = mantissa * 10 + ( *p - '0' );
+            ++digits;
+        }
+        else
+        {
+            ++dropped;
+            ++exponent;
+        }
+    }
+
+    /*  Fraction */
+    if( p < end && *p == '.' )
+    {
+        for( ++p; p < end && *p >= '0' && *p <= '9'; ++p )
+        {
+            seen = 1;
+            if( mantissa == 0 && *p == '0' )
+            {
+                --exponent;
+                continue;
+            }
+
+            if( digits < MAX_DIGITS )
+            {
+                mantissa = mantissa * 10 + ( *p - '0' );
+                ++digits;
+                --exponent;
+            }
+            else
+                ++dropped;
+        }
+    }
+
+    if( ! seen )
+        return( -1 );
+
+    /*  Exponent */
+    if( p < end && ( *p == 'e' || *p == 'E' ))
+    {
+        ++p;
+        if( p < end && ( *p == '+' || *p == '-' ))
+            expNegative = ( *p++ == '-' );
+
+        if( p == end || *p < '0' || *p > '9' )
+            return( -1 );
+
+        for( ; p < end && *p >= '0' && *p <= '9'; ++p )
+            if( expPart < 100000 )
+                expPart = expPart * 10 + ( *p - '0' );
+
+        exponent += ( expNegative ? -expPart : expPart );
+    }
+
+    /*  Anything left over means it wasn't (just) a number */
+    if( p != end )
+        return( -1 );
+
+    /*  Fast path:  mantissa and power of ten are both exact doubles */
+    if( dropped == 0 && mantissa <= ( (uint64_t)1 << 53 )
+            && exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER )
+    {
+        value = (double)mantissa;
+        if( exponent < 0 )
+            value /= powersOfTen[ -exponent ];
+        else
+            value *= powersOfTen[ exponent ];
+
+        *out = ( negative ? -value : value );
+        return( 0 );
+    }
+
+    return( slow_parse( start, len, out ));
+}
@@ -0,0 +1,255 @@
+/*******************************************************************************
+ *  partial.c   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The partial file format.  A partial is the 8 characters MUZZPRT1, then
+ *  the head (see partial.h) as 64 bit numbers, then whatever the shard
+ *  added up:  a summary (summary_save()) or a top-K (topk_save()).  Every
+ *  number is 64 bits and little-endian, so a partial written on one machine
+ *  reads the same on any other, and doubles are kept bit for bit.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "muzz.h"
+#include "batch.h"
+#include "partial.h"
+
+
+/*  Numbers in a head, after the magic */
+#define HEAD_FIELDS 19
+
+
+
+/*==============================================================================
+                                     MIX64
+--------------------------------------------------------------------------------
+*   Scrambles a 64 bit number (the splitmix64 finalizer).
+*/
+static inline uint64_t mix64( uint64_t x )
+{
+    x = ( x ^ ( x >> 30 )) * 0xbf58476d1ce4e5b9ull;
+    x = ( x ^ ( x >> 27 )) * 0x94d049bb133111ebull;
+    return( x ^ ( x >> 31 ));
+}
+
+
+
+/*==============================================================================
+                                    PUT U64
+--------------------------------------------------------------------------------
+*/
+int partial_put_u64( FILE *fp, uint64_t x )
+{
+    unsigned char b[ 8 ];
+    int i;
+
+    for( i = 0; i < 8; ++i )
+        b[i] = (unsigned char)( x >> ( 8 * i ));
+
+    return( fwrite( b, 1, 8, fp ) == 8 ? 0 : -1 );
+}
+
+
+
+/*==============================================================================
+                                    PUT F64
+--------------------------------------------------------------------------------
+*/
+int partial_put_f64( FILE *fp, double x )
+{
+    uint64_t bits;
+
+    memcpy( &bits, &x, sizeof( bits ));
+    return( partial_put_u64( fp, bits ));
+}
+
+
+
+/*==============================================================================
+                                    GET U64
+--------------------------------------------------------------------------------
+*/
+int partial_get_u64( FILE *fp, uint64_t *x )
+{
+    unsigned char b[ 8 ];
+    int i;
+
+    if( fread( b, 1, 8, fp ) != 8 )
+        return( -1 );
+
+    *x = 0;
+    for( i = 0; i < 8; ++i )
+        *x |= (uint64_t)b[i] << ( 8 * i );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                    GET F64
+--------------------------------------------------------------------------------
+*/
+int partial_get_f64( FILE *fp, double *x )
+{
+    uint64_t bits;
+
+    if( partial_get_u64( fp, &bits ))
+        return( -1 );
+
+    memcpy( x, &bits, sizeof( bits ));
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   HEAD FIELDS
+--------------------------------------------------------------------------------
+*   The numbers of a head, in the order they're written.
+*/
+static void head_fields( partial_head *h, uint64_t **f )
+{
+    f[0] = &h->shard;       f[1] = &h->shards;      f[2] = &h->kind;
+    f[3] = &h->si;          f[4] = &h->solve;       f[5] = &h->kMode;
+    f[6] = &h->customK;
+    f[7] = &h->verbose;     f[8] = &h->precise;     f[9] = &h->fast;
+    f[10] = &h->summary;    f[11] = &h->group;      f[12] = &h->output;
+    f[13] = &h->downrange;  f[14] = &h->top;        f[15] = &h->topCol;
+    f[16] = &h->topLow;     f[17] = &h->numCols;    f[18] = &h->run;
+}
+
+
+
+/*==============================================================================
+                                    PUT HEAD
+--------------------------------------------------------------------------------
+*/
+int partial_put_head( FILE *fp, const partial_head *h )
+{
+    partial_head copy = *h;
+    uint64_t *f[ HEAD_FIELDS ];
+    int i;
+
+    if( fwrite( PARTIAL_MAGIC, 1, 8, fp ) != 8 )
+        return( -1 );
+
+    head_fields( &copy, f );
+    for( i = 0; i < HEAD_FIELDS; ++i )
+        if( partial_put_u64( fp, *f[i] ))
+            return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                    GET HEAD
+--------------------------------------------------------------------------------
+*/
+int partial_get_head( FILE *fp, partial_head *h )
+{
+    uint64_t *f[ HEAD_FIELDS ];
+    char magic[ 8 ];
+    int i;
+
+    if( fread( magic, 1, 8, fp ) != 8 || memcmp( magic, PARTIAL_MAGIC, 8 ))
+        return( -1 );
+
+    head_fields( h, f );
+    for( i = 0; i < HEAD_FIELDS; ++i )
+        if( partial_get_u64( fp, f[i] ))
+            return( -1 );
+
+    if( h->shards == 0 || h->shards > PARTIAL_SHARDS_MAX
+            || h->shard >= h->shards )
+        return( -1 );
+
+    /*  Everything that goes into a run has to make sense before it does:
+     *  known enums, 0 or 1 for a yes or no, and real columns */
+    if( h->si > 1 || h->verbose > 1 || h->precise > 1 || h->fast > 1
+            || h->group > 1 || h->downrange > 1 || h->topLow > 1
+            || h->solve > MUZZ_SOLVE_TKOF_VELOCITY
+            || h->kMode > MUZZ_K_CUSTOM
+            || h->summary > SUMMARY_JSON || h->output > BATCH_NDJSON
+            || h->topCol > BATCH_COLS || h->numCols > BATCH_COLS )
+        return( -1 );
+
+    /*  And what it holds has to be something there is */
+    if( h->kind == PARTIAL_TOP ? h->top == 0
+            : h->kind != PARTIAL_SUMMARY || h->summary == SUMMARY_OFF )
+        return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                    SAME RUN
+--------------------------------------------------------------------------------
+*/
+int partial_same_run( const partial_head *a, const partial_head *b )
+{
+    partial_head x = *a;
+    partial_head y = *b;
+
+    x.shard = y.shard = 0;
+    return( memcmp( &x, &y, sizeof( x )) == 0 );
+}
+
+
+
+/*==============================================================================
+                                   PRINT U64
+--------------------------------------------------------------------------------
+*   Each number is scrambled into what came before, so the order counts.
+*/
+uint64_t partial_print_u64( uint64_t print, uint64_t x )
+{
+    return( mix64( print ^ mix64( x + 0x9e3779b97f4a7c15ull )));
+}
+
+
+
+/*==============================================================================
+                                   PRINT F64
+--------------------------------------------------------------------------------
+*/
+uint64_t partial_print_f64( uint64_t print, double x )
+{
+    uint64_t bits;
+
+    memcpy( &bits, &x, sizeof( bits ));
+    return( partial_print_u64( print, bits ));
+}
+
+
+
+/*==============================================================================
+                                   PRINT STR
+--------------------------------------------------------------------------------
+*   Eight characters at a time (little-endian, as ever), then the length.
+*/
+uint64_t partial_print_str( uint64_t print, const char *str )
+{
+    size_t len = strlen( str );
+    uint64_t x;
+    size_t i;
+    size_t j;
+
+    for( i = 0; i < len; i += 8 )
+    {
+        x = 0;
+        for( j = 0; j < 8 && i + j < len; ++j )
+            x |= (uint64_t)(unsigned char)str[ i + j ] << ( 8 * j );
+        print = partial_print_u64( print, x );
+    }
+
+    return( partial_print_u64( print, len ));
+}
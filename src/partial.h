@@ -0,0 +1,91 @@
+/*******************************************************************************
+ *  partial.h   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Partial results, for '--shard' and 'muzz merge':  what one shard of a
+ *  run has added up (a summary or a top-K), written out exactly so that
+ *  the shards can be put back together somewhere else.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_PARTIAL_H
+#define MUZZ_PARTIAL_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+/*  What a partial file starts with */
+#define PARTIAL_MAGIC "MUZZPRT1"
+
+/*  Most shards a run can be split into */
+#define PARTIAL_SHARDS_MAX 4096
+
+
+/*  What a partial holds */
+enum PartialKind {
+    PARTIAL_SUMMARY = 1,
+    PARTIAL_TOP
+};
+
+
+/*
+ *  The head of a partial:  which shard it is, everything about the run it
+ *  takes to print the merged result, and a fingerprint of the rest of what
+ *  makes the run that run (its input, conditions and so on).  Every shard of
+ *  a run has the same head but for the shard number.
+ */
+typedef struct partial_head {
+    uint64_t shard;
+    uint64_t shards;
+    uint64_t kind;          //  enum PartialKind
+
+    uint64_t si;            //  The muzz_ctx ...
+    uint64_t solve;
+    uint64_t kMode;
+    uint64_t customK;       //  Its bits
+    uint64_t verbose;
+    uint64_t precise;
+    uint64_t fast;
+
+    uint64_t summary;       //  ... and the batch_opts
+    uint64_t group;
+    uint64_t output;
+    uint64_t downrange;     //  1 with '--drag'
+    uint64_t top;
+    uint64_t topCol;        //  Plus one, so -1 (the answer) is 0
+    uint64_t topLow;
+    uint64_t numCols;       //  Of the summary
+
+    uint64_t run;           //  partial_print()s of the rest
+} partial_head;
+
+
+/*
+ *  Little-endian numbers, whatever the machine.  Each returns 0, or -1 if
+ *  it couldn't write or read all of it.
+ */
+int partial_put_u64( FILE *fp, uint64_t x );
+int partial_put_f64( FILE *fp, double x );
+int partial_get_u64( FILE *fp, uint64_t *x );
+int partial_get_f64( FILE *fp, double *x );
+
+/*  The head, magic and all.  0, or -1. */
+int partial_put_head( FILE *fp, const partial_head *h );
+
+/*  Reads a head.  0, or -1 if it isn't a partial or is cut short. */
+int partial_get_head( FILE *fp, partial_head *h );
+
+/*  Whether two heads are from the same run (shard number aside) */
+int partial_same_run( const partial_head *a, const partial_head *b );
+
+/*
+ *  Adds a number (or a double's bits, or a string) to a fingerprint that
+ *  starts at 0, and returns the new one.  The same things in the same order
+ *  give the same fingerprint on any machine.
+ */
+uint64_t partial_print_u64( uint64_t print, uint64_t x );
+uint64_t partial_print_f64( uint64_t print, double x );
+uint64_t partial_print_str( uint64_t print, const char *str );
+
+#endif
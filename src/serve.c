@@ -0,0 +1,812 @@
+/*******************************************************************************
+ *  serve.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Server mode.  Rather than start a new muzz for every calculation, a client
+ *  connects once and sends requests, one per line, and gets one line back for
+ *  each, in order.  A request looks just like the command line would:
+ *
+ *      -qs 15 270
+ *      230 900
+ *      -t 230 860 .45
+ *
+ *  Options apply to that request only, on top of whatever the server was
+ *  started with.  Fields can be separated by spaces, tabs, commas or
+ *  semicolons; blank lines and lines starting with '#' get no answer.  A bad
+ *  request gets a line starting with "ERROR:" and the connection carries on.
+ *
+ *  Everything runs on one thread around an epoll loop, so an idle client
+ *  costs a file descriptor and a small buffer, and nothing more.  Answers go
+ *  into a per-client output buffer; when a client stops reading and that
+ *  fills up, we stop reading its requests until it catches up.  Closed
+ *  connections are kept, output buffer and all, for the next client, so a
+ *  server with steady traffic stops going to the heap.
+ *
+ *  With '--cache', answers are kept, formatted, by the request's numbers and
+ *  options (see cache.c), and a request that's been answered before is
+ *  answered by copying the line:  no calculating and no formatting.  There's
+ *  only the one thread, so the cache is read and written without locks.
+ *
+ *  With '--stats', requests and bytes (and the cache's hits and misses) are
+ *  counted until the server's stopped, then printed like a batch's.
+ *
+ ******************************************************************************/
+#define _GNU_SOURCE     //  accept4()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "muzz.h"
+#include "serve.h"
+#include "arena.h"
+#include "cache.h"
+#include "stats.h"
+
+
+/*  Characters that may separate fields of a request:  " \t,;\r" */
+static const unsigned char delims[ 256 ] = {
+    [' '] = 1, ['\t'] = 1, [','] = 1, [';'] = 1, ['\r'] = 1
+};
+
+#define is_delim( c ) ( delims[ (unsigned char)(c) ] )
+
+/*  Longest request line we'll take */
+#define SERVE_LINE_MAX 4096
+
+/*  Unsent output at which we stop reading a client's requests */
+#define SERVE_OUT_MAX ( 256 * 1024 )
+
+/*  Events we handle per epoll_wait() */
+#define SERVE_EVENTS 256
+
+/*  Connections waiting to be accepted */
+#define SERVE_BACKLOG 1024
+
+/*  Closed connections we keep for reuse */
+#define SERVE_SPARES 64
+
+
+/*  One client */
+typedef struct serve_conn {
+    int fd;
+    unsigned int events;        //  What we've asked epoll for
+
+    char in[ SERVE_LINE_MAX ];  //  Request text we haven't handled yet
+    size_t inLen;
+
+    char *out;                  //  Answers we haven't sent yet
+    size_t outPos;
+    size_t outLen;
+    size_t outCap;
+
+    int closing;                //  Close once the output's gone
+
+    struct serve_conn *next;    //  Next spare
+} serve_conn;
+
+
+/*  Set by the signal handler to stop the loop */
+static volatile sig_atomic_t stopping;
+
+/*  Closed connections, ready for new clients */
+static serve_conn *spares;
+static int numSpares;
+
+/*  '--cache' and '--stats', or NULL */
+static result_cache *cache;
+static run_stats *stats;
+
+
+
+/*==============================================================================
+                                   ON SIGNAL
+--------------------------------------------------------------------------------
+*/
+static void on_signal( int sig )
+{
+    (void)sig;
+    stopping = 1;
+}
+
+
+
+/*==============================================================================
+                                     REPLY
+--------------------------------------------------------------------------------
+*   Adds text to a client's output.  Returns 0, or -1 if we're out of memory.
+*/
+static int reply( serve_conn *c, const char *text, size_t len )
+{
+    if( c->outLen + len > c->outCap )
+    {
+        size_t cap = ( c->outCap ? c->outCap : 4096 );
+        char *out;
+
+        while( cap < c->outLen + len )
+            cap *= 2;
+
+        out = heap_realloc( c->out, cap );
+        if( out == NULL )
+            return( -1 );
+
+        c->out = out;
+        c->outCap = cap;
+    }
+
+    memcpy( c->out + c->outLen, text, len );
+    c->outLen += len;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  REPLY ERROR
+--------------------------------------------------------------------------------
+*   Adds an error line to a client's output:  "ERROR:  what[:  field]".
+*/
+static int reply_error( serve_conn *c, const char *what, const char *field,
+        size_t fieldLen )
+{
+    char line[ 128 ];
+    int len;
+
+    if( stats != NULL )
+        ++stats->rejected;
+
+    if( field == NULL )
+        len = snprintf( line, sizeof( line ), "ERROR:  %s\n", what );
+    else
+        len = snprintf( line, sizeof( line ), "ERROR:  %s:  %.*s\n", what,
+                (int)( fieldLen > 64 ? 64 : fieldLen ), field );
+
+    return( reply( c, line, len ));
+}
+
+
+
+/*==============================================================================
+                                 HANDLE REQUEST
+--------------------------------------------------------------------------------
+*   Answers one request line, which has options (same letters as the command
+*   line) followed by the numbers.  Returns 0, or -1 if we're out of memory.
+*
+*   Params
+*       muzz_ctx *base  |   The server's options
+*       serve_conn *c   |   Who asked
+*       const char *p   |   The request, without its newline
+*       const char *end |   End of the request
+*/
+static int handle_request( const muzz_ctx *base, serve_conn *c,
+        const char *p, const char *end )
+{
+    muzz_ctx ctx = *base;
+    int useTkof = muzz_knockout( base );
+    int valueWanted = base->solve;
+    int wantK = 0;          //  Next field is the value for '-k'
+    double nums[ 3 ];
+    int count = 0;
+    muzz_shot shot;
+    char line[ MUZZ_FORMAT_MAX ];
+    const char *field;
+    const char *opt;
+    cache_key key;
+    cache_entry *e;
+    int len;
+
+    /*  What -m, -v or -e would have said, for the knockout formula too */
+    if( base->solve == MUZZ_SOLVE_TKOF )
+        valueWanted = MUZZ_SOLVE_ENERGY;
+    else if( base->solve == MUZZ_SOLVE_TKOF_MASS )
+        valueWanted = MUZZ_SOLVE_MASS;
+    else if( base->solve == MUZZ_SOLVE_TKOF_VELOCITY )
+        valueWanted = MUZZ_SOLVE_VELOCITY;
+
+    while( p < end && is_delim( *p ))
+        ++p;
+
+    /*  Nothing asked, nothing to answer */
+    if( p == end || *p == '#' )
+        return( 0 );
+
+    while( p < end )
+    {
+        field = p;
+        while( p < end && ! is_delim( *p ))
+            ++p;
+
+        /*  The constant, after a '-k' */
+        if( wantK )
+        {
+            if( muzz_parse_double( field, p - field, &ctx.customK ))
+                return( reply_error( c, "Not a number", field, p - field ));
+            wantK = 0;
+        }
+
+        /*  Options; a '-' followed by a number is just a negative number */
+        else if( count == 0 && field[0] == '-' && p - field > 1
+                && ( field[1] < '0' || field[1] > '9' ) && field[1] != '.' )
+        {
+            for( opt = field + 1; opt < p; ++opt )
+            {
+                switch( *opt )
+                {
+                    case 'S':
+                    case 'q':   ctx.verbose = 0;                    break;
+                    case 's':   ctx.si = 1;                         break;
+                    case 'i':   ctx.si = 0;                         break;
+                    case 'm':   valueWanted = MUZZ_SOLVE_MASS;      break;
+                    case 'v':   valueWanted = MUZZ_SOLVE_VELOCITY;  break;
+                    case 'e':   valueWanted = MUZZ_SOLVE_ENERGY;    break;
+                    case 'c':   ctx.kMode = MUZZ_K_GAC1;            break;
+                    case 'C':   ctx.kMode = MUZZ_K_GAC2;            break;
+                    case 'K':   ctx.kMode = MUZZ_K_INDUSTRY;        break;
+                    case 'p':   ctx.precise = 1;                    break;
+                    case 't':   useTkof = 1;                        break;
+
+                    case 'k':   //  Constant is the rest, or the next field
+                        ctx.kMode = MUZZ_K_CUSTOM;
+                        if( opt + 1 == p )
+                            wantK = 1;
+                        else if( muzz_parse_double( opt + 1, p - opt - 1,
+                                    &ctx.customK ))
+                            return( reply_error( c, "Not a number", opt + 1,
+                                        p - opt - 1 ));
+                        opt = p - 1;
+                        break;
+
+                    default:
+                        return( reply_error( c, "Unknown option", field,
+                                    p - field ));
+                }
+            }
+        }
+
+        /*  The numbers; any beyond what we need are ignored */
+        else if( count < 3 )
+        {
+            if( muzz_parse_double( field, p - field, &nums[ count++ ] ))
+                return( reply_error( c, "Not a number", field, p - field ));
+        }
+
+        while( p < end && is_delim( *p ))
+            ++p;
+    }
+
+    if( wantK )
+        return( reply_error( c, "Missing constant", NULL, 0 ));
+
+    if( useTkof && valueWanted == MUZZ_SOLVE_MASS )
+        ctx.solve = MUZZ_SOLVE_TKOF_MASS;
+    else if( useTkof && valueWanted == MUZZ_SOLVE_VELOCITY )
+        ctx.solve = MUZZ_SOLVE_TKOF_VELOCITY;
+    else
+        ctx.solve = ( useTkof ? MUZZ_SOLVE_TKOF : valueWanted );
+    muzz_ctx_resolve( &ctx );
+
+    if( count < muzz_inputs( &ctx ))
+    {
+        snprintf( line, sizeof( line ), "Need %d parameters",
+                muzz_inputs( &ctx ));
+        return( reply_error( c, line, NULL, 0 ));
+    }
+
+    if( stats != NULL )
+        ++stats->records;
+
+    /*  Asked before, so it's already been said */
+    if( cache != NULL )
+    {
+        cache_key_set( &key, &ctx, nums );
+        if( ( e = cache_find( cache, &key )) != NULL )
+        {
+            if( stats != NULL )
+                ++stats->cacheHits;
+            return( reply( c, e->text, e->len ));
+        }
+
+        if( stats != NULL )
+            ++stats->cacheMisses;
+    }
+
+    muzz_shot_set( &ctx, &shot, nums );
+    len = muzz_format( &ctx, &shot, line, sizeof( line ));
+
+    if( cache != NULL )
+        cache_put( cache, &key, *muzz_shot_wanted( &ctx, &shot ), line, len );
+
+    return( reply( c, line, len ));
+}
+
+
+
+/*==============================================================================
+                                   READ CONN
+--------------------------------------------------------------------------------
+*   Reads what a client has sent and answers every whole line of it.  Returns
+*   0, or -1 if the client's gone or we can't keep it.
+*/
+static int read_conn( const muzz_ctx *ctx, serve_conn *c )
+{
+    ssize_t got;
+    char *p;
+    char *nl;
+    char *end;
+
+    got = read( c->fd, c->in + c->inLen, sizeof( c->in ) - c->inLen );
+    if( got < 0 && ( errno == EAGAIN || errno == EINTR ))
+        return( 0 );
+
+    if( got > 0 && stats != NULL )
+        stats->bytesIn += got;
+
+    /*  Hung up (or broke); still answer a last line with no newline */
+    if( got <= 0 )
+    {
+        if( got == 0 && c->inLen > 0
+                && handle_request( ctx, c, c->in, c->in + c->inLen ))
+            return( -1 );
+
+        c->inLen = 0;
+        c->closing = 1;
+        return( got == 0 ? 0 : -1 );
+    }
+
+    c->inLen += got;
+    p = c->in;
+    end = c->in + c->inLen;
+
+    while( ( nl = memchr( p, '\n', end - p )) != NULL )
+    {
+        if( handle_request( ctx, c, p, nl ))
+            return( -1 );
+        p = nl + 1;
+    }
+
+    c->inLen = end - p;
+    memmove( c->in, p, c->inLen );
+
+    /*  A whole buffer and no end of line; that's not a request */
+    if( c->inLen == sizeof( c->in ))
+    {
+        c->inLen = 0;
+        c->closing = 1;
+        return( reply_error( c, "Request too long", NULL, 0 ));
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   WRITE CONN
+--------------------------------------------------------------------------------
+*   Sends as much of a client's output as it'll take.  Returns 0, or -1 if the
+*   client's gone.
+*/
+static int write_conn( serve_conn *c )
+{
+    ssize_t sent;
+
+    while( c->outPos < c->outLen )
+    {
+        sent = send( c->fd, c->out + c->outPos, c->outLen - c->outPos,
+                MSG_NOSIGNAL );
+
+        if( sent < 0 && errno == EINTR )
+            continue;
+
+        if( sent < 0 && errno == EAGAIN )
+            return( 0 );
+
+        if( sent <= 0 )
+            return( -1 );
+
+        if( stats != NULL )
+            stats->bytesOut += sent;
+        c->outPos += sent;
+    }
+
+    c->outPos = c->outLen = 0;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  UPDATE CONN
+--------------------------------------------------------------------------------
+*   Asks epoll for whatever the client's waiting on:  input, unless it has too
+*   much unsent output already, and room to write, if it has any.  Returns 1
+*   if it's done with and should be closed, 0 otherwise.
+*/
+static int update_conn( int epfd, serve_conn *c )
+{
+    struct epoll_event ev;
+    size_t pending = c->outLen - c->outPos;
+
+    if( c->closing && pending == 0 )
+        return( 1 );
+
+    ev.events = 0;
+    if( ! c->closing && pending < SERVE_OUT_MAX )
+        ev.events |= EPOLLIN;
+    if( pending > 0 )
+        ev.events |= EPOLLOUT;
+
+    if( ev.events != c->events )
+    {
+        ev.data.ptr = c;
+        if( epoll_ctl( epfd, EPOLL_CTL_MOD, c->fd, &ev ))
+            return( 1 );
+        c->events = ev.events;
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   DROP CONN
+--------------------------------------------------------------------------------
+*   Gives up on a client:  whatever it's still owed is thrown away.
+*/
+static void drop_conn( serve_conn *c )
+{
+    c->closing = 1;
+    c->outPos = c->outLen = 0;
+}
+
+
+
+/*==============================================================================
+                                    NEW CONN
+--------------------------------------------------------------------------------
+*   A connection for a new client:  a spare if we have one, output buffer and
+*   all.  NULL if we're out of memory.
+*/
+static serve_conn *new_conn( int fd )
+{
+    serve_conn *c = spares;
+
+    if( c != NULL )
+    {
+        spares = c->next;
+        --numSpares;
+    }
+    else
+    {
+        c = heap_alloc( sizeof( *c ));
+        if( c == NULL )
+            return( NULL );
+
+        c->out = NULL;
+        c->outCap = 0;
+    }
+
+    c->fd = fd;
+    c->events = EPOLLIN;
+    c->inLen = 0;
+    c->outPos = c->outLen = 0;
+    c->closing = 0;
+    c->next = NULL;
+    return( c );
+}
+
+
+
+/*==============================================================================
+                                   CLOSE CONN
+--------------------------------------------------------------------------------
+*   Closes a client's socket, and keeps the connection as a spare unless we
+*   have plenty already.
+*/
+static void close_conn( serve_conn *c )
+{
+    close( c->fd );
+
+    if( numSpares >= SERVE_SPARES )
+    {
+        heap_free( c->out );
+        heap_free( c );
+        return;
+    }
+
+    c->next = spares;
+    spares = c;
+    ++numSpares;
+}
+
+
+
+/*==============================================================================
+                                  ACCEPT CONNS
+--------------------------------------------------------------------------------
+*   Takes every client waiting on the listening socket.
+*/
+static void accept_conns( int epfd, int listenFd )
+{
+    struct epoll_event ev;
+    serve_conn *c;
+    int fd;
+
+    for( ;; )
+    {
+        fd = accept4( listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC );
+        if( fd < 0 )
+        {
+            if( errno == EINTR || errno == ECONNABORTED )
+                continue;
+
+            /*  EAGAIN means that's all of them; anything else, try later */
+            if( errno != EAGAIN )
+                perror( "muzz: accept" );
+            return;
+        }
+
+        c = new_conn( fd );
+        if( c == NULL )
+        {
+            close( fd );
+            continue;
+        }
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+
+        if( epoll_ctl( epfd, EPOLL_CTL_ADD, fd, &ev ))
+            close_conn( c );
+    }
+}
+
+
+
+/*==============================================================================
+                                  LISTEN UNIX
+--------------------------------------------------------------------------------
+*   Makes a listening Unix socket.  A stale socket in the way is removed, but
+*   nothing else is.  Returns the socket, or -1.
+*/
+static int listen_unix( const char *path )
+{
+    struct sockaddr_un sun;
+    struct stat st;
+    int fd;
+
+    if( strlen( path ) >= sizeof( sun.sun_path ))
+    {
+        fprintf( stderr, "ERROR:  Socket path too long:  %s\n", path );
+        return( -1 );
+    }
+
+    memset( &sun, 0, sizeof( sun ));
+    sun.sun_family = AF_UNIX;
+    strcpy( sun.sun_path, path );
+
+    if( stat( path, &st ) == 0 && S_ISSOCK( st.st_mode ))
+        unlink( path );
+
+    fd = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if( fd < 0 || bind( fd, (struct sockaddr *)&sun, sizeof( sun ))
+            || listen( fd, SERVE_BACKLOG ))
+    {
+        fprintf( stderr, "ERROR:  Could not listen on %s:  %s\n", path,
+                strerror( errno ));
+        if( fd >= 0 )
+            close( fd );
+        return( -1 );
+    }
+
+    return( fd );
+}
+
+
+
+/*==============================================================================
+                                   LISTEN TCP
+--------------------------------------------------------------------------------
+*   Makes a listening TCP socket from "[HOST:]PORT" (HOST can be bracketed,
+*   for IPv6).  No host means every address.  Returns the socket, or -1.
+*/
+static int listen_tcp( const char *addr )
+{
+    struct addrinfo hints;
+    struct addrinfo *res;
+    struct addrinfo *ai;
+    char host[ 256 ];
+    const char *port = addr;
+    const char *colon = strrchr( addr, ':' );
+    size_t hostLen;
+    int fd = -1;
+    int one = 1;
+    int err;
+
+    host[0] = '\0';
+    if( colon != NULL )
+    {
+        hostLen = colon - addr;
+        if( hostLen >= 2 && addr[0] == '[' && addr[ hostLen - 1 ] == ']' )
+        {
+            ++addr;
+            hostLen -= 2;
+        }
+
+        if( hostLen >= sizeof( host ))
+            hostLen = sizeof( host ) - 1;
+
+        memcpy( host, addr, hostLen );
+        host[ hostLen ] = '\0';
+        port = colon + 1;
+    }
+
+    memset( &hints, 0, sizeof( hints ));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    err = getaddrinfo( ( host[0] && strcmp( host, "*" ) ? host : NULL ), port,
+            &hints, &res );
+    if( err )
+    {
+        fprintf( stderr, "ERROR:  Bad address %s:  %s\n", port,
+                gai_strerror( err ));
+        return( -1 );
+    }
+
+    for( ai = res; ai != NULL; ai = ai->ai_next )
+    {
+        fd = socket( ai->ai_family,
+                ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                ai->ai_protocol );
+        if( fd < 0 )
+            continue;
+
+        setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ));
+        if( bind( fd, ai->ai_addr, ai->ai_addrlen ) == 0
+                && listen( fd, SERVE_BACKLOG ) == 0 )
+            break;
+
+        close( fd );
+        fd = -1;
+    }
+
+    if( fd < 0 )
+        fprintf( stderr, "ERROR:  Could not listen on %s:  %s\n", port,
+                strerror( errno ));
+
+    freeaddrinfo( res );
+    return( fd );
+}
+
+
+
+/*==============================================================================
+                                   SERVE RUN
+--------------------------------------------------------------------------------
+*   Listens for clients and answers their requests until we get SIGINT or
+*   SIGTERM.  Returns 0 once stopped, or 1 if something went wrong.
+*
+*   Params
+*       const char *addr    |   Unix socket path, or TCP [HOST:]PORT
+*       muzz_ctx *ctx       |   Options every request starts from
+*       size_t cacheSize    |   Answers to keep, or 0 for none
+*       run_stats *counts   |   Where to count, or NULL
+*/
+int serve_run( const char *addr, const muzz_ctx *ctx, size_t cacheSize,
+        run_stats *counts )
+{
+    result_cache table;
+    arena mem;
+    struct epoll_event events[ SERVE_EVENTS ];
+    struct epoll_event ev;
+    struct sigaction sa;
+    const char *path = NULL;
+    serve_conn *c;
+    int listenFd;
+    int epfd;
+    int status = 0;
+    int n;
+    int i;
+
+    /*  Unix socket, or TCP? */
+    if( strncmp( addr, "unix:", 5 ) == 0 )
+        path = addr + 5;
+    else if( strchr( addr, '/' ) != NULL )
+        path = addr;
+
+    stats = counts;
+    arena_init( &mem );
+    if( cacheSize > 0 )
+    {
+        if( cache_init( &table, cacheSize, &mem ))
+        {
+            fprintf( stderr, "ERROR:  Out of memory for the cache\n" );
+            return( 1 );
+        }
+        cache = &table;
+    }
+
+    listenFd = ( path != NULL ? listen_unix( path ) : listen_tcp( addr ));
+    if( listenFd < 0 )
+    {
+        arena_free( &mem );
+        return( 1 );
+    }
+
+    epfd = epoll_create1( EPOLL_CLOEXEC );
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;     //  NULL is the listening socket
+    if( epfd < 0 || epoll_ctl( epfd, EPOLL_CTL_ADD, listenFd, &ev ))
+    {
+        perror( "muzz: epoll" );
+        close( listenFd );
+        arena_free( &mem );
+        return( 1 );
+    }
+
+    memset( &sa, 0, sizeof( sa ));
+    sa.sa_handler = on_signal;
+    sigemptyset( &sa.sa_mask );
+    sigaction( SIGINT, &sa, NULL );
+    sigaction( SIGTERM, &sa, NULL );
+
+    while( ! stopping )
+    {
+        n = epoll_wait( epfd, events, SERVE_EVENTS, -1 );
+        if( n < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+
+            perror( "muzz: epoll_wait" );
+            status = 1;
+            break;
+        }
+
+        for( i = 0; i < n; ++i )
+        {
+            c = events[i].data.ptr;
+            if( c == NULL )
+            {
+                accept_conns( epfd, listenFd );
+                continue;
+            }
+
+            /*  Read what it sent, send what it's owed */
+            if( ! c->closing
+                    && ( events[i].events & ( EPOLLIN | EPOLLHUP | EPOLLERR ))
+                    && read_conn( ctx, c ))
+                drop_conn( c );
+
+            if( c->outPos < c->outLen && write_conn( c ))
+                drop_conn( c );
+
+            if( update_conn( epfd, c ))
+                close_conn( c );
+        }
+    }
+
+    /*
+     *  Clients still connected are left to the OS; we're exiting anyway, but
+     *  clean up the socket file so the next server can have the path.
+     */
+    close( epfd );
+    close( listenFd );
+    if( path != NULL )
+        unlink( path );
+
+    cache = NULL;
+    arena_free( &mem );
+    return( status );
+}
@@ -0,0 +1,31 @@
+/*******************************************************************************
+ *  serve.h     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Server mode for the muzz program:  a long-lived process answering requests
+ *  over a socket, one line per request.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_SERVE_H
+#define MUZZ_SERVE_H
+
+#include <stddef.h>
+
+#include "muzz.h"
+#include "stats.h"
+
+
+/*
+ *  Listens on addr and answers requests until interrupted.  addr is a Unix
+ *  socket path (anything with a '/' in it, or "unix:PATH") or a TCP
+ *  "[HOST:]PORT".  Each request line is options and numbers, the same as the
+ *  command line; the options start from ctx.  With cacheSize, that many
+ *  answers are kept for requests that come again; with counts, requests,
+ *  bytes and cache hits are counted there.  Returns 0 once stopped, or 1 if
+ *  we couldn't listen.
+ */
+int serve_run( const char *addr, const muzz_ctx *ctx, size_t cacheSize,
+        run_stats *counts );
+
+#endif
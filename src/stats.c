@@ -0,0 +1,193 @@
+/*******************************************************************************
+ *  stats.c     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Counters and timings for '--stats'.  Stages are timed a block or a chunk
+ *  at a time, never per record, and only when stats were asked for, so the
+ *  clocks are read a few times per thousand records at most.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "stats.h"
+#include "arena.h"
+
+
+static const char *stageNames[ STAT_STAGES ] = {
+    "read", "parse", "compute", "format", "write"
+};
+
+
+
+/*==============================================================================
+                                  CLOCK SECONDS
+--------------------------------------------------------------------------------
+*/
+static double clock_seconds( clockid_t clock )
+{
+    struct timespec ts;
+    clock_gettime( clock, &ts );
+    return( ts.tv_sec + ts.tv_nsec / 1e9 );
+}
+
+
+
+/*==============================================================================
+                                  STATS START
+--------------------------------------------------------------------------------
+*/
+void stats_start( stats_time *t )
+{
+    t->wall = clock_seconds( CLOCK_MONOTONIC );
+    t->cpu = clock_seconds( CLOCK_THREAD_CPUTIME_ID );
+}
+
+
+
+/*==============================================================================
+                                   STATS LAP
+--------------------------------------------------------------------------------
+*   Adds the time since *t to a stage, and restarts *t.
+*
+*   Params
+*       run_stats *s    |   Where to add it
+*       int stage       |   One of enum StatStage
+*       stats_time *t   |   When the stage started; set to now
+*/
+void stats_lap( run_stats *s, int stage, stats_time *t )
+{
+    stats_time now;
+
+    stats_start( &now );
+    s->stages[ stage ].wall += now.wall - t->wall;
+    s->stages[ stage ].cpu += now.cpu - t->cpu;
+    *t = now;
+}
+
+
+
+/*==============================================================================
+                                   STATS INIT
+--------------------------------------------------------------------------------
+*/
+void stats_init( run_stats *s )
+{
+    memset( s, 0, sizeof( *s ));
+    stats_start( &s->start );
+}
+
+
+
+/*==============================================================================
+                                  STATS MERGE
+--------------------------------------------------------------------------------
+*/
+void stats_merge( run_stats *into, const run_stats *from )
+{
+    int i;
+
+    into->records += from->records;
+    into->rejected += from->rejected;
+    into->bytesIn += from->bytesIn;
+    into->bytesOut += from->bytesOut;
+    into->cacheHits += from->cacheHits;
+    into->cacheMisses += from->cacheMisses;
+
+    for( i = 0; i < STAT_STAGES; ++i )
+    {
+        into->stages[i].wall += from->stages[i].wall;
+        into->stages[i].cpu += from->stages[i].cpu;
+    }
+}
+
+
+
+/*==============================================================================
+                                  STATS FINISH
+--------------------------------------------------------------------------------
+*   Stops the clock, and takes the CPU time of every thread and the peak
+*   memory use from the OS, and the number of heap allocations.
+*/
+void stats_finish( run_stats *s )
+{
+    struct rusage ru;
+
+    s->total.wall = clock_seconds( CLOCK_MONOTONIC ) - s->start.wall;
+    s->total.cpu = 0;
+    s->allocs = heap_allocs();
+
+    if( getrusage( RUSAGE_SELF, &ru ) == 0 )
+    {
+        s->total.cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+            + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+        s->peakRss = ru.ru_maxrss;
+    }
+}
+
+
+
+/*==============================================================================
+                                  STATS PRINT
+--------------------------------------------------------------------------------
+*   Prints the stats, either for people or as one line of JSON.
+*
+*   Params
+*       run_stats *s    |   Finished stats
+*       FILE *fp        |   Where to print them
+*       int json        |   1 for JSON
+*/
+void stats_print( const run_stats *s, FILE *fp, int json )
+{
+    double wall = ( s->total.wall > 0 ? s->total.wall : 1e-9 );
+    int i;
+
+    if( json )
+    {
+        fprintf( fp, "{\"records\":%llu,\"rejected\":%llu,"
+                "\"bytes_in\":%llu,\"bytes_out\":%llu,"
+                "\"cache_hits\":%llu,\"cache_misses\":%llu,"
+                "\"wall_seconds\":%.6f,\"cpu_seconds\":%.6f,"
+                "\"records_per_sec\":%.0f,\"peak_rss_kb\":%ld,"
+                "\"allocations\":%llu,\"kernels\":\"%s\",\"stages\":{",
+                (unsigned long long)s->records,
+                (unsigned long long)s->rejected,
+                (unsigned long long)s->bytesIn,
+                (unsigned long long)s->bytesOut,
+                (unsigned long long)s->cacheHits,
+                (unsigned long long)s->cacheMisses,
+                s->total.wall, s->total.cpu, s->records / wall, s->peakRss,
+                (unsigned long long)s->allocs,
+                ( s->kernels ? s->kernels : "none" ));
+
+        for( i = 0; i < STAT_STAGES; ++i )
+            fprintf( fp, "%s\"%s\":{\"wall_seconds\":%.6f,"
+                    "\"cpu_seconds\":%.6f}", ( i ? "," : "" ), stageNames[i],
+                    s->stages[i].wall, s->stages[i].cpu );
+
+        fprintf( fp, "}}\n" );
+        return;
+    }
+
+    fprintf( fp, "Records:\t%llu\n", (unsigned long long)s->records );
+    fprintf( fp, "Rejected:\t%llu\n", (unsigned long long)s->rejected );
+    fprintf( fp, "Bytes in:\t%llu\n", (unsigned long long)s->bytesIn );
+    fprintf( fp, "Bytes out:\t%llu\n", (unsigned long long)s->bytesOut );
+    fprintf( fp, "Cache hits:\t%llu\n", (unsigned long long)s->cacheHits );
+    fprintf( fp, "Cache misses:\t%llu\n",
+            (unsigned long long)s->cacheMisses );
+    fprintf( fp, "Wall time:\t%.6f s\n", s->total.wall );
+    fprintf( fp, "CPU time:\t%.6f s\n", s->total.cpu );
+    fprintf( fp, "Records/sec:\t%.0f\n", s->records / wall );
+    fprintf( fp, "Peak RSS:\t%ld KiB\n", s->peakRss );
+    fprintf( fp, "Allocations:\t%llu\n", (unsigned long long)s->allocs );
+    fprintf( fp, "Kernels:\t%s\n", ( s->kernels ? s->kernels : "none" ));
+
+    fprintf( fp, "\nStage\t\tWall (s)\tCPU (s)\n" );
+    for( i = 0; i < STAT_STAGES; ++i )
+        fprintf( fp, "%s\t\t%.6f\t%.6f\n", stageNames[i],
+                s->stages[i].wall, s->stages[i].cpu );
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ *  stats.h     |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Counters and timings for '--stats'.  Everything that collects them takes a
+ *  run_stats pointer, and does nothing at all when it's NULL.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_STATS_H
+#define MUZZ_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+/*  The stages a record goes through */
+enum StatStage {
+    STAT_READ,
+    STAT_PARSE,
+    STAT_COMPUTE,
+    STAT_FORMAT,
+    STAT_WRITE,
+    STAT_STAGES
+};
+
+
+/*  A point in time, by the clock and by this thread's CPU time */
+typedef struct stats_time {
+    double wall;
+    double cpu;
+} stats_time;
+
+
+/*  Everything we count */
+typedef struct run_stats {
+    uint64_t records;       //  Results printed
+    uint64_t rejected;      //  Bad records
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint64_t cacheHits;     //  '--cache':  lines that were already there...
+    uint64_t cacheMisses;   //  ...and that had to be worked out
+
+    stats_time stages[ STAT_STAGES ];   //  Time spent, summed over threads
+
+    stats_time start;       //  When the run started...
+    stats_time total;       //  ...and how long it took, all threads together
+    long peakRss;           //  In KiB
+    uint64_t allocs;        //  Trips to the heap, the whole run
+    const char *kernels;    //  Kernels the compute plan ran (e.g. "avx2")
+} run_stats;
+
+
+/*  Zeroes the counters and starts the clock on the whole run */
+void stats_init( run_stats *s );
+
+/*  Sets *t to now */
+void stats_start( stats_time *t );
+
+/*  Adds the time since *t to a stage, and sets *t to now */
+void stats_lap( run_stats *s, int stage, stats_time *t );
+
+/*  Adds one set of counters (say, a thread's) to another */
+void stats_merge( run_stats *into, const run_stats *from );
+
+/*  Stops the clock on the whole run and takes the process totals */
+void stats_finish( run_stats *s );
+
+/*  Prints the lot, as text or as a line of JSON */
+void stats_print( const run_stats *s, FILE *fp, int json );
+
+#endif
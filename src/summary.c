@@ -0,0 +1,1034 @@
+/*******************************************************************************
+ *  summary.c   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Summaries for '--summary'.  The mean and standard deviation are kept with
+ *  Welford's running update, which doesn't lose precision the way summing
+ *  squares does, and two of them merge with Chan's formula.  Percentiles
+ *  come from a merging t-digest:  values are buffered, then sorted and
+ *  merged into centroids that are kept small near the tails (where the
+ *  percentiles people ask about are) and allowed to grow in the middle.
+ *  Merging two digests is just adding one's centroids to the other.
+ *
+ *  So every group is a fixed, small size however many values go into it,
+ *  and summaries of different blocks can be built separately and added up.
+ *  The same goes for summaries of different shards of a run, which are
+ *  saved to partial files (see partial.c) exactly as they are, centroids,
+ *  buffered values and all, and added up again when they're loaded.
+ *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "summary.h"
+#include "arena.h"
+#include "partial.h"
+
+
+/*  How fine the digest is; it never has more than about this many centroids */
+#define DIGEST_COMPRESSION 100.0
+
+/*  Most centroids a digest can have */
+#define DIGEST_CENTROIDS 128
+
+/*  Values buffered before they're merged, at first and at most */
+#define DIGEST_START 8
+#define DIGEST_BUFFER 2048
+
+/*  Longest key a partial may have */
+#define PARTIAL_KEY_MAX ( 1 << 20 )
+
+/*  Fewer than this many get an insertion sort rather than a radix sort */
+#define RADIX_MIN 64
+
+/*  Bits of the key sorted on at a time */
+#define RADIX_BITS 11
+#define RADIX_SIZE ( 1 << RADIX_BITS )
+
+#define PI 3.14159265358979323846
+
+/*  The percentiles we print */
+static const double percentiles[] = { 5, 50, 95 };
+
+#define NUM_PERCENTILES ( sizeof( percentiles ) / sizeof( percentiles[0] ))
+
+
+
+/*==============================================================================
+                                  TABLE ALLOC
+--------------------------------------------------------------------------------
+*   Memory for a table, from its arena or the heap.
+*/
+static void *table_alloc( summary_table *t, size_t size )
+{
+    if( t->mem != NULL )
+        return( arena_alloc( t->mem, size ));
+
+    return( heap_alloc( size ));
+}
+
+
+
+/*==============================================================================
+                                   TABLE GROW
+--------------------------------------------------------------------------------
+*/
+static void *table_grow( summary_table *t, void *old, size_t oldSize,
+        size_t newSize )
+{
+    if( t->mem != NULL )
+        return( arena_grow( t->mem, old, oldSize, newSize ));
+
+    return( heap_realloc( old, newSize ));
+}
+
+
+
+/*==============================================================================
+                                 TABLE RELEASE
+--------------------------------------------------------------------------------
+*   Gives memory back, if it came from the heap; an arena gets it all back at
+*   once when it's reset.
+*/
+static void table_release( summary_table *t, void *p )
+{
+    if( t->mem == NULL )
+        heap_free( p );
+}
+
+
+
+/*==============================================================================
+                                   SCALE (K)
+--------------------------------------------------------------------------------
+*   The t-digest's scale function, and its inverse.  A centroid may cover at
+*   most 1 in k, which is tiny in q near 0 and 1 and wide around 0.5.
+*/
+static double q_to_k( double q )
+{
+    return( DIGEST_COMPRESSION / ( 2 * PI ) * asin( 2 * q - 1 ));
+}
+
+static double k_to_q( double k )
+{
+    if( k >= DIGEST_COMPRESSION / 4 )
+        return( 1 );
+
+    return( ( sin( k * 2 * PI / DIGEST_COMPRESSION ) + 1 ) / 2 );
+}
+
+
+
+/*==============================================================================
+                                   MEAN KEY
+--------------------------------------------------------------------------------
+*   A centroid's mean as an unsigned number in the same order:  flip every
+*   bit of a negative, and just the sign bit of a positive.
+*/
+static inline uint64_t mean_key( const summary_centroid *c )
+{
+    uint64_t u;
+
+    memcpy( &u, &c->mean, sizeof( u ));
+    return( ( u >> 63 ) ? ~u : u | ( 1ull << 63 ));
+}
+
+
+
+/*==============================================================================
+                                  SORT BY MEAN
+--------------------------------------------------------------------------------
+*   Sorts centroids by mean:  a radix sort, RADIX_BITS at a time, skipping
+*   any digit that's the same in every key (the sign and exponent, usually,
+*   since a column's values tend to be of a size).  tmp has room for n.
+*/
+static void sort_by_mean( summary_centroid *c, summary_centroid *tmp, int n )
+{
+    summary_centroid *from = c;
+    summary_centroid *to = tmp;
+    summary_centroid *swap;
+    summary_centroid x;
+    uint64_t first;
+    uint64_t diff = 0;
+    int count[ RADIX_SIZE ];
+    int shift;
+    int sum;
+    int i, j;
+
+    if( n < RADIX_MIN )
+    {
+        for( i = 1; i < n; ++i )
+        {
+            x = c[i];
+            for( j = i; j > 0 && c[ j - 1 ].mean > x.mean; --j )
+                c[j] = c[ j - 1 ];
+            c[j] = x;
+        }
+        return;
+    }
+
+    first = mean_key( &c[0] );
+    for( i = 1; i < n; ++i )
+        diff |= mean_key( &c[i] ) ^ first;
+
+    for( shift = 0; shift < 64; shift += RADIX_BITS )
+    {
+        if( ( ( diff >> shift ) & ( RADIX_SIZE - 1 )) == 0 )
+            continue;
+
+        memset( count, 0, sizeof( count ));
+        for( i = 0; i < n; ++i )
+            ++count[ ( mean_key( &from[i] ) >> shift ) & ( RADIX_SIZE - 1 )];
+
+        for( i = sum = 0; i < RADIX_SIZE; ++i )
+        {
+            j = count[i];
+            count[i] = sum;
+            sum += j;
+        }
+
+        for( i = 0; i < n; ++i )
+            to[ count[ ( mean_key( &from[i] ) >> shift )
+                & ( RADIX_SIZE - 1 )]++ ] = from[i];
+
+        swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if( from != c )
+        memcpy( c, from, n * sizeof( *c ));
+}
+
+
+
+/*==============================================================================
+                                 DIGEST COMPRESS
+--------------------------------------------------------------------------------
+*   Merges the buffered values into the centroids.  Returns 0, or -1 if we're
+*   out of memory.
+*/
+static int digest_compress( summary_table *t, summary_digest *d )
+{
+    summary_centroid all[ DIGEST_CENTROIDS + DIGEST_BUFFER ];
+    summary_centroid cur;
+    double total = d->weight;
+    double before = 0;
+    double limit;
+    int n = d->numCentroids + d->numBuffered;
+    int need = ( n < DIGEST_CENTROIDS ? n : DIGEST_CENTROIDS );
+    int out = 0;
+    int i, j, k;
+
+    if( d->numBuffered == 0 )
+        return( 0 );
+
+    if( d->centroidCap < need )
+    {
+        int cap = ( d->centroidCap * 2 > need ? d->centroidCap * 2 : need );
+        summary_centroid *p;
+
+        if( cap > DIGEST_CENTROIDS )
+            cap = DIGEST_CENTROIDS;
+
+        p = table_grow( t, d->centroids,
+                d->centroidCap * sizeof( summary_centroid ),
+                cap * sizeof( summary_centroid ));
+        if( p == NULL )
+            return( -1 );
+
+        d->centroids = p;
+        d->centroidCap = cap;
+    }
+
+    /*  Everything in order:  the centroids already are, so sort the rest in */
+    sort_by_mean( d->buffer, all, d->numBuffered );
+
+    i = j = k = 0;
+    do
+    {
+        if( j == d->numBuffered || ( i < d->numCentroids
+                    && d->centroids[i].mean <= d->buffer[j].mean ))
+            all[k] = d->centroids[ i++ ];
+        else
+        {
+            all[k] = d->buffer[ j ];
+            total += d->buffer[ j++ ].weight;
+        }
+    } while( ++k < n );
+
+    /*  Merge neighbours for as long as they fit within 1 in k */
+    cur = all[0];
+    limit = k_to_q( q_to_k( 0 ) + 1 ) * total;
+
+    for( k = 1; k < n; ++k )
+    {
+        if( before + cur.weight + all[k].weight <= limit
+                || out == DIGEST_CENTROIDS - 1 )
+        {
+            cur.weight += all[k].weight;
+            cur.mean += ( all[k].mean - cur.mean ) * all[k].weight
+                / cur.weight;
+            continue;
+        }
+
+        d->centroids[ out++ ] = cur;
+        before += cur.weight;
+        limit = k_to_q( q_to_k( before / total ) + 1 ) * total;
+        cur = all[k];
+    }
+
+    d->centroids[ out++ ] = cur;
+    d->numCentroids = out;
+    d->numBuffered = 0;
+    d->weight = total;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   DIGEST ADD
+--------------------------------------------------------------------------------
+*   Adds a value (or a centroid) to a digest.  Returns 0, or -1 if we're out
+*   of memory.
+*/
+static int digest_add( summary_table *t, summary_digest *d, double mean,
+        double weight )
+{
+    if( d->numBuffered == d->bufferCap )
+    {
+        /*  Small groups only ever need a small buffer */
+        if( d->bufferCap < DIGEST_BUFFER )
+        {
+            int cap = ( d->bufferCap ? d->bufferCap * 2 : DIGEST_START );
+            summary_centroid *p = table_grow( t, d->buffer,
+                    d->bufferCap * sizeof( summary_centroid ),
+                    cap * sizeof( summary_centroid ));
+
+            if( p == NULL )
+                return( -1 );
+
+            d->buffer = p;
+            d->bufferCap = cap;
+        }
+
+        else if( digest_compress( t, d ))
+            return( -1 );
+    }
+
+    d->buffer[ d->numBuffered ].mean = mean;
+    d->buffer[ d->numBuffered ].weight = weight;
+    ++d->numBuffered;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                DIGEST QUANTILE
+--------------------------------------------------------------------------------
+*   Estimates the q'th quantile (0 to 1), interpolating between the centres
+*   of the centroids, and out to the smallest and largest values at the ends.
+*   The digest has to be compressed first.
+*/
+static double digest_quantile( const summary_digest *d, double q, double min,
+        double max )
+{
+    const summary_centroid *c = d->centroids;
+    int n = d->numCentroids;
+    double index = q * d->weight;
+    double first = c[0].weight / 2;
+    double last = c[ n - 1 ].weight / 2;
+    double cum = first;
+    double step;
+    int i;
+
+    if( n == 1 )
+        return( c[0].mean );
+
+    if( index < first )
+        return( min + ( c[0].mean - min ) * index / first );
+
+    if( index > d->weight - last )
+        return( max - ( max - c[ n - 1 ].mean ) * ( d->weight - index )
+                / last );
+
+    for( i = 0; i < n - 1; ++i )
+    {
+        step = ( c[i].weight + c[ i + 1 ].weight ) / 2;
+        if( index <= cum + step )
+            return( c[i].mean + ( c[ i + 1 ].mean - c[i].mean )
+                    * ( index - cum ) / step );
+        cum += step;
+    }
+
+    return( c[ n - 1 ].mean );
+}
+
+
+
+/*==============================================================================
+                                   COLUMN ADD
+--------------------------------------------------------------------------------
+*/
+static int column_add( summary_table *t, summary_column *c, double x )
+{
+    double delta = x - c->mean;
+
+    ++c->count;
+    c->mean += delta / c->count;
+    c->m2 += delta * ( x - c->mean );
+
+    if( c->count == 1 || x < c->min )
+        c->min = x;
+    if( c->count == 1 || x > c->max )
+        c->max = x;
+
+    return( digest_add( t, &c->digest, x, 1 ));
+}
+
+
+
+/*==============================================================================
+                                  COLUMN MERGE
+--------------------------------------------------------------------------------
+*/
+static int column_merge( summary_table *t, summary_column *into,
+        const summary_column *from )
+{
+    const summary_digest *d = &from->digest;
+    double n = (double)into->count + from->count;
+    double delta = from->mean - into->mean;
+    int i;
+
+    if( from->count == 0 )
+        return( 0 );
+
+    if( into->count == 0 )
+    {
+        into->mean = from->mean;
+        into->m2 = from->m2;
+        into->min = from->min;
+        into->max = from->max;
+    }
+
+    else
+    {
+        into->mean += delta * from->count / n;
+        into->m2 += from->m2 + delta * delta * ( into->count / n )
+            * from->count;
+
+        if( from->min < into->min )
+            into->min = from->min;
+        if( from->max > into->max )
+            into->max = from->max;
+    }
+
+    into->count += from->count;
+
+    for( i = 0; i < d->numCentroids; ++i )
+        if( digest_add( t, &into->digest, d->centroids[i].mean,
+                    d->centroids[i].weight ))
+            return( -1 );
+
+    for( i = 0; i < d->numBuffered; ++i )
+        if( digest_add( t, &into->digest, d->buffer[i].mean,
+                    d->buffer[i].weight ))
+            return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  SUMMARY INIT
+--------------------------------------------------------------------------------
+*/
+void summary_init( summary_table *t, int numCols, arena *mem )
+{
+    memset( t, 0, sizeof( *t ));
+    t->mem = mem;
+    t->numCols = numCols;
+}
+
+
+
+/*==============================================================================
+                                    HASH KEY
+--------------------------------------------------------------------------------
+*   FNV-1a.
+*/
+static uint64_t hash_key( const char *key, size_t len )
+{
+    uint64_t h = 14695981039346656037ULL;
+    size_t i;
+
+    for( i = 0; i < len; ++i )
+    {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+
+    return( h );
+}
+
+
+
+/*==============================================================================
+                                   ADD GROUP
+--------------------------------------------------------------------------------
+*   Puts a new group in the table, growing it if need be.  Returns 0, or -1
+*   if we're out of memory.
+*/
+static int add_group( summary_table *t, summary_group *g )
+{
+    size_t mask;
+    size_t i;
+
+    if( t->numGroups == t->groupCap )
+    {
+        size_t cap = ( t->groupCap ? t->groupCap * 2 : 16 );
+        summary_group **p = table_grow( t, t->groups,
+                t->groupCap * sizeof( *p ), cap * sizeof( *p ));
+
+        if( p == NULL )
+            return( -1 );
+
+        t->groups = p;
+        t->groupCap = cap;
+    }
+
+    /*  Keep the hash table no more than half full */
+    if( ( t->numGroups + 1 ) * 2 > t->numSlots )
+    {
+        size_t num = ( t->numSlots ? t->numSlots * 2 : 32 );
+        size_t *slots = table_alloc( t, num * sizeof( *slots ));
+
+        if( slots == NULL )
+            return( -1 );
+
+        memset( slots, 0, num * sizeof( *slots ));
+        for( i = 0; i < t->numGroups; ++i )
+        {
+            size_t s = t->groups[i]->hash & ( num - 1 );
+            while( slots[s] )
+                s = ( s + 1 ) & ( num - 1 );
+            slots[s] = i + 1;
+        }
+
+        table_release( t, t->slots );
+        t->slots = slots;
+        t->numSlots = num;
+    }
+
+    mask = t->numSlots - 1;
+    for( i = g->hash & mask; t->slots[i]; i = ( i + 1 ) & mask )
+        ;
+
+    t->groups[ t->numGroups++ ] = g;
+    t->slots[i] = t->numGroups;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  SUMMARY FIND
+--------------------------------------------------------------------------------
+*   Finds the group for a key, or makes it.  Records tend to come in runs of
+*   the same key, so the last one found is checked first.
+*
+*   Params
+*       summary_table *t    |   The table
+*       const char *key     |   The key; needn't be terminated
+*       size_t len          |   Its length
+*/
+summary_group *summary_find( summary_table *t, const char *key, size_t len )
+{
+    summary_group *g = t->last;
+    size_t size;
+    uint64_t hash;
+    size_t i;
+
+    if( g != NULL && g->keyLen == len && memcmp( g->key, key, len ) == 0 )
+        return( g );
+
+    hash = hash_key( key, len );
+
+    if( t->numSlots > 0 )
+    {
+        for( i = hash & ( t->numSlots - 1 ); t->slots[i];
+                i = ( i + 1 ) & ( t->numSlots - 1 ))
+        {
+            g = t->groups[ t->slots[i] - 1 ];
+            if( g->hash == hash && g->keyLen == len
+                    && memcmp( g->key, key, len ) == 0 )
+                return( t->last = g );
+        }
+    }
+
+    /*  New one */
+    size = sizeof( summary_group ) + t->numCols * sizeof( summary_column );
+    g = table_alloc( t, size );
+    if( g == NULL )
+        return( NULL );
+
+    memset( g, 0, size );
+    g->key = table_alloc( t, len + 1 );
+    if( g->key == NULL )
+    {
+        table_release( t, g );
+        return( NULL );
+    }
+
+    memcpy( g->key, key, len );
+    g->key[ len ] = '\0';
+    g->keyLen = len;
+    g->hash = hash;
+
+    if( add_group( t, g ))
+    {
+        table_release( t, g->key );
+        table_release( t, g );
+        return( NULL );
+    }
+
+    return( t->last = g );
+}
+
+
+
+/*==============================================================================
+                                 SUMMARY ADD (N)
+--------------------------------------------------------------------------------
+*/
+int summary_add_n( summary_table *t, summary_group *const *groups, int col,
+        const double *x, size_t n )
+{
+    size_t i;
+
+    for( i = 0; i < n; ++i )
+        if( column_add( t, &groups[i]->cols[ col ], x[i] ))
+            return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 SUMMARY MERGE
+--------------------------------------------------------------------------------
+*   Adds the groups of one table to another, in the order they were first
+*   seen, so merging the same tables in the same order always gives the same
+*   answer.
+*/
+int summary_merge( summary_table *into, const summary_table *from )
+{
+    summary_group *g;
+    size_t i;
+    int c;
+
+    for( i = 0; i < from->numGroups; ++i )
+    {
+        g = summary_find( into, from->groups[i]->key, from->groups[i]->keyLen );
+        if( g == NULL )
+            return( -1 );
+
+        for( c = 0; c < into->numCols; ++c )
+            if( column_merge( into, &g->cols[c], &from->groups[i]->cols[c] ))
+                return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  SAVE COLUMN
+--------------------------------------------------------------------------------
+*/
+static int save_column( const summary_column *c, FILE *fp )
+{
+    const summary_digest *d = &c->digest;
+    int i;
+
+    if( partial_put_u64( fp, c->count ) || partial_put_f64( fp, c->mean )
+            || partial_put_f64( fp, c->m2 ) || partial_put_f64( fp, c->min )
+            || partial_put_f64( fp, c->max )
+            || partial_put_u64( fp, d->numCentroids )
+            || partial_put_u64( fp, d->numBuffered ))
+        return( -1 );
+
+    for( i = 0; i < d->numCentroids; ++i )
+        if( partial_put_f64( fp, d->centroids[i].mean )
+                || partial_put_f64( fp, d->centroids[i].weight ))
+            return( -1 );
+
+    for( i = 0; i < d->numBuffered; ++i )
+        if( partial_put_f64( fp, d->buffer[i].mean )
+                || partial_put_f64( fp, d->buffer[i].weight ))
+            return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  SUMMARY SAVE
+--------------------------------------------------------------------------------
+*   Writes a table out:  the number of groups, then each group's key (its
+*   length, then the bytes) and columns, in the order they were first seen.
+*
+*   Params
+*       summary_table *t    |   The table
+*       FILE *fp            |   Where to write it
+*/
+int summary_save( const summary_table *t, FILE *fp )
+{
+    const summary_group *g;
+    size_t i;
+    int c;
+
+    if( partial_put_u64( fp, t->numGroups ))
+        return( -1 );
+
+    for( i = 0; i < t->numGroups; ++i )
+    {
+        g = t->groups[i];
+        if( partial_put_u64( fp, g->keyLen )
+                || fwrite( g->key, 1, g->keyLen, fp ) != g->keyLen )
+            return( -1 );
+
+        for( c = 0; c < t->numCols; ++c )
+            if( save_column( &g->cols[c], fp ))
+                return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  LOAD COLUMN
+--------------------------------------------------------------------------------
+*   Reads a column into c, with its digest in the space given (big enough
+*   for any digest, since a saved one can be no bigger than that).
+*/
+static int load_column( summary_column *c, FILE *fp,
+        summary_centroid *centroids, summary_centroid *buffer )
+{
+    summary_digest *d = &c->digest;
+    uint64_t numCentroids;
+    uint64_t numBuffered;
+    int i;
+
+    if( partial_get_u64( fp, &c->count ) || partial_get_f64( fp, &c->mean )
+            || partial_get_f64( fp, &c->m2 ) || partial_get_f64( fp, &c->min )
+            || partial_get_f64( fp, &c->max )
+            || partial_get_u64( fp, &numCentroids )
+            || partial_get_u64( fp, &numBuffered )
+            || numCentroids > DIGEST_CENTROIDS || numBuffered > DIGEST_BUFFER )
+        return( -1 );
+
+    memset( d, 0, sizeof( *d ));
+    d->centroids = centroids;
+    d->numCentroids = d->centroidCap = (int)numCentroids;
+    d->buffer = buffer;
+    d->numBuffered = d->bufferCap = (int)numBuffered;
+
+    for( i = 0; i < d->numCentroids; ++i )
+    {
+        if( partial_get_f64( fp, &centroids[i].mean )
+                || partial_get_f64( fp, &centroids[i].weight ))
+            return( -1 );
+        d->weight += centroids[i].weight;
+    }
+
+    for( i = 0; i < d->numBuffered; ++i )
+        if( partial_get_f64( fp, &buffer[i].mean )
+                || partial_get_f64( fp, &buffer[i].weight ))
+            return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  SUMMARY LOAD
+--------------------------------------------------------------------------------
+*   Reads a table written by summary_save() and adds it to t, one group at a
+*   time, just as summary_merge() would.  Returns 0, or -1 if it's cut short
+*   or makes no sense, or we're out of memory.
+*
+*   Params
+*       summary_table *t    |   What to add it to; it has the same columns
+*       FILE *fp            |   Where to read it from
+*/
+int summary_load( summary_table *t, FILE *fp )
+{
+    summary_centroid centroids[ DIGEST_CENTROIDS ];
+    summary_centroid buffer[ DIGEST_BUFFER ];
+    summary_column col;
+    summary_group *g;
+    uint64_t numGroups;
+    uint64_t keyLen;
+    uint64_t i;
+    char *key;
+    int status = 0;
+    int c;
+
+    if( partial_get_u64( fp, &numGroups ))
+        return( -1 );
+
+    for( i = 0; status == 0 && i < numGroups; ++i )
+    {
+        if( partial_get_u64( fp, &keyLen ) || keyLen > PARTIAL_KEY_MAX )
+            return( -1 );
+
+        key = heap_alloc( keyLen + 1 );
+        if( key == NULL || fread( key, 1, keyLen, fp ) != keyLen )
+        {
+            heap_free( key );
+            return( -1 );
+        }
+
+        g = summary_find( t, key, keyLen );
+        heap_free( key );
+        if( g == NULL )
+            return( -1 );
+
+        for( c = 0; status == 0 && c < t->numCols; ++c )
+            if( load_column( &col, fp, centroids, buffer )
+                    || column_merge( t, &g->cols[c], &col ))
+                status = -1;
+    }
+
+    return( status );
+}
+
+
+
+/*==============================================================================
+                                     BY KEY
+--------------------------------------------------------------------------------
+*/
+static int by_key( const void *a, const void *b )
+{
+    const summary_group *x = *(summary_group *const *)a;
+    const summary_group *y = *(summary_group *const *)b;
+    int cmp = memcmp( x->key, y->key,
+            ( x->keyLen < y->keyLen ? x->keyLen : y->keyLen ));
+
+    if( cmp != 0 )
+        return( cmp );
+
+    return( ( x->keyLen > y->keyLen ) - ( x->keyLen < y->keyLen ));
+}
+
+
+
+/*==============================================================================
+                                  PRINT STRING
+--------------------------------------------------------------------------------
+*   Prints a string as JSON, quotes and all.
+*/
+static void print_string( FILE *fp, const char *s, size_t len )
+{
+    size_t i;
+
+    putc( '"', fp );
+    for( i = 0; i < len; ++i )
+    {
+        unsigned char c = s[i];
+
+        if( c == '"' || c == '\\' )
+            fprintf( fp, "\\%c", c );
+        else if( c < 0x20 )
+            fprintf( fp, "\\u%04x", c );
+        else
+            putc( c, fp );
+    }
+    putc( '"', fp );
+}
+
+
+
+/*==============================================================================
+                                  PRINT GROUP
+--------------------------------------------------------------------------------
+*   Prints one group, as a table or a line of JSON.  Returns 0, or -1 if we
+*   ran out of memory finishing off its digests.
+*/
+static int print_group( summary_table *t, summary_group *g, FILE *fp,
+        int json, const char *const *names, const char *const *units )
+{
+    summary_column *col;
+    double stats[ 5 + NUM_PERCENTILES ];
+    static const char *statNames[ 5 ] = { "mean", "sd", "es", "min", "max" };
+    char label[ 64 ];
+    size_t i;
+    int c;
+
+    if( json )
+    {
+        putc( '{', fp );
+        if( g->keyLen > 0 )
+        {
+            fprintf( fp, "\"group\":" );
+            print_string( fp, g->key, g->keyLen );
+            putc( ',', fp );
+        }
+        fprintf( fp, "\"shots\":%llu", (unsigned long long)g->cols[0].count );
+    }
+
+    else
+    {
+        if( g->keyLen > 0 )
+            fprintf( fp, "%s:  ", g->key );
+        fprintf( fp, "%llu shot%s\n%-18s",
+                (unsigned long long)g->cols[0].count,
+                ( g->cols[0].count == 1 ? "" : "s" ), "" );
+        fprintf( fp, "%10s%10s%10s%10s%10s", "Mean", "SD", "ES", "Min",
+                "Max" );
+        for( i = 0; i < NUM_PERCENTILES; ++i )
+        {
+            snprintf( label, sizeof( label ), "%g%%", percentiles[i] );
+            fprintf( fp, "%10s", label );
+        }
+        putc( '\n', fp );
+    }
+
+    for( c = 0; c < t->numCols; ++c )
+    {
+        col = &g->cols[c];
+        if( digest_compress( t, &col->digest ))
+            return( -1 );
+
+        stats[0] = col->mean;
+        stats[1] = ( col->count > 1 ? sqrt( col->m2 / ( col->count - 1 )) : 0 );
+        stats[2] = col->max - col->min;
+        stats[3] = col->min;
+        stats[4] = col->max;
+        for( i = 0; i < NUM_PERCENTILES; ++i )
+            stats[ 5 + i ] = digest_quantile( &col->digest,
+                    percentiles[i] / 100, col->min, col->max );
+
+        if( json )
+        {
+            fprintf( fp, ",\"%s\":{", names[c] );
+            for( i = 0; i < 5; ++i )
+                fprintf( fp, "%s\"%s\":%.10g", ( i ? "," : "" ), statNames[i],
+                        stats[i] );
+            for( i = 0; i < NUM_PERCENTILES; ++i )
+                fprintf( fp, ",\"p%g\":%.10g", percentiles[i], stats[ 5 + i ]);
+            putc( '}', fp );
+            continue;
+        }
+
+        if( units[c] != NULL )
+            snprintf( label, sizeof( label ), "%s (%s)", names[c], units[c] );
+        else
+            snprintf( label, sizeof( label ), "%s", names[c] );
+
+        fprintf( fp, "%-18s", label );
+        for( i = 0; i < 5 + NUM_PERCENTILES; ++i )
+            fprintf( fp, "%10.2f", stats[i] );
+        putc( '\n', fp );
+    }
+
+    if( json )
+        fprintf( fp, "}\n" );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 SUMMARY PRINT
+--------------------------------------------------------------------------------
+*   Prints every group, sorted by key.  Groups are separated by a blank line
+*   in a table, and one per line in JSON.
+*
+*   Params
+*       summary_table *t    |   The table; its digests get finished off
+*       FILE *fp            |   Where to print
+*       int json            |   1 for JSON
+*       char **names        |   What each column is called
+*       char **units        |   What it's measured in, or NULL
+*/
+void summary_print( summary_table *t, FILE *fp, int json,
+        const char *const *names, const char *const *units )
+{
+    summary_group **sorted;
+    size_t i;
+
+    if( t->numGroups == 0 )
+        return;
+
+    /*  If we can't get the memory to sort them, they're printed as they are */
+    sorted = heap_alloc( t->numGroups * sizeof( *sorted ));
+    if( sorted != NULL )
+    {
+        memcpy( sorted, t->groups, t->numGroups * sizeof( *sorted ));
+        qsort( sorted, t->numGroups, sizeof( *sorted ), by_key );
+    }
+
+    for( i = 0; i < t->numGroups; ++i )
+    {
+        if( i > 0 && ! json )
+            putc( '\n', fp );
+
+        if( print_group( t, ( sorted ? sorted[i] : t->groups[i] ), fp, json,
+                    names, units ))
+        {
+            fprintf( stderr, "ERROR:  Out of memory\n" );
+            break;
+        }
+    }
+
+    heap_free( sorted );
+}
+
+
+
+/*==============================================================================
+                                  SUMMARY FREE
+--------------------------------------------------------------------------------
+*/
+void summary_free( summary_table *t )
+{
+    summary_group *g;
+    size_t i;
+    int c;
+
+    if( t->mem != NULL )
+        return;
+
+    for( i = 0; i < t->numGroups; ++i )
+    {
+        g = t->groups[i];
+        for( c = 0; c < t->numCols; ++c )
+        {
+            heap_free( g->cols[c].digest.centroids );
+            heap_free( g->cols[c].digest.buffer );
+        }
+        heap_free( g->key );
+        heap_free( g );
+    }
+
+    heap_free( t->groups );
+    heap_free( t->slots );
+    summary_init( t, t->numCols, NULL );
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ *  summary.h   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Summaries of columns of numbers, kept in one pass:  count, mean, standard
+ *  deviation, extreme spread and percentiles, optionally split up by a key.
+ *  Two summaries of different parts of the input can be merged into one.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_SUMMARY_H
+#define MUZZ_SUMMARY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+
+/*  How a summary gets printed */
+enum SummaryMode {
+    SUMMARY_OFF,
+    SUMMARY_TEXT,
+    SUMMARY_JSON
+};
+
+
+/*  A point, or a cluster of points, of a t-digest */
+typedef struct summary_centroid {
+    double mean;
+    double weight;
+} summary_centroid;
+
+
+/*
+ *  A t-digest:  a sketch of where the values fall, for percentiles.  New
+ *  values wait in buffer until there's enough of them to be worth merging
+ *  into the centroids.  Never more than a few KiB, however many values.
+ */
+typedef struct summary_digest {
+    summary_centroid *centroids;    //  Sorted by mean
+    int numCentroids;
+    int centroidCap;
+
+    summary_centroid *buffer;       //  Not merged in yet
+    int numBuffered;
+    int bufferCap;
+
+    double weight;                  //  Total weight of the centroids
+} summary_digest;
+
+
+/*  Everything we keep about one column */
+typedef struct summary_column {
+    uint64_t count;
+    double mean;
+    double m2;              //  Sum of squared differences from the mean
+    double min;
+    double max;
+    summary_digest digest;
+} summary_column;
+
+
+/*  One key's worth of values */
+typedef struct summary_group {
+    char *key;
+    size_t keyLen;
+    uint64_t hash;
+    summary_column cols[];  //  numCols of them
+} summary_group;
+
+
+/*  Groups, by key */
+typedef struct summary_table {
+    arena *mem;             //  Where everything lives, or NULL for the heap
+    int numCols;
+
+    summary_group **groups; //  In the order they were first seen
+    size_t numGroups;
+    size_t groupCap;
+
+    size_t *slots;          //  Hash table:  index into groups plus one
+    size_t numSlots;
+
+    summary_group *last;    //  Most recently looked up
+} summary_table;
+
+
+/*  An empty table of numCols columns, in an arena or (mem NULL) the heap */
+void summary_init( summary_table *t, int numCols, arena *mem );
+
+/*  The group for a key, made if it's new.  NULL if we're out of memory. */
+summary_group *summary_find( summary_table *t, const char *key, size_t len );
+
+/*
+ *  Adds n values to column col, the value x[i] to the group groups[i].
+ *  Returns 0, or -1 if we're out of memory.
+ */
+int summary_add_n( summary_table *t, summary_group *const *groups, int col,
+        const double *x, size_t n );
+
+/*
+ *  Adds everything in one table to another, as if it had all been added to
+ *  the one.  Returns 0, or -1 if we're out of memory.
+ */
+int summary_merge( summary_table *into, const summary_table *from );
+
+/*  Writes a table to a partial file (see partial.c).  0, or -1. */
+int summary_save( const summary_table *t, FILE *fp );
+
+/*
+ *  Adds a table from a partial file to t, which has to have the same
+ *  columns.  Returns 0, or -1 if it's bad or we're out of memory.
+ */
+int summary_load( summary_table *t, FILE *fp );
+
+/*
+ *  Prints every group, sorted by key, as a table or as a line of JSON each.
+ *  names[c] is what column c is called and units[c] (possibly NULL) what
+ *  it's measured in.
+ */
+void summary_print( summary_table *t, FILE *fp, int json,
+        const char *const *names, const char *const *units );
+
+/*  Frees a heap table */
+void summary_free( summary_table *t );
+
+#endif
@@ -0,0 +1,245 @@
+/*******************************************************************************
+ *  topk.c      |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Top-K for '--top'.  A binary heap with the worst of the kept rows at the
+ *  root:  a row that doesn't beat the root is turned away with a single
+ *  comparison, so once the heap has filled up with good rows, most of the
+ *  stream costs next to nothing.  Rows are ranked by key and then by where
+ *  they were in the stream, so the K best are always the same K, however
+ *  the stream was split up between heaps.  That holds for heaps saved to
+ *  partial files by different shards, too (see partial.c), since a row is
+ *  saved exactly and its position says which shard it came from.
+ *
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "topk.h"
+#include "arena.h"
+#include "partial.h"
+
+
+
+/*==============================================================================
+                                     WORSE
+--------------------------------------------------------------------------------
+*   Whether row a ranks below row b.
+*/
+static int worse( const topk_row *a, const topk_row *b )
+{
+    return( a->key < b->key || ( a->key == b->key && a->order > b->order ));
+}
+
+
+
+/*==============================================================================
+                                   TOPK INIT
+--------------------------------------------------------------------------------
+*/
+void topk_init( topk_heap *h, size_t k )
+{
+    memset( h, 0, sizeof( *h ));
+    h->k = k;
+}
+
+
+
+/*==============================================================================
+                                   SIFT DOWN
+--------------------------------------------------------------------------------
+*   Moves the row at i down until neither child is worse than it.
+*/
+static void sift_down( topk_heap *h, size_t i )
+{
+    topk_row row = h->rows[i];
+    size_t child;
+
+    for( ;; )
+    {
+        child = 2 * i + 1;
+        if( child >= h->count )
+            break;
+
+        if( child + 1 < h->count && worse( &h->rows[ child + 1 ],
+                    &h->rows[ child ]))
+            ++child;
+
+        if( ! worse( &h->rows[ child ], &row ))
+            break;
+
+        h->rows[i] = h->rows[ child ];
+        i = child;
+    }
+
+    h->rows[i] = row;
+}
+
+
+
+/*==============================================================================
+                                   TOPK OFFER
+--------------------------------------------------------------------------------
+*   Keeps a row if it's one of the best k so far, dropping the worst if the
+*   heap is full.
+*/
+int topk_offer( topk_heap *h, const topk_row *row )
+{
+    size_t i;
+
+    if( h->count == h->k )
+    {
+        if( h->k == 0 || ! worse( &h->rows[0], row ))
+            return( 0 );
+
+        h->rows[0] = *row;
+        sift_down( h, 0 );
+        return( 0 );
+    }
+
+    /*  Room for more; the heap only gets as big as it needs to */
+    if( h->count == h->cap )
+    {
+        size_t cap = ( h->cap ? h->cap * 2 : 64 );
+        topk_row *p;
+
+        if( cap > h->k )
+            cap = h->k;
+
+        p = heap_realloc( h->rows, cap * sizeof( topk_row ));
+        if( p == NULL )
+            return( -1 );
+
+        h->rows = p;
+        h->cap = cap;
+    }
+
+    /*  Sift up */
+    for( i = h->count++; i > 0 && worse( row, &h->rows[ ( i - 1 ) / 2 ]);
+            i = ( i - 1 ) / 2 )
+        h->rows[i] = h->rows[ ( i - 1 ) / 2 ];
+
+    h->rows[i] = *row;
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   TOPK MERGE
+--------------------------------------------------------------------------------
+*/
+int topk_merge( topk_heap *into, const topk_heap *from )
+{
+    size_t i;
+
+    for( i = 0; i < from->count; ++i )
+        if( topk_offer( into, &from->rows[i] ))
+            return( -1 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   BEST FIRST
+--------------------------------------------------------------------------------
+*/
+static int best_first( const void *a, const void *b )
+{
+    return( worse( a, b ) - worse( b, a ));
+}
+
+
+
+/*==============================================================================
+                                   TOPK SORT
+--------------------------------------------------------------------------------
+*/
+void topk_sort( topk_heap *h )
+{
+    qsort( h->rows, h->count, sizeof( topk_row ), best_first );
+}
+
+
+
+/*==============================================================================
+                                   TOPK FREE
+--------------------------------------------------------------------------------
+*/
+void topk_free( topk_heap *h )
+{
+    heap_free( h->rows );
+    topk_init( h, h->k );
+}
+
+
+
+/*==============================================================================
+                                   TOPK SAVE
+--------------------------------------------------------------------------------
+*   Writes a heap out:  k and the number of rows, then each row's key,
+*   position and numbers.
+*/
+int topk_save( const topk_heap *h, FILE *fp )
+{
+    const topk_row *row;
+    size_t i;
+    int v;
+
+    if( partial_put_u64( fp, h->k ) || partial_put_u64( fp, h->count ))
+        return( -1 );
+
+    for( i = 0; i < h->count; ++i )
+    {
+        row = &h->rows[i];
+        if( partial_put_f64( fp, row->key )
+                || partial_put_u64( fp, row->order ))
+            return( -1 );
+
+        for( v = 0; v < TOPK_VALS; ++v )
+            if( partial_put_f64( fp, row->vals[v] ))
+                return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                   TOPK LOAD
+--------------------------------------------------------------------------------
+*   Reads a heap written by topk_save() and offers its rows to h.  Returns 0,
+*   or -1 if it's cut short, was kept for another k, or we're out of memory.
+*/
+int topk_load( topk_heap *h, FILE *fp )
+{
+    topk_row row;
+    uint64_t count;
+    uint64_t k;
+    uint64_t i;
+    int v;
+
+    if( partial_get_u64( fp, &k ) || partial_get_u64( fp, &count )
+            || k != h->k || count > k )
+        return( -1 );
+
+    for( i = 0; i < count; ++i )
+    {
+        if( partial_get_f64( fp, &row.key )
+                || partial_get_u64( fp, &row.order ))
+            return( -1 );
+
+        for( v = 0; v < TOPK_VALS; ++v )
+            if( partial_get_f64( fp, &row.vals[v] ))
+                return( -1 );
+
+        if( topk_offer( h, &row ))
+            return( -1 );
+    }
+
+    return( 0 );
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  topk.h      |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  The K best rows of a stream, kept in a heap of K so nothing else has to
+ *  be kept or sorted.  Heaps of different parts of the stream merge into
+ *  the heap of the whole.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_TOPK_H
+#define MUZZ_TOPK_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*  Numbers kept with each row */
+#define TOPK_VALS 5
+
+
+/*  One row:  what it's ranked by, where it was, and what to print for it */
+typedef struct topk_row {
+    double key;             //  Bigger is better
+    uint64_t order;         //  Position in the stream; earlier wins a tie
+    double vals[ TOPK_VALS ];
+} topk_row;
+
+
+/*  The best k rows so far, worst at the top */
+typedef struct topk_heap {
+    topk_row *rows;
+    size_t count;
+    size_t cap;
+    size_t k;
+} topk_heap;
+
+
+/*  An empty heap for the best k rows; the rows are allocated as needed */
+void topk_init( topk_heap *h, size_t k );
+
+/*  Whether a row with this key and order would make it into the heap */
+static inline int topk_wants( const topk_heap *h, double key, uint64_t order )
+{
+    const topk_row *worst = h->rows;
+
+    if( h->count < h->k )
+        return( 1 );
+
+    return( worst->key < key || ( worst->key == key && worst->order > order ));
+}
+
+/*  Offers a row.  Returns 0, or -1 if we're out of memory. */
+int topk_offer( topk_heap *h, const topk_row *row );
+
+/*  Offers every row of one heap to another.  Returns 0, or -1. */
+int topk_merge( topk_heap *into, const topk_heap *from );
+
+/*  Sorts the rows best first; after this it's no longer a heap */
+void topk_sort( topk_heap *h );
+
+/*  Writes a heap to a partial file (see partial.c).  0, or -1. */
+int topk_save( const topk_heap *h, FILE *fp );
+
+/*
+ *  Offers every row of a heap from a partial file to h, which has to have
+ *  the same k.  Returns 0, or -1 if it's bad or we're out of memory.
+ */
+int topk_load( topk_heap *h, FILE *fp );
+
+void topk_free( topk_heap *h );
+
+#endif
@@ -0,0 +1,696 @@
+/*******************************************************************************
+ *  zstream.c   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Compressed input and output, on a thread of their own (see zstream.h).
+ *
+ *  Between the thread and whoever's using the stream is a ring of ZS_SLOTS
+ *  buffers of decompressed text.  Reading, the thread fills them and the
+ *  reader empties them; writing, it's the other way around.  Each side only
+ *  waits when the ring is full (or empty), so as long as both keep up, the
+ *  (de)compressing and the rest of batch mode happen at the same time.  A
+ *  reading thread hands a buffer over as soon as it's used up the input it
+ *  has, full or not, so records coming down a pipe don't sit around.
+ *
+ *  gzip comes from zlib.  zstd is only there if muzz was built with it
+ *  ('make ZSTD=1', which defines MUZZ_ZSTD and links libzstd).
+ *
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+
+#ifdef MUZZ_ZSTD
+#include <zstd.h>
+#endif
+
+#include "zstream.h"
+#include "arena.h"
+
+/*  Buffers between the thread and the stream's user, and their size */
+#define ZS_SLOTS 4
+#define ZS_BUFFER ( 1 << 20 )
+
+/*  Compressed bytes read (or written) at a time */
+#define ZS_CHUNK ( 1 << 18 )
+
+/*  How hard to compress output; the defaults are a good trade for logs */
+#define ZS_GZIP_LEVEL 6
+#define ZS_ZSTD_LEVEL 3
+
+
+/*  One buffer of decompressed text */
+typedef struct zs_slot {
+    unsigned char *buf;
+    size_t len;                 //  What's in it
+    size_t pos;                 //  What's been taken out
+} zs_slot;
+
+
+struct zstream {
+    int fd;
+    int format;                 //  enum ZFormat
+    int writing;
+
+    zs_slot slots[ ZS_SLOTS ];  //  Slot n is slots[ n % ZS_SLOTS ]
+    unsigned long filled;       //  Slots handed over so far
+    unsigned long used;         //  Slots emptied so far
+    zs_slot *current;           //  The slot this side has out, or NULL
+    int done;                   //  Whoever fills the slots has finished
+    int stop;                   //  Whoever empties them has given up
+    int error;
+
+    pthread_mutex_t lock;
+    pthread_cond_t moved;       //  A slot was filled or emptied
+    pthread_t thread;
+    int started;
+
+    unsigned char *chunk;       //  Compressed bytes, ZS_CHUNK of them
+    const unsigned char *in;    //  Compressed input:  the chunk, or a map
+    size_t inLen;
+    size_t inPos;
+
+    z_stream gz;
+    int gzReady;
+#ifdef MUZZ_ZSTD
+    ZSTD_DCtx *dctx;
+    ZSTD_CCtx *cctx;
+#endif
+};
+
+
+
+/*==============================================================================
+                                    DETECT
+--------------------------------------------------------------------------------
+*   What a file is, by its first few bytes.  See zstream.h.
+*/
+int zstream_detect( const void *head, size_t len )
+{
+    static const unsigned char gzMagic[] = { 0x1f, 0x8b };
+    static const unsigned char zstdMagic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+    const unsigned char *p = head;
+    size_t n;
+
+    n = ( len < sizeof( gzMagic ) ? len : sizeof( gzMagic ));
+    if( memcmp( p, gzMagic, n ) == 0 )
+        return( n == sizeof( gzMagic ) ? ZFORMAT_GZIP : -1 );
+
+    n = ( len < sizeof( zstdMagic ) ? len : sizeof( zstdMagic ));
+    if( memcmp( p, zstdMagic, n ) == 0 )
+        return( n == sizeof( zstdMagic ) ? ZFORMAT_ZSTD : -1 );
+
+    return( ZFORMAT_NONE );
+}
+
+
+
+/*==============================================================================
+                                 FORMAT NAMES
+--------------------------------------------------------------------------------
+*   Formats by name, and names by format.
+*/
+int zstream_format( const char *name )
+{
+    if( strcmp( name, "gzip" ) == 0 || strcmp( name, "gz" ) == 0 )
+        return( ZFORMAT_GZIP );
+
+    if( strcmp( name, "zstd" ) == 0 || strcmp( name, "zst" ) == 0 )
+        return( ZFORMAT_ZSTD );
+
+    return( -1 );
+}
+
+
+const char *zstream_name( int format )
+{
+    return( format == ZFORMAT_GZIP ? "gzip"
+            : ( format == ZFORMAT_ZSTD ? "zstd" : "none" ));
+}
+
+
+int zstream_supported( int format )
+{
+#ifdef MUZZ_ZSTD
+    return( format == ZFORMAT_GZIP || format == ZFORMAT_ZSTD );
+#else
+    return( format == ZFORMAT_GZIP );
+#endif
+}
+
+
+
+/*==============================================================================
+                                   THE RING
+--------------------------------------------------------------------------------
+*   slot_free() waits for an empty slot to fill, and slot_publish() hands it
+*   over once it's filled.  slot_full() waits for a filled one to empty, and
+*   slot_release() hands it back.  slot_free() gives NULL once the other side
+*   has stopped, and slot_full() once there's nothing more coming.
+*/
+static zs_slot *slot_free( zstream *z )
+{
+    zs_slot *s = NULL;
+
+    pthread_mutex_lock( &z->lock );
+    while( z->filled - z->used == ZS_SLOTS && ! z->stop )
+        pthread_cond_wait( &z->moved, &z->lock );
+
+    if( ! z->stop )
+    {
+        s = &z->slots[ z->filled % ZS_SLOTS ];
+        s->len = s->pos = 0;
+    }
+    pthread_mutex_unlock( &z->lock );
+
+    return( s );
+}
+
+
+static void slot_publish( zstream *z )
+{
+    pthread_mutex_lock( &z->lock );
+    ++z->filled;
+    pthread_cond_broadcast( &z->moved );
+    pthread_mutex_unlock( &z->lock );
+}
+
+
+static zs_slot *slot_full( zstream *z )
+{
+    zs_slot *s = NULL;
+
+    pthread_mutex_lock( &z->lock );
+    while( z->filled == z->used && ! z->done )
+        pthread_cond_wait( &z->moved, &z->lock );
+
+    if( z->filled != z->used )
+        s = &z->slots[ z->used % ZS_SLOTS ];
+    pthread_mutex_unlock( &z->lock );
+
+    return( s );
+}
+
+
+static void slot_release( zstream *z )
+{
+    pthread_mutex_lock( &z->lock );
+    ++z->used;
+    pthread_cond_broadcast( &z->moved );
+    pthread_mutex_unlock( &z->lock );
+}
+
+
+/*  The filling side is finished (having failed, if error) */
+static void finish( zstream *z, int error )
+{
+    pthread_mutex_lock( &z->lock );
+    z->done = 1;
+    z->error |= error;
+    pthread_cond_broadcast( &z->moved );
+    pthread_mutex_unlock( &z->lock );
+}
+
+
+/*  The emptying side had a problem, and will stop when it's done */
+static void fail( zstream *z )
+{
+    pthread_mutex_lock( &z->lock );
+    z->error = 1;
+    pthread_mutex_unlock( &z->lock );
+}
+
+
+
+/*==============================================================================
+                                    PUT ALL
+--------------------------------------------------------------------------------
+*   Writes a whole buffer to a file descriptor.  Returns 0, or -1.
+*/
+static int put_all( int fd, const unsigned char *buf, size_t len )
+{
+    ssize_t done;
+
+    while( len > 0 )
+    {
+        done = write( fd, buf, len );
+        if( done < 0 && errno == EINTR )
+            continue;
+
+        if( done <= 0 )
+            return( -1 );
+
+        buf += done;
+        len -= done;
+    }
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                  DECOMPRESS
+--------------------------------------------------------------------------------
+*   Decompresses what it can of the chunk into a slot.  Sets *ended if that
+*   brings us to the end of a gzip member (or zstd frame); another can start
+*   right after it, as with 'cat a.gz b.gz'.  Returns 0, or -1 if the input
+*   isn't valid.
+*/
+static int decompress( zstream *z, zs_slot *s, int *ended )
+{
+#ifdef MUZZ_ZSTD
+    if( z->format == ZFORMAT_ZSTD )
+    {
+        ZSTD_inBuffer in = { z->in, z->inLen, z->inPos };
+        ZSTD_outBuffer out = { s->buf, ZS_BUFFER, s->len };
+        size_t left = ZSTD_decompressStream( z->dctx, &out, &in );
+
+        if( ZSTD_isError( left ))
+            return( -1 );
+
+        z->inPos = in.pos;
+        s->len = out.pos;
+        *ended = ( left == 0 );
+        return( 0 );
+    }
+#endif
+
+    int ret;
+
+    z->gz.next_in = (unsigned char *)z->in + z->inPos;
+    z->gz.avail_in = z->inLen - z->inPos;
+    z->gz.next_out = s->buf + s->len;
+    z->gz.avail_out = ZS_BUFFER - s->len;
+
+    ret = inflate( &z->gz, Z_NO_FLUSH );
+
+    z->inPos = z->inLen - z->gz.avail_in;
+    s->len = ZS_BUFFER - z->gz.avail_out;
+
+    if( ret == Z_STREAM_END )
+    {
+        *ended = 1;
+        return( inflateReset( &z->gz ) == Z_OK ? 0 : -1 );
+    }
+
+    if( ret == Z_OK )
+        *ended = 0;
+
+    return( ret == Z_OK || ret == Z_BUF_ERROR ? 0 : -1 );
+}
+
+
+
+/*==============================================================================
+                                  READ THREAD
+--------------------------------------------------------------------------------
+*   Reads the compressed input a chunk at a time (unless it's all mapped
+*   already) and decompresses it into the ring, until it runs out.  It's
+*   only a clean end if the last member (or frame) was finished.
+*/
+static void *read_thread( void *arg )
+{
+    zstream *z = arg;
+    zs_slot *s = NULL;
+    int ended = 1;
+    int full = 0;
+    ssize_t got;
+
+    for( ;; )
+    {
+        /*  Out of input (and nothing's left inside the decompressor) */
+        if( z->inPos == z->inLen && ! full )
+        {
+            if( s != NULL && s->len > 0 )
+            {
+                slot_publish( z );
+                s = NULL;
+            }
+
+            got = ( z->fd < 0 ? 0 : read( z->fd, z->chunk, ZS_CHUNK ));
+            if( got < 0 && errno == EINTR )
+                continue;
+
+            if( got <= 0 )
+            {
+                finish( z, ( got < 0 || ! ended ));
+                return( NULL );
+            }
+
+            z->in = z->chunk;
+            z->inLen = got;
+            z->inPos = 0;
+        }
+
+        if( s == NULL && ( s = slot_free( z )) == NULL )
+        {
+            finish( z, 0 );
+            return( NULL );
+        }
+
+        if( decompress( z, s, &ended ))
+        {
+            finish( z, 1 );
+            return( NULL );
+        }
+
+        /*  A full slot may have left more in the decompressor */
+        full = ( s->len == ZS_BUFFER );
+        if( full )
+        {
+            slot_publish( z );
+            s = NULL;
+        }
+    }
+}
+
+
+
+/*==============================================================================
+                                   COMPRESS
+--------------------------------------------------------------------------------
+*   Compresses len bytes and writes out whatever that gives.  With end, this
+*   is the last of it, and the stream is finished off.  Returns 0, or -1 if
+*   the write fails.
+*/
+static int compress_chunk( zstream *z, const unsigned char *buf, size_t len,
+        int end )
+{
+#ifdef MUZZ_ZSTD
+    if( z->format == ZFORMAT_ZSTD )
+    {
+        ZSTD_inBuffer in = { buf, len, 0 };
+        ZSTD_outBuffer out;
+        size_t left;
+
+        do
+        {
+            out.dst = z->chunk;
+            out.size = ZS_CHUNK;
+            out.pos = 0;
+
+            left = ZSTD_compressStream2( z->cctx, &out, &in,
+                    ( end ? ZSTD_e_end : ZSTD_e_continue ));
+            if( ZSTD_isError( left ) || put_all( z->fd, z->chunk, out.pos ))
+                return( -1 );
+        }
+        while( end ? left != 0 : in.pos < in.size );
+
+        return( 0 );
+    }
+#endif
+
+    z->gz.next_in = (unsigned char *)buf;
+    z->gz.avail_in = len;
+
+    do
+    {
+        z->gz.next_out = z->chunk;
+        z->gz.avail_out = ZS_CHUNK;
+
+        if( deflate( &z->gz, ( end ? Z_FINISH : Z_NO_FLUSH )) == Z_STREAM_ERROR
+                || put_all( z->fd, z->chunk, ZS_CHUNK - z->gz.avail_out ))
+            return( -1 );
+    }
+    while( z->gz.avail_out == 0 );
+
+    return( 0 );
+}
+
+
+
+/*==============================================================================
+                                 WRITE THREAD
+--------------------------------------------------------------------------------
+*   Compresses each slot as it's filled, then finishes the stream once the
+*   writer's done.  If a write fails, the rest is emptied without writing so
+*   the writer isn't left waiting (it finds out from zstream_write()).
+*/
+static void *write_thread( void *arg )
+{
+    zstream *z = arg;
+    int failed = 0;
+    zs_slot *s;
+
+    while(( s = slot_full( z )) != NULL )
+    {
+        if( ! failed && compress_chunk( z, s->buf, s->len, 0 ))
+        {
+            failed = 1;
+            fail( z );
+        }
+
+        slot_release( z );
+    }
+
+    if( ! failed && compress_chunk( z, NULL, 0, 1 ))
+        fail( z );
+
+    return( NULL );
+}
+
+
+
+/*==============================================================================
+                                     OPEN
+--------------------------------------------------------------------------------
+*   The parts of zstream_reader() and zstream_writer() that are the same:
+*   the stream, its buffers and its codec.  Returns NULL if we're out of
+*   memory or the format isn't supported.
+*/
+static zstream *zs_open( int fd, int format, int writing )
+{
+    zstream *z;
+    int ok;
+    int i;
+
+    if( ! zstream_supported( format ) || ( z = heap_alloc( sizeof( *z )))
+            == NULL )
+        return( NULL );
+
+    memset( z, 0, sizeof( *z ));
+    z->fd = fd;
+    z->format = format;
+    z->writing = writing;
+    pthread_mutex_init( &z->lock, NULL );
+    pthread_cond_init( &z->moved, NULL );
+
+    ok = (( z->chunk = heap_alloc( ZS_CHUNK )) != NULL );
+    for( i = 0; i < ZS_SLOTS; ++i )
+        ok &= (( z->slots[i].buf = heap_alloc( ZS_BUFFER )) != NULL );
+
+#ifdef MUZZ_ZSTD
+    if( ok && format == ZFORMAT_ZSTD && writing )
+        ok = (( z->cctx = ZSTD_createCCtx()) != NULL && ! ZSTD_isError(
+                    ZSTD_CCtx_setParameter( z->cctx, ZSTD_c_compressionLevel,
+                        ZS_ZSTD_LEVEL )));
+
+    else if( ok && format == ZFORMAT_ZSTD )
+        ok = (( z->dctx = ZSTD_createDCtx()) != NULL );
+#endif
+
+    /*  gzip only, not zlib:  15 bits of window, plus 16 for the wrapper */
+    if( ok && format == ZFORMAT_GZIP )
+    {
+        ok = ( writing ? deflateInit2( &z->gz, ZS_GZIP_LEVEL, Z_DEFLATED,
+                    15 + 16, 8, Z_DEFAULT_STRATEGY )
+                : inflateInit2( &z->gz, 15 + 16 )) == Z_OK;
+        z->gzReady = ok;
+    }
+
+    if( ! ok )
+    {
+        zstream_close( z );
+        return( NULL );
+    }
+
+    return( z );
+}
+
+
+
+/*==============================================================================
+                                    READER
+--------------------------------------------------------------------------------
+*   See zstream.h.
+*/
+zstream *zstream_reader( int fd, int format, const void *head,
+        size_t headLen )
+{
+    zstream *z = zs_open( fd, format, 0 );
+
+    if( z == NULL )
+        return( NULL );
+
+    memcpy( z->chunk, head, headLen );
+    z->in = z->chunk;
+    z->inLen = headLen;
+
+    if( pthread_create( &z->thread, NULL, read_thread, z ) != 0 )
+    {
+        zstream_close( z );
+        return( NULL );
+    }
+
+    z->started = 1;
+    return( z );
+}
+
+
+zstream *zstream_map_reader( const void *data, size_t len, int format )
+{
+    zstream *z = zs_open( -1, format, 0 );
+
+    if( z == NULL )
+        return( NULL );
+
+    z->in = data;
+    z->inLen = len;
+
+    if( pthread_create( &z->thread, NULL, read_thread, z ) != 0 )
+    {
+        zstream_close( z );
+        return( NULL );
+    }
+
+    z->started = 1;
+    return( z );
+}
+
+
+ssize_t zstream_read( zstream *z, void *buf, size_t len )
+{
+    zs_slot *s = z->current;
+    size_t n;
+
+    if( s == NULL && ( s = slot_full( z )) == NULL )
+        return( z->error ? -1 : 0 );
+
+    n = ( len < s->len - s->pos ? len : s->len - s->pos );
+    memcpy( buf, s->buf + s->pos, n );
+    s->pos += n;
+
+    z->current = s;
+    if( s->pos == s->len )
+    {
+        slot_release( z );
+        z->current = NULL;
+    }
+
+    return( n );
+}
+
+
+
+/*==============================================================================
+                                    WRITER
+--------------------------------------------------------------------------------
+*   See zstream.h.
+*/
+zstream *zstream_writer( int fd, int format )
+{
+    zstream *z = zs_open( fd, format, 1 );
+
+    if( z == NULL )
+        return( NULL );
+
+    if( pthread_create( &z->thread, NULL, write_thread, z ) != 0 )
+    {
+        zstream_close( z );
+        return( NULL );
+    }
+
+    z->started = 1;
+    return( z );
+}
+
+
+int zstream_write( zstream *z, const void *buf, size_t len )
+{
+    const unsigned char *p = buf;
+    size_t n;
+
+    while( len > 0 )
+    {
+        if( z->current == NULL && ( z->current = slot_free( z )) == NULL )
+            return( -1 );
+
+        n = ZS_BUFFER - z->current->len;
+        n = ( len < n ? len : n );
+        memcpy( z->current->buf + z->current->len, p, n );
+        z->current->len += n;
+        p += n;
+        len -= n;
+
+        if( z->current->len == ZS_BUFFER )
+        {
+            slot_publish( z );
+            z->current = NULL;
+        }
+    }
+
+    pthread_mutex_lock( &z->lock );
+    n = z->error;
+    pthread_mutex_unlock( &z->lock );
+
+    return( n ? -1 : 0 );
+}
+
+
+
+/*==============================================================================
+                                     CLOSE
+--------------------------------------------------------------------------------
+*   See zstream.h.
+*/
+int zstream_close( zstream *z )
+{
+    int error;
+    int i;
+
+    if( z->started && z->writing )
+    {
+        if( z->current != NULL && z->current->len > 0 )
+            slot_publish( z );
+        finish( z, 0 );
+        pthread_join( z->thread, NULL );
+    }
+
+    else if( z->started )
+    {
+        pthread_mutex_lock( &z->lock );
+        z->stop = 1;
+        pthread_cond_broadcast( &z->moved );
+        pthread_mutex_unlock( &z->lock );
+        pthread_join( z->thread, NULL );
+    }
+
+    if( z->gzReady )
+    {
+        if( z->writing )
+            deflateEnd( &z->gz );
+        else
+            inflateEnd( &z->gz );
+    }
+
+#ifdef MUZZ_ZSTD
+    ZSTD_freeCCtx( z->cctx );
+    ZSTD_freeDCtx( z->dctx );
+#endif
+
+    for( i = 0; i < ZS_SLOTS; ++i )
+        heap_free( z->slots[i].buf );
+    heap_free( z->chunk );
+
+    error = z->error;
+    pthread_mutex_destroy( &z->lock );
+    pthread_cond_destroy( &z->moved );
+    heap_free( z );
+
+    return( error ? -1 : 0 );
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ *  zstream.h   |   version 1.02    |   zlib license    |   2026-10-14
+ *  James Hendrie                   |   hendrie.james@gmail.com
+ *  ----------------------------------------------------------------------------
+ *
+ *  Compressed input and output for batch mode.  A zstream is a file
+ *  descriptor with gzip (or zstd) in between, and a thread of its own doing
+ *  the work:  reading, it decompresses ahead of whoever's reading it, and
+ *  writing, it compresses behind whoever's writing, so the (de)compression
+ *  overlaps with everything else instead of taking turns with it.
+ *
+ ******************************************************************************/
+#ifndef MUZZ_ZSTREAM_H
+#define MUZZ_ZSTREAM_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+
+/*  What's in between */
+enum ZFormat {
+    ZFORMAT_NONE,
+    ZFORMAT_GZIP,
+    ZFORMAT_ZSTD
+};
+
+/*  Bytes zstream_detect() needs to tell them apart */
+#define ZFORMAT_MAGIC 4
+
+
+typedef struct zstream zstream;
+
+
+/*
+ *  What the first len bytes of a file say it is, by their magic number:
+ *  ZFORMAT_GZIP, ZFORMAT_ZSTD, or ZFORMAT_NONE.  Returns -1 if len is too
+ *  short to say yet, but what there is could be the start of one.
+ */
+int zstream_detect( const void *head, size_t len );
+
+/*  The format called name ("gzip" or "zstd"), or -1 */
+int zstream_format( const char *name );
+
+/*  Whether this build can handle a format (zstd is optional) */
+int zstream_supported( int format );
+
+/*  A format's name, for messages */
+const char *zstream_name( int format );
+
+
+/*
+ *  Starts decompressing fd in the background.  The first headLen bytes of
+ *  it have already been read, into head.  Returns NULL if we're out of
+ *  memory or the format isn't supported.
+ */
+zstream *zstream_reader( int fd, int format, const void *head,
+        size_t headLen );
+
+/*
+ *  The same, for a file that's mapped (or otherwise all in memory) so it
+ *  needn't be read at all.  data has to stay where it is until the stream
+ *  is closed.
+ */
+zstream *zstream_map_reader( const void *data, size_t len, int format );
+
+/*
+ *  Up to len bytes of what's been decompressed, as read() would:  as much
+ *  as is ready, waiting only if nothing is.  Returns how many, 0 at the
+ *  end, or -1 if the input couldn't be read or isn't valid.
+ */
+ssize_t zstream_read( zstream *z, void *buf, size_t len );
+
+
+/*
+ *  Starts compressing into fd in the background.  Returns NULL if we're
+ *  out of memory or the format isn't supported.
+ */
+zstream *zstream_writer( int fd, int format );
+
+/*  Queues len bytes to be compressed.  Returns 0, or -1 if writing failed. */
+int zstream_write( zstream *z, const void *buf, size_t len );
+
+
+/*
+ *  Finishes up:  a writer compresses and writes the rest, a reader drops
+ *  whatever's unread.  Then frees the stream.  Returns 0, or -1 if anything
+ *  went wrong along the way.
+ */
+int zstream_close( zstream *z );
+
+#endif